@@ -0,0 +1,189 @@
+/* Spell Checking Engine
+ * Copyright (c) 2008 Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ *
+ * Times find and approximate_find on a trie_map whose working set is
+ * well above the last level cache, so that the walks miss the cache the
+ * way they do on a large dictionary. The words are made up from a fixed
+ * seed, so a run can be repeated; build it once as is and once with
+ * ASCENS_NO_PREFETCH defined to see what the prefetches buy.
+ *
+ * usage: Ascens.Bench [-n words] [-s seed] [-c]
+ *
+ *     -n  how many words to insert (4000000)
+ *     -s  the seed the words are made from (1)
+ *     -c  compact the trie before timing it
+ */
+
+#pragma warning(disable: 4786) //identifier was truncated to '255' characters in the browser information
+
+#include "trie_map"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+typedef trie::trie_map<std::string, unsigned int> word_map;
+
+static int Usage()
+{
+  std::cerr << "usage: Ascens.Bench [-n words] [-s seed] [-c]" << std::endl;
+  return 2;
+}
+
+// a linear congruential generator, so the words are the same on every
+// platform for a given seed (rand() isn't)
+class Random
+{
+public:
+  Random(unsigned long seed) : state_(seed) {}
+
+  unsigned long Next(unsigned long n)
+  {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<unsigned long>((state_ >> 33) % n);
+  }
+
+private:
+  unsigned long long state_;
+};
+
+static std::string MakeWord(Random& random)
+{
+  std::string word(4 + random.Next(12), 'a');
+  for(std::string::iterator it = word.begin(); it != word.end(); ++it) {
+    *it = static_cast<char>('a' + random.Next(26));
+  }
+  return word;
+}
+
+// counts the key nodes as the trie is walked: each word adds a node for
+// every letter past the prefix it shares with the word before it
+class KeyNodeCounter
+{
+public:
+  KeyNodeCounter() : cKeyNodes_(0) {}
+
+  void operator()(const char* first, const char* last, const word_map::value_type&)
+  {
+    std::string word(first, last);
+    size_t cShared = 0;
+    while(cShared < word.size() && cShared < previous_.size() && word[cShared] == previous_[cShared]) {
+      ++cShared;
+    }
+    cKeyNodes_ += word.size() - cShared;
+    previous_.swap(word);
+  }
+
+  size_t KeyNodes() const
+  {
+    return cKeyNodes_;
+  }
+
+private:
+  std::string previous_;
+  size_t cKeyNodes_;
+};
+
+static double Seconds(std::clock_t start)
+{
+  return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t cWords = 4000000;
+  unsigned long seed = 1;
+  bool fCompact = false;
+
+  for(int iArg = 1; iArg < argc; ++iArg) {
+    if(std::strcmp(argv[iArg], "-c") == 0) {
+      fCompact = true;
+    }
+    else if(iArg + 1 < argc && std::strcmp(argv[iArg], "-n") == 0) {
+      cWords = static_cast<size_t>(std::atol(argv[++iArg]));
+    }
+    else if(iArg + 1 < argc && std::strcmp(argv[iArg], "-s") == 0) {
+      seed = static_cast<unsigned long>(std::atol(argv[++iArg]));
+    }
+    else {
+      return Usage();
+    }
+  }
+
+  // the words are inserted in the order they are made, so neighbouring
+  // nodes aren't neighbours in memory unless the trie is compacted
+  Random random(seed);
+  std::vector<std::string> words;
+  words.reserve(cWords);
+  word_map dictionary;
+  for(size_t i = 0; i < cWords; ++i) {
+    words.push_back(MakeWord(random));
+    dictionary.insert(word_map::value_type(words.back(), static_cast<unsigned int>(i)));
+  }
+  if(fCompact) {
+    dictionary.compact();
+  }
+
+  // the words that aren't there are made the same way, so most share a
+  // long prefix with some word that is
+  std::vector<std::string> misses;
+  misses.reserve(cWords);
+  while(misses.size() < cWords) {
+    std::string word(MakeWord(random));
+    if(dictionary.find(word) == dictionary.end()) {
+      misses.push_back(word);
+    }
+  }
+  // and they are looked up in another order than they went in
+  for(size_t i = words.size(); i > 1; --i) {
+    std::swap(words[i - 1], words[random.Next(static_cast<unsigned long>(i))]);
+  }
+
+  size_t cKeyNodes = dictionary.for_each(KeyNodeCounter()).KeyNodes();
+  size_t cbWorkingSet = cKeyNodes * sizeof(trie::_b_trie_key_node<char>)
+                      + dictionary.size() * sizeof(trie::_b_trie_value_node<word_map::value_type>);
+  std::cout << dictionary.size() << " words, " << cKeyNodes << " key nodes, about "
+            << cbWorkingSet / (1024 * 1024) << " MB of nodes"
+#if defined(ASCENS_NO_PREFETCH)
+            << ", without prefetching"
+#endif
+            << std::endl;
+
+  // summed so that the lookups can't be left out
+  size_t cFound = 0;
+
+  std::clock_t start = std::clock();
+  for(std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
+    cFound += dictionary.find(*it) != dictionary.end();
+  }
+  std::cout << "find (present):  " << Seconds(start) << " s" << std::endl;
+
+  start = std::clock();
+  for(std::vector<std::string>::const_iterator it = misses.begin(); it != misses.end(); ++it) {
+    cFound += dictionary.find(*it) != dictionary.end();
+  }
+  std::cout << "find (absent):   " << Seconds(start) << " s" << std::endl;
+
+  // an edit distance walk visits far more nodes than a find, so fewer are
+  // asked for
+  size_t cApproximate = std::min<size_t>(words.size(), 1000);
+  start = std::clock();
+  for(size_t i = 0; i < cApproximate; ++i) {
+    cFound += dictionary.approximate_find(words[i], 1).size();
+  }
+  std::cout << "approximate_find (k = 1, " << cApproximate << " words): " << Seconds(start) << " s" << std::endl;
+
+  return cFound == 0;
+}
@@ -0,0 +1,76 @@
+/* Spell Checking Engine
+ * Copyright (c) 2008 Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ *
+ * Reports the near-duplicate words within a dictionary or between two
+ * dictionaries, one pair per line as UTF-8:
+ *
+ *     word<TAB>other word<TAB>distance
+ *
+ * usage: Ascens.Join [-k distance] dictionary [other-dictionary]
+ */
+
+#pragma warning(disable: 4786) //identifier was truncated to '255' characters in the browser information
+
+#include "SpellDictionary.h"
+#include "LineDictionaryFile.h"
+#include "Convert.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+static int Usage()
+{
+  std::cerr << "usage: Ascens.Join [-k distance] dictionary [other-dictionary]" << std::endl;
+  return 2;
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned short nDistance = 1;
+  int iArg = 1;
+
+  if(iArg + 1 < argc && std::strcmp(argv[iArg], "-k") == 0) {
+    nDistance = static_cast<unsigned short>(std::atoi(argv[iArg + 1]));
+    iArg += 2;
+  }
+  if(argc - iArg != 1 && argc - iArg != 2) {
+    return Usage();
+  }
+
+  SpellDictionary dictionary;
+  SpellDictionary otherDictionary;
+  try{
+    dictionary.Load(new LineDictionaryFile(std::string(argv[iArg])));
+    if(argc - iArg == 2) {
+      otherDictionary.Load(new LineDictionaryFile(std::string(argv[iArg + 1])));
+    }
+  }
+  catch(...)
+  {
+    std::cerr << "could not load the dictionaries" << std::endl;
+    return 1;
+  }
+
+  std::vector<SpellDictionary::WordPair> rgPairs = 
+      dictionary.GetNearDuplicates((argc - iArg == 2) ? otherDictionary : dictionary, nDistance);
+
+  for(std::vector<SpellDictionary::WordPair>::const_iterator it = rgPairs.begin();
+      it != rgPairs.end();
+      ++it)
+  {
+    std::cout << Convert::ToUtf8(it->strWord) << '\t' 
+              << Convert::ToUtf8(it->strOtherWord) << '\t' 
+              << it->nDistance << std::endl;
+  }
+
+  return 0;
+}
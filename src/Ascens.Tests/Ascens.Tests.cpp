@@ -219,6 +219,95 @@ TEST_FIXTURE(DictionaryTestFixture, GetSuggestionsFromWord_MultipleSuggestions_S
   }
 }
 
+TEST_FIXTURE(DictionaryTestFixture, GetSuggestionsFromWord_WordsHaveFrequencies_MostFrequentFirst)
+{
+  std::vector<const std::wstring> sWords;
+  sWords.push_back(std::wstring(L"cat\t5"));
+  sWords.push_back(std::wstring(L"hat\t50"));
+  sWords.push_back(std::wstring(L"bat\t7"));
+  sWords.push_back(std::wstring(L"tot"));
+
+  ExternalAddWordsToDictionary(sWords);
+
+  std::wstring s(L"tat");
+  const size_t cchBuffer = 4096;
+  wchar_t szBuffer[cchBuffer];
+  CHECK(GetSuggestionsFromWord(hDictionary, s.c_str(), s.size(), szBuffer, cchBuffer));
+
+  std::vector<const std::wstring> sSuggestions;
+  for(size_t i=0; szBuffer[i] != L'\0'; ++i){
+    std::wstring sSuggestion(&szBuffer[i]);
+    sSuggestions.push_back(sSuggestion);
+    i+= sSuggestion.size();
+  }
+
+  CHECK_EQUAL(sWords.size(), sSuggestions.size());
+  CHECK(sSuggestions[0] == L"hat");
+  CHECK(sSuggestions[1] == L"bat");
+  CHECK(sSuggestions[2] == L"cat");
+  CHECK(sSuggestions[3] == L"tot");
+}
+
+TEST_FIXTURE(DictionaryTestFixture, AddWordToDictionary_WordsHaveFrequencies_FrequenciesKept)
+{
+  std::vector<const std::wstring> sWords;
+  sWords.push_back(std::wstring(L"cat\t5"));
+  sWords.push_back(std::wstring(L"hat\t50"));
+
+  ExternalAddWordsToDictionary(sWords);
+
+  std::wstring sNewWord(L"bat");
+  CHECK(AddWordToDictionary(hDictionary, sNewWord.c_str(), sNewWord.size()));
+
+  // the frequencies must have been saved with the new word, not just kept in memory
+  UnloadDictionary(hDictionary);
+  hDictionary = LoadDictionary(szDictionaryFileName);
+
+  std::wstring s(L"tat");
+  const size_t cchBuffer = 4096;
+  wchar_t szBuffer[cchBuffer];
+  CHECK(GetSuggestionsFromWord(hDictionary, s.c_str(), s.size(), szBuffer, cchBuffer));
+
+  std::vector<const std::wstring> sSuggestions;
+  for(size_t i=0; szBuffer[i] != L'\0'; ++i){
+    std::wstring sSuggestion(&szBuffer[i]);
+    sSuggestions.push_back(sSuggestion);
+    i+= sSuggestion.size();
+  }
+
+  CHECK_EQUAL(static_cast<std::vector<std::wstring>::size_type>(3),
+              sSuggestions.size());
+  CHECK(sSuggestions[0] == L"hat");
+  CHECK(sSuggestions[1] == L"cat");
+  CHECK(sSuggestions[2] == L"bat");
+}
+
+TEST_FIXTURE(DictionaryTestFixture, AddWordToDictionary_FrequencyTooLarge_FrequencySaturated)
+{
+  std::vector<const std::wstring> sWords;
+  sWords.push_back(std::wstring(L"cat\t99999999999")); // 1215752191 if it wrapped
+  sWords.push_back(std::wstring(L"hat\t2000000000"));
+
+  ExternalAddWordsToDictionary(sWords);
+
+  std::wstring s(L"tat");
+  const size_t cchBuffer = 4096;
+  wchar_t szBuffer[cchBuffer];
+  CHECK(GetSuggestionsFromWord(hDictionary, s.c_str(), s.size(), szBuffer, cchBuffer));
+
+  std::vector<const std::wstring> sSuggestions;
+  for(size_t i=0; szBuffer[i] != L'\0'; ++i){
+    std::wstring sSuggestion(&szBuffer[i]);
+    sSuggestions.push_back(sSuggestion);
+    i+= sSuggestion.size();
+  }
+
+  CHECK_EQUAL(static_cast<std::vector<std::wstring>::size_type>(2),
+              sSuggestions.size());
+  CHECK(sSuggestions[0] == L"cat");
+  CHECK(sSuggestions[1] == L"hat");
+}
+
 TEST_FIXTURE(DictionaryTestFixture, GetSuggestionsFromWord_NullWord_NotSuccessful)
 {
   const size_t cchBuffer = 4096;
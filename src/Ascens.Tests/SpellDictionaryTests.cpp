@@ -0,0 +1,955 @@
+#include <UnitTest++.h>
+#include "SpellDictionary.h"
+#include "LineDictionaryFile.h"
+#include "Convert.h"
+#include <io.h>
+#include <string>
+#include <vector>
+
+struct SpellDictionaryTestFixture{
+  //Setup
+  SpellDictionaryTestFixture()
+  {
+      sDictionaryFileName_ = CreateTempFile();
+  }
+
+  //Teardown
+  ~SpellDictionaryTestFixture()
+  {
+      g_remove(sDictionaryFileName_.c_str());
+  }
+
+  static std::string CreateTempFile()
+  {
+      gchar * szFileName;
+      gint handle = g_file_open_tmp(NULL, &szFileName, NULL);
+      std::string sFileName(szFileName);
+      g_free(szFileName);
+      _close(handle);
+      return sFileName;
+  }
+
+  // a line for each word, which may be followed by a tab and its frequency
+  static void WriteWords(const std::string& sFileName, const std::vector<const std::string>& sWords)
+  {
+      FILE* handle = g_fopen(sFileName.c_str(), "wb");
+      for(std::vector<const std::string>::const_iterator itWord = sWords.begin();
+          itWord != sWords.end();
+          ++itWord)
+      {
+          fputs(itWord->c_str(), handle);
+          fputs("\n", handle);
+      }
+      fclose(handle);
+  }
+
+  void LoadWords(const std::vector<const std::string>& sWords)
+  {
+      WriteWords(sDictionaryFileName_, sWords);
+      dictionary_.Load(new LineDictionaryFile(sDictionaryFileName_));
+  }
+
+  // the results, separated by '|'
+  static std::string Join(const std::vector<const std::string>& sResults)
+  {
+      std::string s;
+      for(std::vector<const std::string>::const_iterator it = sResults.begin();
+          it != sResults.end();
+          ++it)
+      {
+          if(it != sResults.begin())
+          {
+              s += '|';
+          }
+          s += *it;
+      }
+      return s;
+  }
+
+  SpellDictionary dictionary_;
+  std::string sDictionaryFileName_;
+};
+
+//// GetCompletions
+TEST_FIXTURE(SpellDictionaryTestFixture, GetCompletions_WordsHaveFrequencies_MostFrequentFirst)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat\t5");
+  sWords.push_back("car\t50");
+  sWords.push_back("cart\t10");
+  sWords.push_back("cast\t1");
+  sWords.push_back("dog\t100");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("car|cart", Join(dictionary_.GetCompletionsUtf8("ca", 2)));
+  CHECK_EQUAL("car|cart|cat|cast", Join(dictionary_.GetCompletionsUtf8("ca", 10)));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetCompletions_PrefixIsWord_WordIncluded)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("car\t1");
+  sWords.push_back("cart\t2");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("cart|car", Join(dictionary_.GetCompletionsUtf8("car", 5)));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetCompletions_EqualFrequencies_InOrder)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("dc\t1");
+  sWords.push_back("dac\t1");
+  sWords.push_back("dog\t1");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("dac|dc", Join(dictionary_.GetCompletionsUtf8("d", 2)));
+  CHECK_EQUAL("dac|dc|dog", Join(dictionary_.GetCompletionsUtf8("", 5)));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetCompletions_NoWordHasPrefix_None)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+
+  CHECK(dictionary_.GetCompletionsUtf8("x", 5).empty());
+  CHECK(dictionary_.GetCompletionsUtf8("cats", 5).empty());
+  CHECK(dictionary_.GetCompletionsUtf8("ca", 0).empty());
+}
+
+//// GetWordId, GetWordFromId and GetEntryCountWithPrefix
+TEST_FIXTURE(SpellDictionaryTestFixture, GetWordId_Words_DenseIdsInOrder)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("dog");
+  sWords.push_back("cat");
+  sWords.push_back("cart");
+  LoadWords(sWords);
+
+  CHECK_EQUAL(0u, dictionary_.GetWordId(Convert::ToUcs4("cart")));
+  CHECK_EQUAL(1u, dictionary_.GetWordId(Convert::ToUcs4("cat")));
+  CHECK_EQUAL(2u, dictionary_.GetWordId(Convert::ToUcs4("dog")));
+  for(size_t id = 0; id != dictionary_.GetEntryCount(); ++id)
+  {
+      CHECK_EQUAL(id, dictionary_.GetWordId(dictionary_.GetWordFromId(id)));
+  }
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetWordId_NotPresent_Minus1)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  LoadWords(sWords);
+
+  CHECK_EQUAL(static_cast<size_t>(-1), dictionary_.GetWordId(Convert::ToUcs4("ca")));
+  CHECK(dictionary_.GetWordFromId(1).empty());
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetWordId_WordAdded_IdsMove)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+
+  dictionary_.AddWordUtf8("cab");
+  CHECK_EQUAL(0u, dictionary_.GetWordId(Convert::ToUcs4("cab")));
+  CHECK_EQUAL(2u, dictionary_.GetWordId(Convert::ToUcs4("dog")));
+  CHECK(dictionary_.GetWordFromId(1) == Convert::ToUcs4("cat"));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetEntryCountWithPrefix_Prefix_WordsWithPrefix)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  sWords.push_back("cart");
+  sWords.push_back("car");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+
+  CHECK_EQUAL(4u, dictionary_.GetEntryCount());
+  CHECK_EQUAL(3u, dictionary_.GetEntryCountWithPrefix(Convert::ToUcs4("ca")));
+  CHECK_EQUAL(2u, dictionary_.GetEntryCountWithPrefix(Convert::ToUcs4("car")));
+  CHECK_EQUAL(0u, dictionary_.GetEntryCountWithPrefix(Convert::ToUcs4("x")));
+}
+
+//// Compounds
+struct CompoundTestFixture : public SpellDictionaryTestFixture{
+  //Setup
+  CompoundTestFixture()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("arbeit");
+      sWords.push_back("amt");
+      sWords.push_back("haus");
+      sWords.push_back("tor");
+      sWords.push_back("to");
+      LoadWords(sWords);
+  }
+};
+
+TEST_FIXTURE(CompoundTestFixture, IsWordPresent_CompoundsOff_CompoundNotPresent)
+{
+  CHECK(dictionary_.IsWordPresentUtf8("haus"));
+  CHECK(!dictionary_.IsWordPresentUtf8("haustor"));
+}
+
+TEST_FIXTURE(CompoundTestFixture, IsWordPresent_TwoParts_CompoundPresent)
+{
+  dictionary_.SetCompoundMaxParts(2);
+  CHECK(dictionary_.IsWordPresentUtf8("haustor"));
+  CHECK(dictionary_.IsWordPresentUtf8("amthaus"));
+  CHECK(!dictionary_.IsWordPresentUtf8("haustoramt"));
+  CHECK(!dictionary_.IsWordPresentUtf8("hausto"));  // "to" is too short a part
+  CHECK(!dictionary_.IsWordPresentUtf8("haustorx"));
+}
+
+TEST_FIXTURE(CompoundTestFixture, IsWordPresent_ThreeParts_CompoundPresent)
+{
+  dictionary_.SetCompoundMaxParts(3);
+  CHECK(dictionary_.IsWordPresentUtf8("haustoramt"));
+  CHECK(!dictionary_.IsWordPresentUtf8("haustoramthaus"));
+}
+
+TEST_FIXTURE(CompoundTestFixture, IsWordPresent_PartsTooShort_CompoundNotPresent)
+{
+  dictionary_.SetCompoundMaxParts(2);
+  dictionary_.SetCompoundMinPartLength(4);
+  CHECK(!dictionary_.IsWordPresentUtf8("haustor"));
+  CHECK(dictionary_.IsWordPresentUtf8("haushaus"));
+  dictionary_.SetCompoundMinPartLength(2);
+  CHECK(dictionary_.IsWordPresentUtf8("hausto"));
+}
+
+TEST_FIXTURE(CompoundTestFixture, IsWordPresent_LinkingMorpheme_CompoundPresent)
+{
+  dictionary_.SetCompoundMaxParts(2);
+  CHECK(!dictionary_.IsWordPresentUtf8("arbeitsamt"));
+
+  std::vector<const std::basic_string<gunichar> > rgstrMorphemes;
+  rgstrMorphemes.push_back(Convert::ToUcs4("s"));
+  dictionary_.SetCompoundLinkingMorphemes(rgstrMorphemes);
+  CHECK(dictionary_.IsWordPresentUtf8("arbeitsamt"));
+  CHECK(!dictionary_.IsWordPresentUtf8("arbeitssamt"));
+  CHECK(!dictionary_.IsWordPresentUtf8("arbeits")); // it only joins two parts
+}
+
+//// GetSuggestionsFromWord
+TEST_FIXTURE(SpellDictionaryTestFixture, GetSuggestionsFromWord_RunTogetherWords_SplitFirst)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("cat dog|cat|dog", Join(dictionary_.GetSuggestionsFromWordUtf8("catdog")));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetSuggestionsFromWord_SeveralSplits_ShortestFirstPartFirst)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("the");
+  sWords.push_back("there");
+  sWords.push_back("rein");
+  sWords.push_back("in");
+  LoadWords(sWords);
+  dictionary_.SetSuggestionErrorTolerance(1);
+  dictionary_.SetSuggestionBestErrorTolerance(1);
+
+  CHECK_EQUAL("the rein|there in", Join(dictionary_.GetSuggestionsFromWordUtf8("therein")));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetSuggestionsFromWord_RestNotWord_NoSplit)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("cat");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+  dictionary_.SetSuggestionErrorTolerance(0);
+  dictionary_.SetSuggestionBestErrorTolerance(0);
+
+  CHECK(dictionary_.GetSuggestionsFromWordUtf8("catdogx").empty());
+  CHECK(dictionary_.GetSuggestionsFromWordUtf8("cat").size() == 1); // itself, not split
+}
+
+//// SegmentText
+TEST_FIXTURE(SpellDictionaryTestFixture, SegmentText_MaximalMatching_FewestWords)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("go");
+  sWords.push_back("od");
+  sWords.push_back("good");
+  sWords.push_back("mor");
+  sWords.push_back("ning");
+  sWords.push_back("morning");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("good|morning", Join(dictionary_.SegmentTextUtf8("goodmorning")));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, SegmentText_UnknownCharacters_OneSegment)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("good");
+  sWords.push_back("morning");
+  LoadWords(sWords);
+
+  CHECK_EQUAL("good|xyz|morning", Join(dictionary_.SegmentTextUtf8("goodxyzmorning")));
+  CHECK_EQUAL("xyz|good", Join(dictionary_.SegmentTextUtf8("xyzgood")));
+  CHECK_EQUAL("xyz", Join(dictionary_.SegmentTextUtf8("xyz")));
+  CHECK(dictionary_.SegmentTextUtf8("").empty());
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, SegmentText_FrequencyWeighted_MostProbableWords)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("ab\t1");
+  sWords.push_back("cd\t1");
+  sWords.push_back("abc\t1000");
+  sWords.push_back("d\t1000");
+  LoadWords(sWords);
+
+  dictionary_.SetSegmentationMode(SpellDictionary::FrequencyWeighted);
+  CHECK_EQUAL("abc|d", Join(dictionary_.SegmentTextUtf8("abcd")));
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, SegmentText_FrequencyWeighted_FewestUnknownFirst)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("ab\t1000");
+  sWords.push_back("abc\t1");
+  sWords.push_back("cd\t1");
+  LoadWords(sWords);
+
+  dictionary_.SetSegmentationMode(SpellDictionary::FrequencyWeighted);
+  CHECK_EQUAL("ab|cd", Join(dictionary_.SegmentTextUtf8("abcd")));
+}
+
+//// GetWordsMatchingPattern
+// the words found are normalized (NFD), so é is given as e and U+0301
+struct PatternTestFixture : public SpellDictionaryTestFixture{
+  //Setup
+  PatternTestFixture()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("cafe");
+      sWords.push_back("caf\xc3\xa9");   // café
+      sWords.push_back("cafes");
+      sWords.push_back("calf");
+      LoadWords(sWords);
+  }
+};
+
+TEST_FIXTURE(PatternTestFixture, GetWordsMatchingPattern_Wildcards_WordsInOrder)
+{
+  CHECK_EQUAL("cafes", Join(dictionary_.GetWordsMatchingPatternUtf8("caf*s*")));
+  CHECK_EQUAL("cafe|calf", Join(dictionary_.GetWordsMatchingPatternUtf8("ca??")));
+  CHECK_EQUAL("cafe|cafes|calf", Join(dictionary_.GetWordsMatchingPatternUtf8("ca[a-z]*[^\xcc\x81]")));
+}
+
+TEST_FIXTURE(PatternTestFixture, GetWordsMatchingPattern_ClassAtEitherEnd_WordsInOrder)
+{
+  CHECK_EQUAL("cafe|calf", Join(dictionary_.GetWordsMatchingPatternUtf8("[bc]a??")));
+  CHECK_EQUAL("cafe|cafes|cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf[es]*")));
+  CHECK_EQUAL("cafe|calf", Join(dictionary_.GetWordsMatchingPatternUtf8("[c][a][fl][ef]")));
+}
+
+TEST_FIXTURE(PatternTestFixture, GetWordsMatchingPattern_ComposedLiteral_DecomposedWord)
+{
+  CHECK_EQUAL("cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf\xc3\xa9")));
+  CHECK_EQUAL("cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("c*\xc3\xa9")));
+  // the combining acute on its own
+  CHECK_EQUAL("cafes|cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf??")));
+}
+
+TEST_FIXTURE(PatternTestFixture, GetWordsMatchingPattern_ComposedClassMember_MatchedWhole)
+{
+  CHECK_EQUAL("cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf[\xc3\xa9]")));
+  CHECK_EQUAL("cafe|cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf[e\xc3\xa9]")));
+  CHECK_EQUAL("cafe|cafes|cafe\xcc\x81", Join(dictionary_.GetWordsMatchingPatternUtf8("caf[\xc3\xa9" "e]*")));
+}
+
+TEST_FIXTURE(PatternTestFixture, GetWordsMatchingPattern_NegatedComposedClassMember_OtherCharacters)
+{
+  CHECK_EQUAL("cafe", Join(dictionary_.GetWordsMatchingPatternUtf8("caf[^\xc3\xa9]")));
+  CHECK_EQUAL("calf", Join(dictionary_.GetWordsMatchingPatternUtf8("ca[^\xc3\xa9" "f]?")));
+}
+
+//// the UTF-8 index
+struct Utf8IndexTestFixture : public SpellDictionaryTestFixture{
+  //Setup
+  Utf8IndexTestFixture()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("a\xc3\xb1o\t5");        // año
+      sWords.push_back("ma\xc3\xb1ana\t3");     // mañana
+      sWords.push_back("\xc3\xbc" "ber\t2");    // über
+      sWords.push_back("cafe\t9");
+      sWords.push_back("caf\xc3\xa9\t4");       // café
+      sWords.push_back("\xe2\x98\x83\t1");     // a snowman, three bytes
+      sWords.push_back("cat\t7");
+      LoadWords(sWords);
+      dictionary_.SetSuggestionErrorTolerance(1);
+      dictionary_.SetSuggestionBestErrorTolerance(4);
+      dictionary_.SetMaxSuggestions(15);
+  }
+
+  // words looked up, in and out of the dictionary and composed or not
+  static std::vector<const std::string> Lookups()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("a\xc3\xb1o");
+      sWords.push_back("an\xcc\x83o");
+      sWords.push_back("ano");
+      sWords.push_back("anyo");
+      sWords.push_back("a\xc3\xb1os");
+      sWords.push_back("manana");
+      sWords.push_back("ma\xc3\xb1ana");
+      sWords.push_back("uber");
+      sWords.push_back("\xc3\xbc" "ber");
+      sWords.push_back("caf\xc3\xa9");
+      sWords.push_back("caf\xc3\xa8");
+      sWords.push_back("cafes");
+      sWords.push_back("\xe2\x98\x83");
+      sWords.push_back("\xe2\x98\x84");
+      sWords.push_back("cat");
+      sWords.push_back("cta");
+      sWords.push_back("dog");
+      sWords.push_back("");
+      return sWords;
+  }
+};
+
+TEST_FIXTURE(Utf8IndexTestFixture, IsWordPresentUtf8_Index_SameAsUcs4)
+{
+  std::vector<const std::string> sWords = Lookups();
+  for(std::vector<const std::string>::const_iterator it = sWords.begin(); it != sWords.end(); ++it)
+  {
+      dictionary_.SetUseUtf8Index(false);
+      const bool fPresent = dictionary_.IsWordPresentUtf8(*it);
+      dictionary_.SetUseUtf8Index(true);
+      CHECK_EQUAL(fPresent, dictionary_.IsWordPresentUtf8(*it));
+  }
+  CHECK(dictionary_.IsWordPresentUtf8("an\xcc\x83o"));
+  CHECK(!dictionary_.IsWordPresentUtf8("ano"));
+}
+
+TEST_FIXTURE(Utf8IndexTestFixture, GetSuggestionsFromWordUtf8_Index_SameAsUcs4)
+{
+  std::vector<const std::string> sWords = Lookups();
+  for(std::vector<const std::string>::const_iterator it = sWords.begin(); it != sWords.end(); ++it)
+  {
+      dictionary_.SetUseUtf8Index(false);
+      const std::string sSuggestions = Join(dictionary_.GetSuggestionsFromWordUtf8(*it));
+      dictionary_.SetUseUtf8Index(true);
+      CHECK_EQUAL(sSuggestions, Join(dictionary_.GetSuggestionsFromWordUtf8(*it)));
+  }
+}
+
+TEST_FIXTURE(Utf8IndexTestFixture, GetSuggestionsFromWordUtf8_Index_EditsCountedPerCharacter)
+{
+  dictionary_.SetUseUtf8Index(true);
+  // the combining tilde is two bytes but one edit
+  CHECK_EQUAL("an\xcc\x83o", Join(dictionary_.GetSuggestionsFromWordUtf8("ano")));
+  CHECK_EQUAL("an\xcc\x83o", Join(dictionary_.GetSuggestionsFromWordUtf8("anyo")));
+  // as is the snowman for another three byte character
+  CHECK_EQUAL("\xe2\x98\x83", Join(dictionary_.GetSuggestionsFromWordUtf8("\xe2\x98\x84")));
+}
+
+TEST_FIXTURE(Utf8IndexTestFixture, IsWordPresentUtf8_IndexAfterAddAndRemove_SameAsUcs4)
+{
+  dictionary_.SetUseUtf8Index(true);
+  CHECK(!dictionary_.IsWordPresentUtf8("ni\xc3\xb1o"));
+  dictionary_.AddWordUtf8("ni\xc3\xb1o");
+  CHECK(dictionary_.IsWordPresentUtf8("ni\xc3\xb1o"));
+  dictionary_.RemoveWordUtf8("a\xc3\xb1o");
+  CHECK(!dictionary_.IsWordPresentUtf8("a\xc3\xb1o"));
+  CHECK_EQUAL("nin\xcc\x83o", Join(dictionary_.GetSuggestionsFromWordUtf8("nino")));
+}
+
+//// the exact lookup indexes
+struct ExactLookupTestFixture : public SpellDictionaryTestFixture{
+  typedef void (SpellDictionary::*SetUse)(bool);
+
+  //Setup
+  ExactLookupTestFixture()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("car");
+      sWords.push_back("cart");
+      sWords.push_back("cat");
+      sWords.push_back("caf\xc3\xa9");   // café
+      sWords.push_back("dog");
+      LoadWords(sWords);
+  }
+
+  // words looked up, in and out of the dictionary
+  static std::vector<const std::string> Lookups()
+  {
+      std::vector<const std::string> sWords;
+      sWords.push_back("car");
+      sWords.push_back("cart");
+      sWords.push_back("cat");
+      sWords.push_back("caf\xc3\xa9");
+      sWords.push_back("dog");
+      sWords.push_back("cab");
+      sWords.push_back("ca");
+      sWords.push_back("carts");
+      sWords.push_back("cafe");
+      sWords.push_back("bird");
+      return sWords;
+  }
+
+  // whether each of the lookups is present in the dictionary, as 1s and 0s
+  static std::string Present(SpellDictionary& dictionary)
+  {
+      std::string s;
+      std::vector<const std::string> sWords = Lookups();
+      for(std::vector<const std::string>::const_iterator it = sWords.begin(); it != sWords.end(); ++it)
+      {
+          s += dictionary.IsWordPresentUtf8(*it) ? '1' : '0';
+      }
+      return s;
+  }
+
+  // the lookups present with the lookup pfnSetUse turned on or off
+  std::string PresentWith(SetUse pfnSetUse, bool fUse)
+  {
+      (dictionary_.*pfnSetUse)(fUse);
+      return Present(dictionary_);
+  }
+
+  // the lookups present in the saved dictionary read again, with the lookup on
+  std::string PresentReloaded(SetUse pfnSetUse)
+  {
+      SpellDictionary reloaded;
+      (reloaded.*pfnSetUse)(true);
+      reloaded.Load(new LineDictionaryFile(sDictionaryFileName_));
+      return Present(reloaded);
+  }
+
+  void ChangeWords()
+  {
+      dictionary_.AddWordUtf8("cab");
+      dictionary_.RemoveWordUtf8("cat");
+  }
+};
+
+TEST_FIXTURE(ExactLookupTestFixture, IsWordPresent_ExactIndex_SameAnswers)
+{
+  const SetUse pfnSetUse = &SpellDictionary::SetUseExactIndex;
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, true));
+  ChangeWords();
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, true));
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1101110000", PresentReloaded(pfnSetUse));
+}
+
+TEST_FIXTURE(ExactLookupTestFixture, IsWordPresent_ExactHash_SameAnswers)
+{
+  const SetUse pfnSetUse = &SpellDictionary::SetUseExactHash;
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, true));
+  // added words are looked up in the word list until the hash is rebuilt
+  ChangeWords();
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, true));
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1101110000", PresentReloaded(pfnSetUse));
+}
+
+TEST_FIXTURE(ExactLookupTestFixture, IsWordPresent_BloomFilter_SameAnswers)
+{
+  const SetUse pfnSetUse = &SpellDictionary::SetUseBloomFilter;
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1111100000", PresentWith(pfnSetUse, true));
+  // added words go into the filter, removed ones have it rebuilt
+  ChangeWords();
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, true));
+  CHECK_EQUAL("1101110000", PresentWith(pfnSetUse, false));
+  CHECK_EQUAL("1101110000", PresentReloaded(pfnSetUse));
+}
+
+TEST_FIXTURE(ExactLookupTestFixture, IsWordPresent_EveryLookupTogether_SameAnswers)
+{
+  dictionary_.SetUseBloomFilter(true);
+  dictionary_.SetUseExactHash(true);
+  dictionary_.SetUseExactIndex(true);
+  CHECK_EQUAL("1111100000", Present(dictionary_));
+  ChangeWords();
+  CHECK_EQUAL("1101110000", Present(dictionary_));
+}
+
+//// GetNearDuplicates
+TEST_FIXTURE(SpellDictionaryTestFixture, GetNearDuplicates_OtherDictionary_PairsWithinDistance)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("colour");
+  sWords.push_back("centre");
+  sWords.push_back("cat");
+  LoadWords(sWords);
+
+  std::string sOtherFileName = CreateTempFile();
+  std::vector<const std::string> sOtherWords;
+  sOtherWords.push_back("color");
+  sOtherWords.push_back("center");
+  sOtherWords.push_back("dog");
+  WriteWords(sOtherFileName, sOtherWords);
+  {
+      SpellDictionary other;
+      other.Load(new LineDictionaryFile(sOtherFileName));
+
+      std::vector<SpellDictionary::WordPair> rgPairs = dictionary_.GetNearDuplicates(other, 2);
+      CHECK_EQUAL(2u, rgPairs.size());
+      CHECK(rgPairs[0].strWord == Convert::ToUcs4("centre"));
+      CHECK(rgPairs[0].strOtherWord == Convert::ToUcs4("center"));
+      CHECK_EQUAL(1, rgPairs[0].nDistance); // re and er transposed
+      CHECK(rgPairs[1].strWord == Convert::ToUcs4("colour"));
+      CHECK(rgPairs[1].strOtherWord == Convert::ToUcs4("color"));
+      CHECK_EQUAL(1, rgPairs[1].nDistance);
+
+      CHECK(dictionary_.GetNearDuplicates(other, 0).empty());
+  }
+  g_remove(sOtherFileName.c_str());
+}
+
+TEST_FIXTURE(SpellDictionaryTestFixture, GetNearDuplicates_Itself_EachPairOnce)
+{
+  std::vector<const std::string> sWords;
+  sWords.push_back("color");
+  sWords.push_back("colour");
+  sWords.push_back("dog");
+  LoadWords(sWords);
+
+  std::vector<SpellDictionary::WordPair> rgPairs = dictionary_.GetNearDuplicates(dictionary_, 1);
+  CHECK_EQUAL(1u, rgPairs.size());
+  CHECK(rgPairs[0].strWord == Convert::ToUcs4("colour"));
+  CHECK(rgPairs[0].strOtherWord == Convert::ToUcs4("color"));
+}
+
+//// LoadVariant
+struct VariantTestFixture : public SpellDictionaryTestFixture{
+  //Setup
+  VariantTestFixture()
+  {
+      sBaseFileName_ = CreateTempFile();
+      std::vector<const std::string> sBaseWords;
+      sBaseWords.push_back("car\t50");
+      sBaseWords.push_back("cart\t10");
+      sBaseWords.push_back("cast\t1");
+      sBaseWords.push_back("cat\t5");
+      sBaseWords.push_back("colour\t20");
+      sBaseWords.push_back("dog\t100");
+      WriteWords(sBaseFileName_, sBaseWords);
+      base_.Load(new LineDictionaryFile(sBaseFileName_));
+
+      // cast left out, cat given another frequency and centre added
+      std::vector<const std::string> sWords;
+      sWords.push_back("car\t50");
+      sWords.push_back("cart\t10");
+      sWords.push_back("cat\t70");
+      sWords.push_back("centre\t3");
+      sWords.push_back("colour\t20");
+      sWords.push_back("dog\t100");
+      WriteWords(sDictionaryFileName_, sWords);
+      variant_.LoadVariant(base_, new LineDictionaryFile(sDictionaryFileName_));
+  }
+
+  //Teardown
+  ~VariantTestFixture()
+  {
+      g_remove(sBaseFileName_.c_str());
+  }
+
+  // every word in the order of their ids, separated by '|'
+  static std::string Words(SpellDictionary& dictionary)
+  {
+      std::string s;
+      for(size_t id = 0; id != dictionary.GetEntryCount(); ++id)
+      {
+          if(id != 0)
+          {
+              s += '|';
+          }
+          s += Convert::ToUtf8(dictionary.GetWordFromId(id));
+      }
+      return s;
+  }
+
+  // whether each id gives its word back, as 1s and 0s
+  static std::string IdsRoundTrip(SpellDictionary& dictionary)
+  {
+      std::string s;
+      for(size_t id = 0; id != dictionary.GetEntryCount(); ++id)
+      {
+          s += (dictionary.GetWordId(dictionary.GetWordFromId(id)) == id) ? '1' : '0';
+      }
+      return s;
+  }
+
+  // every pair as word/other word/distance, separated by '|'
+  static std::string Pairs(const std::vector<SpellDictionary::WordPair>& rgPairs)
+  {
+      std::string s;
+      for(std::vector<SpellDictionary::WordPair>::const_iterator it = rgPairs.begin(); it != rgPairs.end(); ++it)
+      {
+          if(it != rgPairs.begin())
+          {
+              s += '|';
+          }
+          s += Convert::ToUtf8(it->strWord) + '/' + Convert::ToUtf8(it->strOtherWord) + '/';
+          s += static_cast<char>('0' + it->nDistance);
+      }
+      return s;
+  }
+
+  // the variant's file loaded on its own
+  std::string WordsReloaded()
+  {
+      SpellDictionary reloaded;
+      reloaded.Load(new LineDictionaryFile(sDictionaryFileName_));
+      return Words(reloaded);
+  }
+
+  std::string sBaseFileName_;
+  SpellDictionary base_;
+  SpellDictionary variant_;
+};
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_Words_AsInItsFile)
+{
+  CHECK_EQUAL("car|cart|cat|centre|colour|dog", Words(variant_));
+  CHECK_EQUAL("111111", IdsRoundTrip(variant_));
+  CHECK_EQUAL(6u, variant_.GetEntryCount());
+  CHECK_EQUAL(3u, variant_.GetEntryCountWithPrefix(Convert::ToUcs4("ca")));
+  CHECK_EQUAL(5u, variant_.GetEntryCountWithPrefix(Convert::ToUcs4("c")));
+  CHECK(variant_.GetWordFromId(6).empty());
+  CHECK_EQUAL(static_cast<size_t>(-1), variant_.GetWordId(Convert::ToUcs4("cast")));
+
+  CHECK_EQUAL("car|cart|cast|cat|colour|dog", Words(base_));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_Lookup_VariantsWordsOnly)
+{
+  CHECK(variant_.IsWordPresentUtf8("car"));
+  CHECK(variant_.IsWordPresentUtf8("cat"));
+  CHECK(variant_.IsWordPresentUtf8("centre"));
+  CHECK(variant_.IsWordPresentUtf8("dog"));
+  CHECK(!variant_.IsWordPresentUtf8("cast"));
+  CHECK(!variant_.IsWordPresentUtf8("ca"));
+
+  CHECK(base_.IsWordPresentUtf8("cast"));
+  CHECK(!base_.IsWordPresentUtf8("centre"));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_HiddenWord_NotSuggested)
+{
+  CHECK_EQUAL("cat|car|cart", Join(variant_.GetSuggestionsFromWordUtf8("cas")));
+  CHECK_EQUAL("car|cat|cast|cart", Join(base_.GetSuggestionsFromWordUtf8("cas")));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_ChangedFrequency_CompletionsReordered)
+{
+  CHECK_EQUAL("cat|car|cart", Join(variant_.GetCompletionsUtf8("ca", 5)));
+  CHECK_EQUAL("car|cart|cat|cast", Join(base_.GetCompletionsUtf8("ca", 5)));
+  CHECK_EQUAL("dog|cat", Join(variant_.GetCompletionsUtf8("", 2)));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_Pattern_VariantsWordsOnly)
+{
+  CHECK_EQUAL("car|cart|cat|centre|colour", Join(variant_.GetWordsMatchingPatternUtf8("c*")));
+  CHECK_EQUAL("cart", Join(variant_.GetWordsMatchingPatternUtf8("ca?t")));
+  CHECK_EQUAL("cart|cast", Join(base_.GetWordsMatchingPatternUtf8("ca?t")));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_AddAndRemove_VariantAndItsFileOnly)
+{
+  variant_.AddWordUtf8("cab");
+  variant_.AddWordUtf8("cast");
+  variant_.RemoveWordUtf8("dog");
+  variant_.RemoveWordUtf8("centre");
+
+  CHECK_EQUAL("cab|car|cart|cast|cat|colour", Words(variant_));
+  CHECK_EQUAL("111111", IdsRoundTrip(variant_));
+  CHECK(!variant_.IsWordPresentUtf8("dog"));
+  CHECK(variant_.IsWordPresentUtf8("cast"));
+
+  CHECK_EQUAL("car|cart|cast|cat|colour|dog", Words(base_));
+  CHECK_EQUAL("cab|car|cart|cast|cat|colour", WordsReloaded());
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_RemoveAllWords_EmptyAndSaved)
+{
+  variant_.RemoveAllWords();
+  CHECK_EQUAL(0u, variant_.GetEntryCount());
+  CHECK(!variant_.IsWordPresentUtf8("dog"));
+  CHECK_EQUAL("", WordsReloaded());
+  CHECK(base_.IsWordPresentUtf8("dog"));
+}
+
+TEST_FIXTURE(VariantTestFixture, LoadVariant_BaseChanged_VariantAsInItsFile)
+{
+  base_.AddWordUtf8("cab");
+  base_.RemoveWordUtf8("colour");
+
+  CHECK(!variant_.IsWordPresentUtf8("cab"));
+  CHECK(variant_.IsWordPresentUtf8("colour"));
+  CHECK_EQUAL("car|cart|cat|centre|colour|dog", Words(variant_));
+  CHECK_EQUAL("111111", IdsRoundTrip(variant_));
+}
+
+TEST_FIXTURE(VariantTestFixture, GetNearDuplicates_Variant_AsIfLoadedAlone)
+{
+  SpellDictionary alone;
+  alone.Load(new LineDictionaryFile(sDictionaryFileName_));
+
+  CHECK_EQUAL("cart/car/1|cat/car/1|cat/cart/1", Pairs(variant_.GetNearDuplicates(variant_, 1)));
+  CHECK_EQUAL(Pairs(alone.GetNearDuplicates(alone, 1)), Pairs(variant_.GetNearDuplicates(variant_, 1)));
+  CHECK_EQUAL(Pairs(alone.GetNearDuplicates(base_, 1)), Pairs(variant_.GetNearDuplicates(base_, 1)));
+  CHECK_EQUAL(Pairs(base_.GetNearDuplicates(alone, 1)), Pairs(base_.GetNearDuplicates(variant_, 1)));
+  CHECK_EQUAL(Pairs(alone.GetNearDuplicates(alone, 2)), Pairs(variant_.GetNearDuplicates(variant_, 2)));
+}
+
+TEST_FIXTURE(VariantTestFixture, GetNearDuplicates_TwoVariantsOfOneBase_AsIfLoadedAlone)
+{
+  std::string sOtherFileName = CreateTempFile();
+  std::vector<const std::string> sOtherWords;
+  sOtherWords.push_back("car\t50");
+  sOtherWords.push_back("cast\t1");
+  sOtherWords.push_back("cat\t5");
+  sOtherWords.push_back("color\t20");
+  sOtherWords.push_back("dog\t100");
+  WriteWords(sOtherFileName, sOtherWords);
+  {
+      SpellDictionary other;
+      other.LoadVariant(base_, new LineDictionaryFile(sOtherFileName));
+      SpellDictionary otherAlone;
+      otherAlone.Load(new LineDictionaryFile(sOtherFileName));
+      SpellDictionary alone;
+      alone.Load(new LineDictionaryFile(sDictionaryFileName_));
+
+      CHECK_EQUAL(Pairs(alone.GetNearDuplicates(otherAlone, 1)), Pairs(variant_.GetNearDuplicates(other, 1)));
+      CHECK_EQUAL(Pairs(otherAlone.GetNearDuplicates(alone, 2)), Pairs(other.GetNearDuplicates(variant_, 2)));
+  }
+  g_remove(sOtherFileName.c_str());
+}
+
+//// Layers
+struct LayerTestFixture : public SpellDictionaryTestFixture{
+  //Setup
+  LayerTestFixture()
+  {
+      // a new personal word list, whose file isn't there yet
+      sPersonalFileName_ = CreateTempFile();
+      g_remove(sPersonalFileName_.c_str());
+      std::vector<const std::string> sWords;
+      sWords.push_back("car");
+      sWords.push_back("cat");
+      sWords.push_back("dog");
+      sWords.push_back("haus");
+      sWords.push_back("tor");
+      LoadWords(sWords);
+      dictionary_.LoadPersonal(new LineDictionaryFile(sPersonalFileName_));
+  }
+
+  //Teardown
+  ~LayerTestFixture()
+  {
+      g_remove(sPersonalFileName_.c_str());
+  }
+
+  std::string sPersonalFileName_;
+};
+
+TEST_FIXTURE(LayerTestFixture, AddPersonalWord_PresentAndInPersonalFileOnly)
+{
+  dictionary_.AddPersonalWordUtf8("zebra");
+  CHECK(dictionary_.IsWordPresentUtf8("zebra"));
+  CHECK_EQUAL("zebra", Join(dictionary_.GetCompletionsUtf8("ze", 5)));
+
+  SpellDictionary reloaded;
+  reloaded.Load(new LineDictionaryFile(sDictionaryFileName_));
+  CHECK(!reloaded.IsWordPresentUtf8("zebra"));
+  reloaded.LoadPersonal(new LineDictionaryFile(sPersonalFileName_));
+  CHECK(reloaded.IsWordPresentUtf8("zebra"));
+  CHECK(reloaded.IsWordPresentUtf8("dog"));
+}
+
+TEST_FIXTURE(LayerTestFixture, AddSessionWord_PresentUntilRemovedAndNotSaved)
+{
+  dictionary_.AddSessionWordUtf8("zebra");
+  CHECK(dictionary_.IsWordPresentUtf8("zebra"));
+  CHECK(dictionary_.IsSessionWordUtf8("zebra"));
+  CHECK_EQUAL("zebra", Join(dictionary_.GetSuggestionsFromWordUtf8("zebr")));
+
+  SpellDictionary reloaded;
+  reloaded.Load(new LineDictionaryFile(sDictionaryFileName_));
+  reloaded.LoadPersonal(new LineDictionaryFile(sPersonalFileName_));
+  CHECK(!reloaded.IsWordPresentUtf8("zebra"));
+
+  dictionary_.RemoveSessionWordUtf8("zebra");
+  CHECK(!dictionary_.IsWordPresentUtf8("zebra"));
+  CHECK(!dictionary_.IsSessionWordUtf8("zebra"));
+}
+
+TEST_FIXTURE(LayerTestFixture, GetWordsMatchingPattern_LayerWords_MatchedInOrder)
+{
+  dictionary_.AddPersonalWordUtf8("cab");
+  dictionary_.AddSessionWordUtf8("caw");
+  dictionary_.AddSessionWordUtf8("cat"); // in the word list already
+  CHECK_EQUAL("cab|car|cat|caw", Join(dictionary_.GetWordsMatchingPatternUtf8("ca?")));
+  CHECK_EQUAL("cab|car|caw", Join(dictionary_.GetWordsMatchingPatternUtf8("ca[^t]")));
+
+  dictionary_.ExcludeWordUtf8("cab");
+  CHECK_EQUAL("car|cat|caw", Join(dictionary_.GetWordsMatchingPatternUtf8("c*")));
+}
+
+TEST_FIXTURE(LayerTestFixture, ExcludeWord_NeitherAcceptedNorSuggested)
+{
+  dictionary_.ExcludeWordUtf8("cat");
+  CHECK(!dictionary_.IsWordPresentUtf8("cat"));
+  CHECK(dictionary_.IsWordPresentUtf8("car"));
+  CHECK_EQUAL("car", Join(dictionary_.GetSuggestionsFromWordUtf8("cax")));
+  CHECK_EQUAL("car", Join(dictionary_.GetCompletionsUtf8("ca", 5)));
+  CHECK_EQUAL("car", Join(dictionary_.GetWordsMatchingPatternUtf8("ca?")));
+}
+
+TEST_FIXTURE(LayerTestFixture, ExcludeWord_PersonalWord_RemovedFromPersonalFile)
+{
+  dictionary_.AddPersonalWordUtf8("zebra");
+  dictionary_.ExcludeWordUtf8("zebra");
+  CHECK(!dictionary_.IsWordPresentUtf8("zebra"));
+
+  SpellDictionary reloaded;
+  reloaded.Load(new LineDictionaryFile(sDictionaryFileName_));
+  reloaded.LoadPersonal(new LineDictionaryFile(sPersonalFileName_));
+  CHECK(!reloaded.IsWordPresentUtf8("zebra"));
+
+  dictionary_.AddSessionWordUtf8("zebra"); // adding it again takes it out
+  CHECK(dictionary_.IsWordPresentUtf8("zebra"));
+}
+
+TEST_FIXTURE(LayerTestFixture, ExcludeWord_NotPartOfCompoundOrSplit)
+{
+  dictionary_.SetCompoundMaxParts(2);
+  CHECK(dictionary_.IsWordPresentUtf8("haustor"));
+  CHECK_EQUAL("cat dog", Join(dictionary_.GetSuggestionsFromWordUtf8("catdog")).substr(0, 7));
+
+  dictionary_.ExcludeWordUtf8("tor");
+  dictionary_.ExcludeWordUtf8("dog");
+  CHECK(!dictionary_.IsWordPresentUtf8("haustor"));
+  CHECK(Join(dictionary_.GetSuggestionsFromWordUtf8("catdog")).find(' ') == std::string::npos);
+  CHECK(Join(dictionary_.GetSuggestionsFromWordUtf8("dogcat")).find(' ') == std::string::npos);
+}
+
+TEST_FIXTURE(LayerTestFixture, ExcludeWord_NotSegmented)
+{
+  CHECK_EQUAL("haus|tor|dog", Join(dictionary_.SegmentTextUtf8("haustordog")));
+
+  // unknown characters next to each other are one segment
+  dictionary_.ExcludeWordUtf8("tor");
+  dictionary_.ExcludeWordUtf8("dog");
+  CHECK_EQUAL("haus|tordog", Join(dictionary_.SegmentTextUtf8("haustordog")));
+}
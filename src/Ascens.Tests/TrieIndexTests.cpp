@@ -0,0 +1,556 @@
+#include <UnitTest++.h>
+#include "trie_map"
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef trie::trie_map<std::string, unsigned int> word_map;
+typedef trie::radix_trie<word_map, unsigned char> small_radix_trie;
+
+// the read only indexes built from a word_map, checked against the trie itself
+struct IndexTestFixture{
+  //Setup
+  IndexTestFixture()
+  {
+      Insert("cat", 5);
+      Insert("car", 50);
+      Insert("cart", 10);
+      Insert("cast", 1);
+      Insert("dog", 100);
+      Insert("international", 20);
+      Insert("internationalize", 2);
+      Insert("internationalization", 3);
+  }
+
+  //Teardown
+  ~IndexTestFixture()
+  {
+  }
+
+  void Insert(const char* szWord, unsigned int nFrequency)
+  {
+      words_.insert(word_map::value_type(szWord, nFrequency));
+  }
+
+  // the keys found, separated by '|'
+  template <class _Iterator>
+  static std::string Join(const std::vector<_Iterator>& rgIt)
+  {
+      std::string s;
+      for(typename std::vector<_Iterator>::const_iterator it = rgIt.begin(); it != rgIt.end(); ++it)
+      {
+          if(it != rgIt.begin())
+          {
+              s += '|';
+          }
+          s += (*it)->first;
+      }
+      return s;
+  }
+
+  // every key in the trie and a few that are not
+  std::vector<std::string> Lookups() const
+  {
+      std::vector<std::string> rgs;
+      for(word_map::const_iterator it = words_.begin(); it != words_.end(); ++it)
+      {
+          rgs.push_back(it->first);
+      }
+      rgs.push_back("");
+      rgs.push_back("ca");
+      rgs.push_back("carts");
+      rgs.push_back("cow");
+      rgs.push_back("internation");
+      rgs.push_back("internationalizations");
+      rgs.push_back("zebra");
+      return rgs;
+  }
+
+  word_map words_;
+};
+
+//// radix_trie
+TEST_FIXTURE(IndexTestFixture, RadixTrie_Find_SameAsTrie)
+{
+  trie::radix_trie<word_map> radix(words_);
+  CHECK_EQUAL(words_.size(), radix.size());
+
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      const word_map& words = words_;
+      CHECK(radix.find(*it) == words.find(*it));
+      CHECK(radix.find_if_prefix(*it) == words.find_if_prefix(*it));
+      CHECK_EQUAL(Join(words.find_prefixes(it->begin(), it->end())), Join(radix.find_prefixes(*it)));
+  }
+}
+
+TEST_FIXTURE(IndexTestFixture, RadixTrie_Chains_Collapsed)
+{
+  trie::radix_trie<word_map> radix(words_);
+  // far fewer nodes than the binary trie has characters
+  CHECK(radix.node_count() < 20);
+  CHECK(radix.find("internationalization") != radix.end());
+  CHECK(radix.find("internationalizatio") == radix.end());
+}
+
+TEST_FIXTURE(IndexTestFixture, RadixTrie_SmallCodes_RunsLongerThanANode)
+{
+  small_radix_trie radix(words_);
+  CHECK_EQUAL(12, (int) small_radix_trie::_S_run_capacity);
+  CHECK_EQUAL("internationalization", radix.find("internationalization")->first);
+  CHECK_EQUAL("international|internationalize", Join(radix.find_prefixes(std::string("internationalized"))));
+}
+
+TEST_FIXTURE(IndexTestFixture, RadixTrie_ApproximateFind_SameAsTrie)
+{
+  small_radix_trie radix(words_);
+  const word_map& words = words_;
+
+  std::vector<std::string> rgs = Lookups();
+  rgs.push_back("cta");
+  rgs.push_back("dgo");
+  rgs.push_back("intrenationalise");
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      for(unsigned int k = 0; k != 4; ++k)
+      {
+          CHECK_EQUAL(Join(words.approximate_find(*it, k)), Join(radix.approximate_find(*it, k)));
+          CHECK_EQUAL(Join(words.weighted_find(*it, k, 2)), Join(radix.weighted_find(*it, k, 2)));
+      }
+      CHECK_EQUAL(Join(words.best_find(*it)), Join(radix.best_find(*it)));
+  }
+}
+
+TEST_FIXTURE(IndexTestFixture, RadixTrie_Reassigned_FollowsTrie)
+{
+  trie::radix_trie<word_map> radix(words_);
+  Insert("cab", 1);
+  words_.erase("dog");
+  radix.assign(words_);
+  CHECK(radix.find("cab") != radix.end());
+  CHECK(radix.find("dog") == radix.end());
+  CHECK_EQUAL(words_.size(), radix.size());
+
+  words_.clear();
+  radix.assign(words_);
+  CHECK(radix.empty());
+  CHECK(radix.find("cab") == radix.end());
+  CHECK(radix.approximate_find("cab", 2).empty());
+}
+
+typedef std::basic_string<unsigned int> ucs4_string;
+typedef trie::trie_map<ucs4_string, unsigned int> ucs4_map;
+
+static ucs4_string
+ToUcs4(const char* sz)
+{
+  ucs4_string s;
+  for(; *sz; ++sz)
+  {
+      s += (unsigned char) *sz;
+  }
+  return s;
+}
+
+TEST(RadixTrie_Utf8Units_CharactersCountedAsOneEdit)
+{
+  ucs4_map words;
+  ucs4_string cafe = ToUcs4("caf");
+  cafe += 0xE9;   // é, two bytes in UTF-8
+  words.insert(ucs4_map::value_type(cafe, 1));
+  ucs4_string snowman(1, 0x2603);   // three bytes
+  words.insert(ucs4_map::value_type(snowman, 1));
+
+  trie::radix_trie<ucs4_map, unsigned char, trie::__utf8_units> radix(words);
+  const std::string sCafe("caf\xc3\xa9");
+  const std::string sCafeUnaccented("cafe");
+  const std::string sSnowman("\xe2\x98\x83");
+  CHECK(radix.find(sCafe.begin(), sCafe.end()) != radix.end());
+  CHECK(radix.find(sCafeUnaccented.begin(), sCafeUnaccented.end()) == radix.end());
+  CHECK(radix.find(sSnowman.begin(), sSnowman.end()) != radix.end());
+
+  // é for e, and an added character, are each one edit
+  const std::string sCafes("caf\xc3\xa9s");
+  const std::string sX("x");
+  CHECK_EQUAL(1u, radix.approximate_find(sCafeUnaccented.begin(), sCafeUnaccented.end(), 1).size());
+  CHECK_EQUAL(1u, radix.approximate_find(sCafes.begin(), sCafes.end(), 1).size());
+  CHECK_EQUAL(1u, radix.approximate_find(sX.begin(), sX.end(), 1).size());
+  CHECK_EQUAL(0u, radix.approximate_find(sCafes.begin(), sCafes.end(), 0).size());
+}
+
+//// louds_trie
+TEST_FIXTURE(IndexTestFixture, LoudsTrie_Find_SameAsTrie)
+{
+  trie::louds_trie<word_map, unsigned char> louds(words_);
+  CHECK_EQUAL(words_.size(), louds.size());
+  const word_map& words = words_;
+
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      CHECK(louds.find(*it) == words.find(*it));
+      CHECK(louds.find_if_prefix(*it) == words.find_if_prefix(*it));
+      CHECK_EQUAL(Join(words.find_prefixes(it->begin(), it->end())), Join(louds.find_prefixes(*it)));
+  }
+}
+
+TEST_FIXTURE(IndexTestFixture, LoudsTrie_ApproximateFind_SameAsTrie)
+{
+  trie::louds_trie<word_map, unsigned char> louds(words_);
+  const word_map& words = words_;
+
+  std::vector<std::string> rgs = Lookups();
+  rgs.push_back("cta");
+  rgs.push_back("dgo");
+  rgs.push_back("intrenationalise");
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      for(unsigned int k = 0; k != 4; ++k)
+      {
+          CHECK_EQUAL(Join(words.approximate_find(*it, k)), Join(louds.approximate_find(*it, k)));
+          CHECK_EQUAL(Join(words.weighted_find(*it, k, 2)), Join(louds.weighted_find(*it, k, 2)));
+      }
+      CHECK_EQUAL(Join(words.best_find(*it)), Join(louds.best_find(*it)));
+  }
+}
+
+TEST_FIXTURE(IndexTestFixture, LoudsTrie_Nodes_OnePerCharacterOfTheTrie)
+{
+  trie::louds_trie<word_map, unsigned char> louds(words_);
+  // the root, c a r t s t t, d o g, international, iz, e and ation
+  CHECK_EQUAL(1u + 7u + 3u + 13u + 2u + 1u + 5u, louds.node_count());
+
+  words_.clear();
+  louds.assign(words_);
+  CHECK(louds.empty());
+  CHECK(louds.find("car") == louds.end());
+  CHECK(louds.approximate_find("car", 2).empty());
+}
+
+//// double_array
+TEST_FIXTURE(IndexTestFixture, DoubleArray_Count_SameAsTrieFind)
+{
+  trie::double_array<word_map> exact(words_);
+  CHECK_EQUAL(words_.size(), exact.size());
+
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      CHECK_EQUAL(words_.find(*it) != words_.end() ? 1u : 0u, exact.count(*it));
+  }
+}
+
+TEST(DoubleArray_EqualKeys_CountedEach)
+{
+  typedef trie::trie_multimap<std::string, unsigned int> word_multimap;
+  word_multimap words;
+  words.insert(word_multimap::value_type("car", 1));
+  words.insert(word_multimap::value_type("car", 2));
+  words.insert(word_multimap::value_type("cart", 3));
+  words.insert(word_multimap::value_type("", 4));
+
+  trie::double_array<word_multimap> exact(words);
+  CHECK_EQUAL(2u, exact.count("car"));
+  CHECK_EQUAL(1u, exact.count("cart"));
+  CHECK_EQUAL(1u, exact.count(""));
+  CHECK_EQUAL(0u, exact.count("ca"));
+
+  words.clear();
+  exact.assign(words);
+  CHECK(exact.empty());
+  CHECK_EQUAL(0u, exact.count("car"));
+}
+
+//// perfect_hash
+TEST_FIXTURE(IndexTestFixture, PerfectHash_Count_SameAsTrieFind)
+{
+  trie::perfect_hash<word_map> hash(words_);
+  CHECK_EQUAL(words_.size(), hash.size());
+  CHECK(hash.bits_per_key() > 0);
+
+  // a 32 bit fingerprint lets through about one in four billion other keys
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      CHECK_EQUAL(words_.find(*it) != words_.end() ? 1u : 0u, hash.count(*it));
+  }
+}
+
+TEST(PerfectHash_ManyKeys_EachFoundOnce)
+{
+  word_map words;
+  std::string s("aaaa");
+  for(int i = 0; i != 2000; ++i)
+  {
+      s[i % 4] = (char) ('a' + (i * 7) % 26);
+      words.insert(word_map::value_type(s, 0));
+  }
+  trie::perfect_hash<word_map> hash(words);
+  CHECK_EQUAL(words.size(), hash.size());
+  for(word_map::const_iterator it = words.begin(); it != words.end(); ++it)
+  {
+      CHECK_EQUAL(1u, hash.count(it->first));
+  }
+
+  words.clear();
+  hash.assign(words);
+  CHECK(hash.empty());
+  CHECK_EQUAL(0u, hash.count("aaaa"));
+}
+
+//// bloom_filter
+TEST_FIXTURE(IndexTestFixture, BloomFilter_Count_NoFalseNegatives)
+{
+  trie::bloom_filter<word_map> filter(words_);
+  for(word_map::const_iterator it = words_.begin(); it != words_.end(); ++it)
+  {
+      CHECK_EQUAL(1u, filter.count(it->first));
+  }
+}
+
+TEST(BloomFilter_KeysNotAdded_FewFalsePositives)
+{
+  word_map words;
+  std::string s("aaaa");
+  for(int i = 0; i != 2000; ++i)
+  {
+      s[i % 4] = (char) ('a' + (i * 7) % 26);
+      words.insert(word_map::value_type(s, 0));
+  }
+  trie::bloom_filter<word_map> filter(words);
+
+  // keys of another length are never in the trie
+  size_t cFalsePositives = 0;
+  std::string t("aaaaa");
+  for(int i = 0; i != 2000; ++i)
+  {
+      t[i % 5] = (char) ('a' + (i * 11) % 26);
+      cFalsePositives += filter.count(t);
+  }
+  CHECK(cFalsePositives < 2000 / 20);
+}
+
+TEST_FIXTURE(IndexTestFixture, BloomFilter_Inserted_Counted)
+{
+  trie::bloom_filter<word_map> filter(words_);
+  filter.insert("zebra");
+  CHECK_EQUAL(1u, filter.count("zebra"));
+
+  word_map empty;
+  filter.assign(empty);
+  CHECK_EQUAL(0u, filter.count("car"));
+}
+
+//// frequency_trie
+// collects key:count for each key visited, separated by '|'
+struct KeyCountCollector
+{
+  void operator()(const char* first, const char* last, size_t nCount)
+  {
+      if(!s.empty())
+      {
+          s += '|';
+      }
+      s.append(first, last);
+      s += ':';
+      s += (char) ('0' + nCount);
+  }
+
+  std::string s;
+};
+
+TEST_FIXTURE(IndexTestFixture, FrequencyTrie_Count_SameAsTrieFind)
+{
+  trie::frequency_trie<word_map> frequency(words_);
+  CHECK_EQUAL(words_.size(), frequency.size());
+
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      CHECK_EQUAL(words_.find(*it) != words_.end() ? 1u : 0u, frequency.count(*it));
+  }
+}
+
+TEST_FIXTURE(IndexTestFixture, FrequencyTrie_ForEach_KeysInOrder)
+{
+  words_.erase("international");
+  words_.erase("internationalize");
+  words_.erase("internationalization");
+  trie::frequency_trie<word_map> frequency(words_);
+  // dog is the heaviest, but is still visited last
+  CHECK_EQUAL("car:1|cart:1|cast:1|cat:1|dog:1", frequency.for_each(KeyCountCollector()).s);
+}
+
+TEST_FIXTURE(IndexTestFixture, FrequencyTrie_RecordAndReorder_SameAnswers)
+{
+  trie::frequency_trie<word_map> frequency(words_);
+  const std::string sVisited = frequency.for_each(KeyCountCollector()).s;
+
+  for(int i = 0; i != 100; ++i)
+  {
+      CHECK_EQUAL(1u, frequency.record("cast"));
+  }
+  CHECK_EQUAL(0u, frequency.record("ca"));
+  CHECK_EQUAL(0u, frequency.record("zebra"));
+  frequency.reorder();
+
+  std::vector<std::string> rgs = Lookups();
+  for(std::vector<std::string>::const_iterator it = rgs.begin(); it != rgs.end(); ++it)
+  {
+      CHECK_EQUAL(words_.find(*it) != words_.end() ? 1u : 0u, frequency.count(*it));
+  }
+  CHECK_EQUAL(sVisited, frequency.for_each(KeyCountCollector()).s);
+}
+
+TEST(FrequencyTrie_EqualKeys_CountedEach)
+{
+  typedef trie::trie_multimap<std::string, unsigned int> word_multimap;
+  word_multimap words;
+  words.insert(word_multimap::value_type("car", 1));
+  words.insert(word_multimap::value_type("car", 2));
+  words.insert(word_multimap::value_type("", 3));
+
+  trie::frequency_trie<word_multimap> frequency(words);
+  CHECK_EQUAL(2u, frequency.size());
+  CHECK_EQUAL(2u, frequency.count("car"));
+  CHECK_EQUAL(1u, frequency.count(""));
+  CHECK_EQUAL(":1|car:2", frequency.for_each(KeyCountCollector()).s);
+
+  words.clear();
+  frequency.assign(words);
+  CHECK(frequency.empty());
+  CHECK_EQUAL(0u, frequency.count("car"));
+  CHECK_EQUAL(0u, frequency.record("car"));
+}
+
+//// alphabet
+TEST(Alphabet_Characters_CodesInKeyOrder)
+{
+  const std::string s("dcab a");
+  trie::alphabet<char, unsigned char, std::less<char> > alphabet;
+  alphabet.assign(s.begin(), s.end());
+
+  CHECK_EQUAL(5u, alphabet.size());
+  CHECK_EQUAL(0, (int) alphabet.encode(' '));
+  CHECK_EQUAL(1, (int) alphabet.encode('a'));
+  CHECK_EQUAL(4, (int) alphabet.encode('d'));
+  CHECK_EQUAL('c', alphabet.decode(3));
+  CHECK_EQUAL(5, (int) alphabet.unknown());
+  CHECK(alphabet.encode('z') == alphabet.unknown());
+}
+
+TEST(Alphabet_CharactersAbove255_FoundBySearch)
+{
+  ucs4_string s;
+  s += 0x2603;
+  s += 0x3B1;
+  s += 'a';
+  trie::alphabet<unsigned int, unsigned short, std::less<unsigned int> > alphabet;
+  alphabet.assign(s.begin(), s.end());
+
+  CHECK_EQUAL(0, (int) alphabet.encode('a'));
+  CHECK_EQUAL(1, (int) alphabet.encode(0x3B1));
+  CHECK_EQUAL(2, (int) alphabet.encode(0x2603));
+  CHECK(alphabet.encode(0x3B2) == alphabet.unknown());
+  CHECK(alphabet.encode('b') == alphabet.unknown());
+}
+
+TEST(Alphabet_TooManyCharactersForCode_Throws)
+{
+  std::vector<unsigned int> rgCharacters;
+  for(unsigned int c = 0; c != 255; ++c)
+  {
+      rgCharacters.push_back(c * 7);
+  }
+  trie::alphabet<unsigned int, unsigned char, std::less<unsigned int> > alphabet;
+  alphabet.assign(rgCharacters.begin(), rgCharacters.end());
+  CHECK_EQUAL(255u, alphabet.size());
+  CHECK_EQUAL(255, (int) alphabet.unknown());
+
+  rgCharacters.push_back(0x2603);
+  CHECK_THROW(alphabet.assign(rgCharacters.begin(), rgCharacters.end()), std::length_error);
+  CHECK_EQUAL(0u, alphabet.size());
+}
+
+TEST(RadixTrie_TooManyCharactersForCode_ThrowsAndLeftEmpty)
+{
+  ucs4_map words;
+  for(unsigned int c = 0; c != 256; ++c)
+  {
+      words.insert(ucs4_map::value_type(ucs4_string(1, 0x100 + c), c));
+  }
+  trie::radix_trie<ucs4_map, unsigned char> radix;
+  CHECK_THROW(radix.assign(words), std::length_error);
+  CHECK(radix.empty());
+  CHECK(radix.find(ucs4_string(1, 0x100)) == radix.end());
+
+  words.erase(ucs4_string(1, 0x100));
+  radix.assign(words);
+  CHECK_EQUAL(255u, radix.size());
+  CHECK(radix.find(ucs4_string(1, 0x101)) != radix.end());
+}
+
+//// rank and select bits
+// whether rank1 and select0 agree with counting the bits one by one
+static bool RanksAndSelectsCounted(const trie::__rank_select_bits& rgf)
+{
+  size_t cOnes = 0;
+  size_t cZeros = 0;
+  for(size_t i = 0; i != rgf.size(); ++i)
+  {
+      if(rgf.rank1(i) != cOnes)
+      {
+          return false;
+      }
+      if(rgf[i])
+      {
+          ++cOnes;
+      }
+      else
+      {
+          if(rgf.select0(cZeros) != i)
+          {
+              return false;
+          }
+          ++cZeros;
+      }
+  }
+  return rgf.rank1(rgf.size()) == cOnes;
+}
+
+TEST(RankSelectBits_Frozen_RanksAndSelectsCounted)
+{
+  trie::__rank_select_bits rgf;
+  for(size_t i = 0; i != 3000; ++i)
+  {
+      rgf.push_back(i % 3 == 0);
+  }
+  rgf.freeze();
+  CHECK_EQUAL(3000u, rgf.size());
+  CHECK_EQUAL(1000u, rgf.rank1(3000));
+  CHECK(RanksAndSelectsCounted(rgf));
+}
+
+TEST(RankSelectBits_SetAfterFreeze_RanksAndSelectsCounted)
+{
+  trie::__rank_select_bits rgf;
+  for(size_t i = 0; i != 3000; ++i)
+  {
+      rgf.push_back(i % 3 == 0);
+  }
+  rgf.freeze();
+
+  // in the first block, across the later ones and on a bit already set
+  rgf.set(1);
+  rgf.set(1024);
+  rgf.set(2999);
+  rgf.set(3);
+  for(size_t i = 500; i != 1600; i += 2)
+  {
+      rgf.set(i);
+  }
+  CHECK(rgf[1] && rgf[1024] && rgf[2999]);
+  CHECK(RanksAndSelectsCounted(rgf));
+}
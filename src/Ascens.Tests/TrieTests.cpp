@@ -0,0 +1,857 @@
+#include <UnitTest++.h>
+#include "trie_map"
+#include "trie_set"
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef trie::trie_map<std::string, unsigned int> word_map;
+
+struct WordMapTestFixture{
+  //Setup
+  WordMapTestFixture()
+  {
+      Insert("cat", 5);
+      Insert("car", 50);
+      Insert("cart", 10);
+      Insert("cast", 1);
+      Insert("dog", 100);
+  }
+
+  //Teardown
+  ~WordMapTestFixture()
+  {
+  }
+
+  void Insert(const char* szWord, unsigned int nFrequency)
+  {
+      words_.insert(word_map::value_type(szWord, nFrequency));
+  }
+
+  // the keys found, separated by '|'
+  template <class _Iterator>
+  static std::string Join(const std::vector<_Iterator>& rgIt)
+  {
+      std::string s;
+      for(typename std::vector<_Iterator>::const_iterator it = rgIt.begin(); it != rgIt.end(); ++it)
+      {
+          if(it != rgIt.begin())
+          {
+              s += '|';
+          }
+          s += (*it)->first;
+      }
+      return s;
+  }
+
+  // every key=value in order, separated by '|'
+  template <class _Trie>
+  static std::string Entries(const _Trie& trie)
+  {
+      std::ostringstream s;
+      for(typename _Trie::const_iterator it = trie.begin(); it != trie.end(); ++it)
+      {
+          if(it != trie.begin())
+          {
+              s << '|';
+          }
+          s << it->first << '=' << it->second;
+      }
+      return s.str();
+  }
+
+  word_map words_;
+};
+
+//// complete
+TEST_FIXTURE(WordMapTestFixture, Complete_Prefix_HeaviestFirst)
+{
+  CHECK_EQUAL("car|cart|cat", Join(words_.complete("ca", 3)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_MoreThanThereAre_AllWithPrefix)
+{
+  CHECK_EQUAL("car|cart|cat|cast", Join(words_.complete("ca", 10)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_EmptyPrefix_HeaviestOfAll)
+{
+  CHECK_EQUAL("dog|car", Join(words_.complete("", 2)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_NoKeyHasPrefix_None)
+{
+  CHECK(words_.complete("x", 3).empty());
+  CHECK(words_.complete("carts", 3).empty());
+  CHECK(words_.complete("ca", 0).empty());
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_WeightChangedInPlace_Reordered)
+{
+  word_map::iterator it = words_.find("cast");
+  it->second = 70;
+  words_.reweight(it);
+  CHECK_EQUAL("cast|car", Join(words_.complete("ca", 2)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_HeaviestErased_NextHeaviest)
+{
+  words_.erase("car");
+  CHECK_EQUAL("cart|cat", Join(words_.complete("ca", 2)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Complete_EqualWeights_KeyOrder)
+{
+  Insert("dc", 7);
+  Insert("dac", 7);
+  Insert("d", 7);
+  Insert("dab", 7);
+  CHECK_EQUAL("dog|d|dab|dac|dc", Join(words_.complete("d", 5)));
+  CHECK_EQUAL("dog|d|dab", Join(words_.complete("d", 3)));
+  CHECK_EQUAL("dab|dac", Join(words_.complete("da", 5)));
+}
+
+//// rank, select and count_prefix
+TEST_FIXTURE(WordMapTestFixture, Rank_Key_KeysBefore)
+{
+  CHECK_EQUAL(0u, words_.rank("car"));
+  CHECK_EQUAL(2u, words_.rank("cast"));
+  CHECK_EQUAL(4u, words_.rank("dog"));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Rank_AbsentKey_KeysBefore)
+{
+  CHECK_EQUAL(0u, words_.rank("ca"));
+  CHECK_EQUAL(4u, words_.rank("cb"));
+  CHECK_EQUAL(5u, words_.rank("zebra"));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Select_Rank_KeyInOrder)
+{
+  for(word_map::size_type i = 0; i != words_.size(); ++i)
+  {
+      word_map::const_iterator it = words_.select(i);
+      CHECK_EQUAL(i, words_.rank(it->first));
+  }
+  CHECK_EQUAL("cart", words_.select(1)->first);
+  CHECK(words_.select(words_.size()) == words_.end());
+}
+
+TEST_FIXTURE(WordMapTestFixture, CountPrefix_Prefix_KeysWithPrefix)
+{
+  CHECK_EQUAL(5u, words_.count_prefix(""));
+  CHECK_EQUAL(4u, words_.count_prefix("ca"));
+  CHECK_EQUAL(2u, words_.count_prefix("car"));
+  CHECK_EQUAL(1u, words_.count_prefix("cart"));
+  CHECK_EQUAL(0u, words_.count_prefix("carts"));
+  CHECK_EQUAL(0u, words_.count_prefix("x"));
+}
+
+TEST_FIXTURE(WordMapTestFixture, CountPrefix_InsertAndErase_CountsKept)
+{
+  Insert("cab", 0);
+  CHECK_EQUAL(5u, words_.count_prefix("ca"));
+  CHECK_EQUAL(1u, words_.rank("car"));
+  CHECK_EQUAL("cab", words_.select(0)->first);
+
+  words_.erase("cart");
+  CHECK_EQUAL(4u, words_.count_prefix("ca"));
+  CHECK_EQUAL(1u, words_.count_prefix("car"));
+  CHECK_EQUAL("cast", words_.select(2)->first);
+}
+
+//// find_prefixes
+TEST_FIXTURE(WordMapTestFixture, FindPrefixes_Text_KeysItBeginsWithShortestFirst)
+{
+  const std::string s("cartwheel");
+  CHECK_EQUAL("car|cart", Join(words_.find_prefixes(s.begin(), s.end())));
+}
+
+TEST_FIXTURE(WordMapTestFixture, FindPrefixes_TextIsKey_KeyIncluded)
+{
+  const std::string s("dog");
+  CHECK_EQUAL("dog", Join(words_.find_prefixes(s.begin(), s.end())));
+}
+
+TEST_FIXTURE(WordMapTestFixture, FindPrefixes_NoKeyIsPrefix_None)
+{
+  const std::string s("ca");
+  CHECK(words_.find_prefixes(s.begin(), s.end()).empty());
+  const std::string t("bird");
+  CHECK(words_.find_prefixes(t.begin(), t.end()).empty());
+}
+
+//// pattern_find
+TEST_FIXTURE(WordMapTestFixture, PatternFind_AnyCharacter_KeysInOrder)
+{
+  CHECK_EQUAL("car|cat", Join(words_.pattern_find("ca?")));
+  CHECK_EQUAL("cart|cast", Join(words_.pattern_find("ca??")));
+  CHECK(words_.pattern_find("?").empty());
+}
+
+TEST_FIXTURE(WordMapTestFixture, PatternFind_Star_AnyRun)
+{
+  CHECK_EQUAL("car|cart|cast|cat", Join(words_.pattern_find("ca*")));
+  CHECK_EQUAL("cart|cast|cat", Join(words_.pattern_find("c*t")));
+  CHECK_EQUAL("car|cart|cast|cat|dog", Join(words_.pattern_find("**")));
+}
+
+TEST_FIXTURE(WordMapTestFixture, PatternFind_Class_MembersAndRanges)
+{
+  CHECK_EQUAL("car|cat", Join(words_.pattern_find("ca[rt]")));
+  CHECK_EQUAL("cast|cat", Join(words_.pattern_find("ca[s-z]*")));
+  CHECK_EQUAL("car|dog", Join(words_.pattern_find("[^x]*[^st]")));
+  CHECK_EQUAL("cat", Join(words_.pattern_find("ca[^r]")));
+}
+
+TEST_FIXTURE(WordMapTestFixture, PatternFind_Escaped_Literal)
+{
+  Insert("c*t", 0);
+  Insert("c?", 0);
+  CHECK_EQUAL("c*t", Join(words_.pattern_find("c\\*t")));
+  CHECK_EQUAL("c?", Join(words_.pattern_find("c\\?")));
+}
+
+//// approximate_join
+// the pairs found as first-second:distance, separated by '|'
+static std::string
+JoinPairs(const std::vector<word_map::approximate_pair>& rgPairs)
+{
+  std::string s;
+  for(std::vector<word_map::approximate_pair>::const_iterator it = rgPairs.begin(); it != rgPairs.end(); ++it)
+  {
+      if(it != rgPairs.begin())
+      {
+          s += '|';
+      }
+      s += it->first->first + '-' + it->second->first + ':' + static_cast<char>('0' + it->distance);
+  }
+  return s;
+}
+
+TEST(ApproximateJoin_TwoTries_PairsWithinDistance)
+{
+  word_map words;
+  words.insert(word_map::value_type("cat", 0));
+  words.insert(word_map::value_type("dog", 0));
+  word_map other;
+  other.insert(word_map::value_type("cut", 0));
+  other.insert(word_map::value_type("cot", 0));
+  other.insert(word_map::value_type("dig", 0));
+  other.insert(word_map::value_type("act", 0));
+  other.insert(word_map::value_type("bird", 0));
+
+  CHECK_EQUAL("cat-act:1|cat-cot:1|cat-cut:1|dog-dig:1", JoinPairs(words.approximate_join(other, 1)));
+  CHECK_EQUAL("", JoinPairs(words.approximate_join(other, 0)));
+  CHECK_EQUAL("cat-act:1|cat-cot:1|cat-cut:1|cat-dig:3|dog-dig:1|dog-cot:2|dog-act:3|dog-cut:3",
+              JoinPairs(words.approximate_join(other, 3)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, ApproximateJoin_Itself_EachPairOnce)
+{
+  CHECK_EQUAL("cart-car:1|cast-cart:1|cat-car:1|cat-cart:1|cat-cast:1", JoinPairs(words_.approximate_join(words_, 1)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, ApproximateJoin_Copy_SameKeysAtDistance0)
+{
+  word_map copy(words_);
+  std::vector<word_map::approximate_pair> rgPairs = words_.approximate_join(copy, 0);
+  CHECK_EQUAL(words_.size(), rgPairs.size());
+  for(std::vector<word_map::approximate_pair>::const_iterator it = rgPairs.begin(); it != rgPairs.end(); ++it)
+  {
+      CHECK_EQUAL(it->first->first, it->second->first);
+  }
+}
+
+//// merge, intersect, subtract and the set operations
+struct WordMapPairTestFixture : public WordMapTestFixture
+{
+  //Setup
+  WordMapPairTestFixture()
+  {
+      other_.insert(word_map::value_type("car", 7));
+      other_.insert(word_map::value_type("ca", 3));
+      other_.insert(word_map::value_type("cow", 2));
+      other_.insert(word_map::value_type("dog", 9));
+  }
+
+  word_map other_;
+};
+
+TEST_FIXTURE(WordMapPairTestFixture, Merge_Unique_KeysPresentKeptOthersMovedIn)
+{
+  words_.merge(other_);
+  CHECK_EQUAL("ca=3|car=50|cart=10|cast=1|cat=5|cow=2|dog=100", Entries(words_));
+  CHECK(other_.empty());
+  CHECK_EQUAL(7u, words_.size());
+  CHECK_EQUAL(5u, words_.count_prefix("ca"));
+  CHECK_EQUAL("dog|car|cart", Join(words_.complete("", 3)));
+}
+
+TEST_FIXTURE(WordMapPairTestFixture, Intersect_Unique_KeysInBoth)
+{
+  words_.intersect(other_);
+  CHECK_EQUAL("car=50|dog=100", Entries(words_));
+  CHECK_EQUAL(4u, other_.size());
+  CHECK_EQUAL(1u, words_.count_prefix("ca"));
+}
+
+TEST_FIXTURE(WordMapPairTestFixture, Subtract_Unique_KeysOnlyInFirst)
+{
+  words_.subtract(other_);
+  CHECK_EQUAL("cart=10|cast=1|cat=5", Entries(words_));
+  CHECK_EQUAL("cart", words_.select(0)->first);
+  CHECK_EQUAL(0u, words_.count_prefix("d"));
+}
+
+TEST_FIXTURE(WordMapPairTestFixture, SetUnion_Unique_ArgumentsLeftAsTheyWere)
+{
+  word_map u = set_union(words_, other_);
+  CHECK_EQUAL("ca=3|car=50|cart=10|cast=1|cat=5|cow=2|dog=100", Entries(u));
+  CHECK_EQUAL(5u, words_.size());
+  CHECK_EQUAL(4u, other_.size());
+  CHECK_EQUAL("ca=3|car=7|cow=2|dog=9", Entries(other_));
+  CHECK_EQUAL(5u, u.count_prefix("ca"));
+  CHECK_EQUAL(3u, u.rank("cast"));
+
+  // the copies are the union's own
+  u.erase("cow");
+  CHECK(other_.find("cow") != other_.end());
+}
+
+TEST_FIXTURE(WordMapPairTestFixture, SetIntersectionAndDifference_Unique_ArgumentsLeftAsTheyWere)
+{
+  CHECK_EQUAL("car=50|dog=100", Entries(set_intersection(words_, other_)));
+  CHECK_EQUAL("cart=10|cast=1|cat=5", Entries(set_difference(words_, other_)));
+  CHECK_EQUAL(5u, words_.size());
+}
+
+TEST_FIXTURE(WordMapPairTestFixture, InsertTrie_Itself_Unchanged)
+{
+  words_.insert(words_);
+  CHECK_EQUAL("car=50|cart=10|cast=1|cat=5|dog=100", Entries(words_));
+}
+
+TEST(SetUnion_Equal_EveryValueKept)
+{
+  typedef trie::trie_multimap<std::string, unsigned int> word_multimap;
+  word_multimap words;
+  words.insert(word_multimap::value_type("car", 1));
+  words.insert(word_multimap::value_type("cat", 2));
+  word_multimap other;
+  other.insert(word_multimap::value_type("car", 3));
+  other.insert(word_multimap::value_type("dog", 4));
+
+  word_multimap u = set_union(words, other);
+  CHECK_EQUAL(4u, u.size());
+  CHECK_EQUAL(2u, u.count("car"));
+  CHECK_EQUAL(2u, u.count_prefix("car"));
+  CHECK_EQUAL(2u, words.size());
+  CHECK_EQUAL(2u, other.size());
+
+  CHECK_EQUAL(2u, set_intersection(u, other).size());
+  CHECK_EQUAL(2u, set_difference(u, other).size());
+
+  u.insert(u);
+  CHECK_EQUAL(8u, u.size());
+  CHECK_EQUAL(4u, u.count("car"));
+}
+
+//// for_each
+// collects key=value for each value visited, separated by '|'
+struct EntryCollector
+{
+  void operator()(const char* first, const char* last, const word_map::value_type& entry)
+  {
+      if(!s.empty())
+      {
+          s += '|';
+      }
+      s.append(first, last);
+      s += '=';
+      s += (entry.first == std::string(first, last)) ? "key" : "other";
+  }
+
+  std::string s;
+};
+
+// doubles each value it is handed
+struct ValueDoubler
+{
+  void operator()(const char*, const char*, word_map::value_type& entry)
+  {
+      entry.second *= 2;
+  }
+};
+
+TEST_FIXTURE(WordMapTestFixture, ForEach_Trie_EveryValueInOrderWithItsKey)
+{
+  CHECK_EQUAL("car=key|cart=key|cast=key|cat=key|dog=key", words_.for_each(EntryCollector()).s);
+}
+
+TEST_FIXTURE(WordMapTestFixture, ForEach_EmptyTrie_NoCalls)
+{
+  CHECK_EQUAL("", word_map().for_each(EntryCollector()).s);
+  words_.clear();
+  CHECK_EQUAL("", words_.for_each(EntryCollector()).s);
+}
+
+TEST_FIXTURE(WordMapTestFixture, ForEach_EmptyKey_EmptyRange)
+{
+  Insert("", 3);
+  CHECK_EQUAL("=key|car=key|cart=key|cast=key|cat=key|dog=key", words_.for_each(EntryCollector()).s);
+}
+
+TEST_FIXTURE(WordMapTestFixture, ForEach_NonConst_ValuesChanged)
+{
+  words_.for_each(ValueDoubler());
+  CHECK_EQUAL("car=100|cart=20|cast=2|cat=10|dog=200", Entries(words_));
+}
+
+TEST_FIXTURE(WordMapTestFixture, OperatorEqual_SameValues_Equal)
+{
+  word_map copy(words_);
+  CHECK(copy == words_);
+  CHECK(!(copy != words_));
+
+  copy["cat"] = 6;
+  CHECK(!(copy == words_));
+  copy["cat"] = 5;
+  CHECK(copy == words_);
+
+  copy.erase("cart");
+  CHECK(!(copy == words_));
+  CHECK(!(words_ == copy));
+  CHECK(!(word_map() == words_));
+}
+
+//// partition
+TEST_FIXTURE(WordMapTestFixture, Partition_Trie_RangesInOrderCoverEveryValue)
+{
+  typedef std::vector< std::pair<word_map::iterator, word_map::iterator> > ranges;
+  ranges rgRanges = words_.partition(2);
+  CHECK_EQUAL(2u, rgRanges.size());
+  CHECK(rgRanges.front().first == words_.begin());
+  CHECK(rgRanges.back().second == words_.end());
+
+  std::string s;
+  for(ranges::const_iterator it = rgRanges.begin(); it != rgRanges.end(); ++it)
+  {
+      s += '[';
+      for(word_map::iterator itWord = it->first; itWord != it->second; ++itWord)
+      {
+          s += itWord->first + ' ';
+      }
+      s += ']';
+  }
+  CHECK_EQUAL("[car cart ][cast cat dog ]", s);
+}
+
+TEST_FIXTURE(WordMapTestFixture, Partition_Trie_SizesDifferByAtMostOne)
+{
+  for(word_map::size_type n = 1; n <= words_.size(); ++n)
+  {
+      std::vector< std::pair<word_map::const_iterator, word_map::const_iterator> > rgRanges = 
+          static_cast<const word_map&>(words_).partition(n);
+      CHECK_EQUAL(n, rgRanges.size());
+      for(size_t i = 0; i != rgRanges.size(); ++i)
+      {
+          size_t nSize = std::distance(rgRanges[i].first, rgRanges[i].second);
+          CHECK(nSize == words_.size() / n || nSize == words_.size() / n + 1);
+          if(i != 0)
+          {
+              CHECK(rgRanges[i-1].second == rgRanges[i].first);
+          }
+      }
+  }
+}
+
+TEST_FIXTURE(WordMapTestFixture, Partition_MoreThanThereAre_OneValueEach)
+{
+  CHECK_EQUAL(5u, words_.partition(10).size());
+  CHECK(words_.partition(0).empty());
+  CHECK(word_map().partition(4).empty());
+}
+
+//// compact
+TEST_FIXTURE(WordMapTestFixture, Compact_Trie_SameValuesAndCounts)
+{
+  word_map copy(words_);
+  words_.compact();
+  CHECK(copy == words_);
+  CHECK_EQUAL("car=50|cart=10|cast=1|cat=5|dog=100", Entries(words_));
+  CHECK_EQUAL(4u, words_.count_prefix("ca"));
+  CHECK_EQUAL(2u, words_.rank("cast"));
+  CHECK_EQUAL("cart", words_.select(1)->first);
+  CHECK_EQUAL("car|cart|cat", Join(words_.complete("ca", 3)));
+  CHECK_EQUAL("car|cart|cast|cat", Join(words_.approximate_find("cat", 1)));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Compact_Trie_OneBlockNodeForEachNode)
+{
+  words_.compact();
+  // the keys c a r t s t t d o g and the five values
+  CHECK_EQUAL(15u, words_.block_node_count());
+  CHECK_EQUAL(0u, words_.free_node_count());
+
+  // compacting again lays it out anew and lets the old blocks go
+  words_.compact();
+  CHECK_EQUAL(15u, words_.block_node_count());
+}
+
+TEST_FIXTURE(WordMapTestFixture, Compact_ThenInsertAndErase_StillATrie)
+{
+  words_.compact();
+  Insert("cab", 2);
+  words_.erase("cart");
+  words_.erase("dog");
+  CHECK_EQUAL("cab=2|car=50|cast=1|cat=5", Entries(words_));
+  CHECK_EQUAL(4u, words_.count_prefix("ca"));
+  CHECK_EQUAL("car|cat", Join(words_.complete("", 2)));
+
+  words_.compact();
+  CHECK_EQUAL("cab=2|car=50|cast=1|cat=5", Entries(words_));
+}
+
+TEST_FIXTURE(WordMapTestFixture, Compact_Emptied_BlocksGivenBack)
+{
+  words_.compact();
+  words_.erase(words_.begin(), words_.end());
+  words_.compact();
+  CHECK(words_.empty());
+  CHECK_EQUAL(0u, words_.block_node_count());
+  CHECK_EQUAL(0u, words_.free_node_count());
+
+  word_map().compact();
+}
+
+//// free list and compact threshold
+TEST_FIXTURE(WordMapTestFixture, FreeList_EraseFromBlocks_NodesFreed)
+{
+  words_.compact();
+  // d o g and its value
+  words_.erase("dog");
+  CHECK_EQUAL(4u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+
+  // c a r t and car are still used by the words left, so only t and the
+  // value of cart are freed
+  words_.erase(words_.find("cart"));
+  CHECK_EQUAL(6u, words_.free_node_count());
+  CHECK_EQUAL("car=50|cast=1|cat=5", Entries(words_));
+}
+
+TEST_FIXTURE(WordMapTestFixture, FreeList_EraseNotCompacted_NothingFreed)
+{
+  // nodes that were never laid out in a block are given back as they are
+  // erased
+  words_.erase("dog");
+  CHECK_EQUAL(0u, words_.free_node_count());
+  CHECK_EQUAL(0u, words_.block_node_count());
+}
+
+TEST_FIXTURE(WordMapTestFixture, FreeList_InsertAfterErase_FreeNodesReused)
+{
+  words_.compact();
+  words_.erase("dog");
+  Insert("dig", 7);
+  CHECK_EQUAL(0u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+  CHECK_EQUAL("car=50|cart=10|cast=1|cat=5|dig=7", Entries(words_));
+
+  // once the free list is used up new nodes come from the heap again
+  Insert("dug", 3);
+  CHECK_EQUAL(0u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+  CHECK_EQUAL(3u, words_.find("dug")->second);
+}
+
+TEST_FIXTURE(WordMapTestFixture, CompactThreshold_Default_NeverCompacts)
+{
+  CHECK_EQUAL(0.0, words_.compact_threshold());
+  words_.compact();
+  words_.erase("dog");
+  words_.erase("cart");
+  CHECK_EQUAL(6u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+}
+
+TEST_FIXTURE(WordMapTestFixture, CompactThreshold_EraseByKeyPastIt_Compacts)
+{
+  words_.set_compact_threshold(0.3);
+  words_.compact();
+
+  // 2 of 15 free is under the threshold
+  words_.erase("cart");
+  CHECK_EQUAL(2u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+
+  // 6 of 15 is over it, so the 9 nodes left are laid out anew
+  words_.erase("dog");
+  CHECK_EQUAL(0u, words_.free_node_count());
+  CHECK_EQUAL(9u, words_.block_node_count());
+  CHECK_EQUAL("car=50|cast=1|cat=5", Entries(words_));
+}
+
+TEST_FIXTURE(WordMapTestFixture, CompactThreshold_EraseByIterator_NeverCompacts)
+{
+  // an iterator erase leaves the other iterators valid, so it doesn't
+  // compact however many nodes are free
+  words_.set_compact_threshold(0.1);
+  words_.compact();
+  word_map::iterator itCat = words_.find("cat");
+  words_.erase(words_.find("dog"));
+  words_.erase(words_.find("cart"));
+  CHECK_EQUAL(6u, words_.free_node_count());
+  CHECK_EQUAL(15u, words_.block_node_count());
+  CHECK_EQUAL(5u, itCat->second);
+}
+
+TEST_FIXTURE(WordMapTestFixture, CompactThreshold_CopyAssignAndSwap_Carried)
+{
+  words_.set_compact_threshold(0.25);
+
+  word_map copy(words_);
+  CHECK_EQUAL(0.25, copy.compact_threshold());
+
+  word_map assigned;
+  assigned = words_;
+  CHECK_EQUAL(0.25, assigned.compact_threshold());
+
+  word_map other;
+  other.swap(words_);
+  CHECK_EQUAL(0.25, other.compact_threshold());
+  CHECK_EQUAL(0.0, words_.compact_threshold());
+}
+
+// a value whose copies throw once the copies allowed run out
+struct FragileValue
+{
+  explicit FragileValue(unsigned int n) : n_(n) {}
+  FragileValue(const FragileValue& other) : n_(other.n_)
+  {
+      if(s_cCopiesLeft == 0)
+      {
+          throw std::runtime_error("copy");
+      }
+      if(s_cCopiesLeft > 0)
+      {
+          --s_cCopiesLeft;
+      }
+  }
+
+  bool operator==(const FragileValue& other) const
+  {
+      return n_ == other.n_;
+  }
+
+  unsigned int n_;
+  static int s_cCopiesLeft; // -1 for no end
+};
+
+int FragileValue::s_cCopiesLeft = -1;
+
+TEST(Compact_CopyThrows_TrieAsItWas)
+{
+  typedef trie::trie_map<std::string, FragileValue> fragile_map;
+  fragile_map words;
+  words.insert(fragile_map::value_type("car", FragileValue(1)));
+  words.insert(fragile_map::value_type("cart", FragileValue(2)));
+  words.insert(fragile_map::value_type("dog", FragileValue(3)));
+  fragile_map copy(words);
+
+  FragileValue::s_cCopiesLeft = 1;
+  CHECK_THROW(words.compact(), std::runtime_error);
+  FragileValue::s_cCopiesLeft = -1;
+
+  CHECK(copy == words);
+  CHECK_EQUAL(0u, words.block_node_count());
+  CHECK_EQUAL(2u, words.find("cart")->second.n_);
+
+  words.compact();
+  CHECK(copy == words);
+  CHECK_EQUAL(10u, words.block_node_count());
+}
+
+//// counted multiset
+typedef trie::trie_counted_multiset<std::string> counted_words;
+
+// every occurrence in order, separated by '|'
+template <class _Iterator>
+static std::string Occurrences(_Iterator first, _Iterator last)
+{
+  std::string s;
+  for(_Iterator it = first; it != last; ++it)
+  {
+      if(it != first)
+      {
+          s += '|';
+      }
+      s += *it;
+  }
+  return s;
+}
+
+struct CountedMultisetTestFixture{
+  //Setup
+  CountedMultisetTestFixture()
+  {
+      words_.insert("cat");
+      words_.insert("car");
+      words_.insert("cat");
+      words_.insert("cart", 3);
+  }
+
+  counted_words words_;
+};
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_Insert_EachKeyOnceWithItsCount)
+{
+  CHECK_EQUAL(6u, words_.size());
+  CHECK_EQUAL(3u, words_.distinct_size());
+  CHECK_EQUAL(1u, words_.count("car"));
+  CHECK_EQUAL(3u, words_.count("cart"));
+  CHECK_EQUAL(2u, words_.count("cat"));
+  CHECK_EQUAL(0u, words_.count("ca"));
+  CHECK_EQUAL(3u, words_.find("cart").count());
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_InsertNone_NothingInserted)
+{
+  CHECK(words_.insert("dog", 0) == words_.end());
+  CHECK(words_.find("dog") == words_.end());
+  CHECK_EQUAL(0u, words_.count("dog"));
+  CHECK_EQUAL(3u, words_.distinct_size());
+
+  CHECK(words_.insert("cat", 0) == words_.find("cat"));
+  CHECK_EQUAL(2u, words_.count("cat"));
+  CHECK_EQUAL(6u, words_.size());
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_Iterate_EveryOccurrence)
+{
+  CHECK_EQUAL("car|cart|cart|cart|cat|cat", Occurrences(words_.begin(), words_.end()));
+  CHECK_EQUAL("cat|cat|cart|cart|cart|car", Occurrences(words_.rbegin(), words_.rend()));
+  CHECK_EQUAL(6, std::distance(words_.begin(), words_.end()));
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_EqualRange_EveryOccurrenceOfTheKey)
+{
+  std::pair<counted_words::iterator, counted_words::iterator> range = words_.equal_range("cart");
+  CHECK_EQUAL("cart|cart|cart", Occurrences(range.first, range.second));
+
+  range = words_.equal_range("cas");
+  CHECK(range.first == range.second);
+  CHECK_EQUAL("cat", *range.first);
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_EraseOccurrence_CountLowered)
+{
+  words_.erase(words_.find("cart"));
+  CHECK_EQUAL(2u, words_.count("cart"));
+  CHECK_EQUAL(5u, words_.size());
+
+  // the key goes with its last occurrence
+  words_.erase(words_.find("car"));
+  CHECK(words_.find("car") == words_.end());
+  CHECK_EQUAL(2u, words_.distinct_size());
+  CHECK_EQUAL("cart|cart|cat|cat", Occurrences(words_.begin(), words_.end()));
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_EraseKey_EveryOccurrence)
+{
+  CHECK_EQUAL(3u, words_.erase("cart"));
+  CHECK_EQUAL(0u, words_.erase("dog"));
+  CHECK_EQUAL(3u, words_.size());
+  CHECK_EQUAL("car|cat|cat", Occurrences(words_.begin(), words_.end()));
+}
+
+TEST_FIXTURE(CountedMultisetTestFixture, CountedMultiset_EraseRange_OccurrencesInIt)
+{
+  // from the second cart up to the second cat
+  counted_words::iterator first = words_.find("cart");
+  ++first;
+  counted_words::iterator last = words_.find("cat");
+  ++last;
+  words_.erase(first, last);
+  CHECK_EQUAL("car|cart|cat", Occurrences(words_.begin(), words_.end()));
+  CHECK_EQUAL(3u, words_.size());
+
+  words_.erase(words_.begin(), words_.end());
+  CHECK(words_.empty());
+  CHECK_EQUAL(0u, words_.distinct_size());
+}
+
+//// grouped multimap
+typedef trie::trie_grouped_multimap<std::string, int> grouped_words;
+
+// the values in order, separated by '|'
+static std::string Values(const std::pair<grouped_words::value_iterator, grouped_words::value_iterator>& range)
+{
+  std::ostringstream s;
+  for(grouped_words::value_iterator it = range.first; it != range.second; ++it)
+  {
+      if(it != range.first)
+      {
+          s << '|';
+      }
+      s << *it;
+  }
+  return s.str();
+}
+
+struct GroupedMultimapTestFixture{
+  //Setup
+  GroupedMultimapTestFixture()
+  {
+      words_.insert(grouped_words::value_type("cat", 1));
+      words_.insert(grouped_words::value_type("car", 2));
+      words_.insert(grouped_words::value_type("cat", 3));
+      words_.insert(grouped_words::value_type("cat", 4));
+  }
+
+  grouped_words words_;
+};
+
+TEST_FIXTURE(GroupedMultimapTestFixture, GroupedMultimap_EqualRange_ValuesInTheOrderInserted)
+{
+  CHECK_EQUAL("1|3|4", Values(words_.equal_range("cat")));
+  CHECK_EQUAL("2", Values(words_.equal_range("car")));
+  CHECK_EQUAL(3u, words_.count("cat"));
+  CHECK_EQUAL(4u, words_.size());
+  CHECK_EQUAL(2u, words_.distinct_size());
+}
+
+TEST_FIXTURE(GroupedMultimapTestFixture, GroupedMultimap_EqualRangeOfMissingKey_Empty)
+{
+  CHECK_EQUAL("", Values(words_.equal_range("ca")));
+  CHECK_EQUAL("", Values(words_.equal_range("dog")));
+  CHECK_EQUAL(0u, words_.count("dog"));
+
+  const grouped_words& words = words_;
+  CHECK(words.equal_range("dog").first == words.equal_range("dog").second);
+  CHECK_EQUAL(3, std::distance(words.equal_range("cat").first, words.equal_range("cat").second));
+}
+
+TEST_FIXTURE(GroupedMultimapTestFixture, GroupedMultimap_EraseValue_GroupGoesWithItsLast)
+{
+  grouped_words::iterator itCat = words_.find("cat");
+  words_.erase(itCat, itCat->second.begin() + 1);
+  CHECK_EQUAL("1|4", Values(words_.equal_range("cat")));
+  CHECK_EQUAL(3u, words_.size());
+
+  grouped_words::iterator itCar = words_.find("car");
+  words_.erase(itCar, itCar->second.begin());
+  CHECK(words_.find("car") == words_.end());
+  CHECK_EQUAL(1u, words_.distinct_size());
+}
+
+TEST_FIXTURE(GroupedMultimapTestFixture, GroupedMultimap_EraseKey_AllItsValues)
+{
+  CHECK_EQUAL(3u, words_.erase("cat"));
+  CHECK_EQUAL(0u, words_.erase("cat"));
+  CHECK_EQUAL("", Values(words_.equal_range("cat")));
+  CHECK_EQUAL(1u, words_.size());
+}
@@ -56,38 +56,31 @@ public:
 
     bool SaveWordsToFile(const SpellDictionary::wordlist_type & dictionary)
     {
-        if(IsReadOnly())
+        if (!BeginSavingWords())
+            return false;
+
+        if (!dictionary.for_each(WordSaver(this)).IsSaved())
         {
             return false;
         }
 
-        if (!SaveWordsToFileSetup())
-            return false;
+        return EndSavingWords();
+    }
 
-        if(HasFileChanged())
-        {
-            // if the file has changed since the last time we read
-            // it, then we can't save the file unless we re-read it first
+    bool SaveWordsToFile(SpellDictionary::VariantWords & words)
+    {
+        if (!BeginSavingWords())
             return false;
-        }
 
-        for(SpellDictionary::wordlist_type::const_iterator it = dictionary.begin(); 
-            it != dictionary.end(); 
-            ++it)
+        for(; !words.AtEnd(); words.Next())
         {
-            if (!SaveWordToFile(*it))
+            if (!SaveWordToFile(words->first, words->second))
             {
                 return false;
             }
         }
 
-        if (!SaveWordsToFileTeardown())
-        {
-            return false;
-        }
-
-        SetLastKnownWrite();
-        return true;
+        return EndSavingWords();
     }
 
     bool GetWordsFromFile(SpellDictionary::wordlist_type & dictionary)
@@ -101,7 +94,8 @@ public:
 
         while(FileHasAnotherWord())
         {
-            dictionary.insert(Normalize::ToNFD(GetNextWordFromFile()));
+            std::basic_string<gunichar> word = Normalize::ToNFD(GetNextWordFromFile());
+            dictionary.insert(SpellDictionary::wordlist_type::value_type(word, GetNextWordFrequencyFromFile()));
         }
 
         if(!GetWordsFromFileTeardown())
@@ -120,16 +114,75 @@ protected:
 
     virtual bool SaveWordsToFileSetup() = 0;
     // if returns false, should do teardown
-    virtual bool SaveWordToFile(std::basic_string<gunichar> s) = 0;
+    // nFrequency is 0 when the frequency of the word is unknown
+    virtual bool SaveWordToFile(std::basic_string<gunichar> s, unsigned int nFrequency) = 0;
     // teardown will only be called if all calls to SaveWordToFileCore return true;
     virtual bool SaveWordsToFileTeardown() = 0;
 
     virtual bool GetWordsFromFileSetup() = 0;
     virtual bool FileHasAnotherWord() = 0;
     virtual std::basic_string<gunichar> GetNextWordFromFile() = 0;
+    // formats which don't record frequencies can leave this alone
+    virtual unsigned int GetNextWordFrequencyFromFile() { return 0; }
     virtual bool GetWordsFromFileTeardown() = 0;
 
 private:
+    // saves each word as the word list is walked (see trie_map::for_each),
+    // stopping at the first that fails
+    class WordSaver
+    {
+    public:
+        WordSaver(DictionaryFileBase* pFile) : pFile_(pFile), fSaved_(true) {}
+
+        void operator()(const gunichar*, const gunichar*, 
+                        const SpellDictionary::wordlist_type::value_type& entry)
+        {
+            if(fSaved_)
+            {
+                fSaved_ = pFile_->SaveWordToFile(entry.first, entry.second);
+            }
+        }
+
+        bool IsSaved() const
+        {
+            return fSaved_;
+        }
+
+    private:
+        DictionaryFileBase* pFile_;
+        bool fSaved_;
+    };
+
+    bool BeginSavingWords()
+    {
+        if(IsReadOnly())
+        {
+            return false;
+        }
+
+        // before the file is opened, which creates it when it isn't there
+        // yet (a new personal word list) and so would change it
+        if(HasFileChanged())
+        {
+            // if the file has changed since the last time we read
+            // it, then we can't save the file unless we re-read it first
+            return false;
+        }
+
+        return SaveWordsToFileSetup();
+    }
+
+    bool EndSavingWords()
+    {
+        if (!SaveWordsToFileTeardown())
+        {
+            return false;
+        }
+
+        SetLastKnownWrite();
+        return true;
+    }
+
     void SetLastKnownWrite()
     {
         _ftLastKnownWrite = GetLastKnownWrite();
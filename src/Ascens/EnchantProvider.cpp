@@ -19,6 +19,9 @@
 #include "XmlDictionaryFile.h"
 #include "LineDictionaryFile.h"
 
+#include <map>
+#include <climits>
+
 #pragma warning(suppress: 4100) //unreferenced formal parameter
 ENCHANT_PLUGIN_DECLARE("ascens")
 
@@ -118,6 +121,45 @@ ascens_dict_suggest (EnchantDict * me, const char *const word,
     return ascens_stringvector_to_stringlist(suggestions);
 }
 
+static void
+ascens_dict_add_to_personal (EnchantDict * me, const char *const word, size_t len)
+{
+    SpellDictionary* pDictionary = reinterpret_cast<SpellDictionary*>(me->user_data);
+    try
+    {
+        pDictionary->AddPersonalWordUtf8(std::string(word, len));
+    }
+    catch(...)
+    {
+    }
+}
+
+static void
+ascens_dict_add_to_session (EnchantDict * me, const char *const word, size_t len)
+{
+    SpellDictionary* pDictionary = reinterpret_cast<SpellDictionary*>(me->user_data);
+    try
+    {
+        pDictionary->AddSessionWordUtf8(std::string(word, len));
+    }
+    catch(...)
+    {
+    }
+}
+
+static void
+ascens_dict_add_to_exclude (EnchantDict * me, const char *const word, size_t len)
+{
+    SpellDictionary* pDictionary = reinterpret_cast<SpellDictionary*>(me->user_data);
+    try
+    {
+        pDictionary->ExcludeWordUtf8(std::string(word, len));
+    }
+    catch(...)
+    {
+    }
+}
+
 static GKeyFile*
 ascens_get_settings_file(const char *const language_id, gchar** full_path)
 {
@@ -141,6 +183,14 @@ ascens_get_settings_file(const char *const language_id, gchar** full_path)
 const char * DICTIONARY_SETTING_FILEPATH = "Path";
 const char * DICTIONARY_SETTING_TYPE = "Type";
 const char * DICTIONARY_SETTING_XPATH = "XPath";
+const char * DICTIONARY_SETTING_COMPOUND_MAX_PARTS = "CompoundMaxParts";
+const char * DICTIONARY_SETTING_COMPOUND_MIN_PART_LENGTH = "CompoundMinPartLength";
+const char * DICTIONARY_SETTING_COMPOUND_LINKING_MORPHEMES = "CompoundLinkingMorphemes";
+const char * DICTIONARY_SETTING_BASE = "Base";
+const char * DICTIONARY_SETTING_UTF8_INDEX = "Utf8Index";
+const char * DICTIONARY_SETTING_EXACT_INDEX = "ExactIndex";
+const char * DICTIONARY_SETTING_EXACT_HASH = "ExactHash";
+const char * DICTIONARY_SETTING_BLOOM_FILTER = "BloomFilter";
 
 static std::string
 ascens_get_setting_value(GKeyFile* key_file, const gchar* key)
@@ -152,12 +202,60 @@ ascens_get_setting_value(GKeyFile* key_file, const gchar* key)
                                             "Dictionary",
                                             key,
                                             NULL);
-        value = std::string(s);
-        g_free(s);
+        if(s != NULL)
+        {
+            value = std::string(s);
+            g_free(s);
+        }
     }
     return value;
 }
 
+// returns default_value if the setting isn't there or isn't between
+// min_value and max_value
+static int
+ascens_get_setting_integer(GKeyFile* key_file, const gchar* key, int default_value, int min_value, int max_value)
+{
+    int value = default_value;
+    if(key_file != NULL && g_key_file_has_key(key_file, "Dictionary", key, NULL))
+    {
+        GError* error = NULL;
+        int v = g_key_file_get_integer(key_file, "Dictionary", key, &error);
+        if(error == NULL)
+        {
+            if(v >= min_value && v <= max_value)
+            {
+                value = v;
+            }
+        }
+        else
+        {
+            g_error_free(error);
+        }
+    }
+    return value;
+}
+
+// a ; separated list
+static std::vector<const std::basic_string<gunichar> >
+ascens_get_setting_list(GKeyFile* key_file, const gchar* key)
+{
+    std::vector<const std::basic_string<gunichar> > values;
+    if(key_file != NULL)
+    {
+        gchar** list = g_key_file_get_string_list(key_file, "Dictionary", key, NULL, NULL);
+        if(list != NULL)
+        {
+            for(gchar** s = list; *s != NULL; ++s)
+            {
+                values.push_back(Convert::ToUcs4(std::string(*s)));
+            }
+            g_strfreev(list);
+        }
+    }
+    return values;
+}
+
 static std::string
 ascens_get_absolute_path_relative_to_settings_file(const std::string &settings_file_path,
                           const std::string &relative_path)
@@ -208,10 +306,52 @@ ascens_provider_dictionary_exists (EnchantProvider *,
     return exists;
 }
 
-static EnchantDict *
-ascens_provider_request_dict (EnchantProvider *, const char *const language_id)
+// The dictionaries variants are taken from (the Base setting), each loaded
+// once and shared by its variants; and the base of each variant.
+struct ascens_base_dictionary
+{
+    SpellDictionary* pDictionary;
+    int cVariants;
+};
+static std::map<std::string, ascens_base_dictionary> ascens_base_dictionaries;
+static std::map<SpellDictionary*, std::string> ascens_variant_bases;
+
+static SpellDictionary* ascens_create_dictionary (const char *const language_id, bool allow_base);
+
+static SpellDictionary*
+ascens_request_base_dictionary (const std::string& language_id)
+{
+    std::map<std::string, ascens_base_dictionary>::iterator it = ascens_base_dictionaries.find(language_id);
+    if(it == ascens_base_dictionaries.end())
+    {
+        // a base is not a variant itself
+        ascens_base_dictionary base;
+        base.pDictionary = ascens_create_dictionary(language_id.c_str(), false);
+        base.cVariants = 0;
+        if(base.pDictionary == NULL)
+        {
+            return NULL;
+        }
+        it = ascens_base_dictionaries.insert(std::make_pair(language_id, base)).first;
+    }
+    ++it->second.cVariants;
+    return it->second.pDictionary;
+}
+
+static void
+ascens_release_base_dictionary (const std::string& language_id)
+{
+    std::map<std::string, ascens_base_dictionary>::iterator it = ascens_base_dictionaries.find(language_id);
+    if(it != ascens_base_dictionaries.end() && --it->second.cVariants == 0)
+    {
+        delete it->second.pDictionary;
+        ascens_base_dictionaries.erase(it);
+    }
+}
+
+static SpellDictionary*
+ascens_create_dictionary (const char *const language_id, bool allow_base)
 {
-	EnchantDict *dict;
     gchar* full_path;
     GKeyFile* settings_file = ascens_get_settings_file(language_id, &full_path);
 
@@ -227,6 +367,20 @@ ascens_provider_request_dict (EnchantProvider *, const char *const language_id)
     {
         xpath = ascens_get_setting_value(settings_file, DICTIONARY_SETTING_XPATH);
     }
+    int compound_max_parts = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_COMPOUND_MAX_PARTS, 1, 1, USHRT_MAX);
+    int compound_min_part_length = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_COMPOUND_MIN_PART_LENGTH, 3, 1, USHRT_MAX);
+    std::vector<const std::basic_string<gunichar> > compound_linking_morphemes = 
+        ascens_get_setting_list(settings_file, DICTIONARY_SETTING_COMPOUND_LINKING_MORPHEMES);
+    // the indexes are kept besides the word list, so each is asked for
+    int use_utf8_index = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_UTF8_INDEX, 0, 0, 1);
+    int use_exact_index = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_EXACT_INDEX, 0, 0, 1);
+    int use_exact_hash = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_EXACT_HASH, 0, 0, 1);
+    int use_bloom_filter = ascens_get_setting_integer(settings_file, DICTIONARY_SETTING_BLOOM_FILTER, 0, 0, 1);
+    std::string base_language_id;
+    if(allow_base)
+    {
+        base_language_id = ascens_get_setting_value(settings_file, DICTIONARY_SETTING_BASE);
+    }
 
     if(settings_file != NULL)
     {
@@ -259,14 +413,83 @@ ascens_provider_request_dict (EnchantProvider *, const char *const language_id)
     SpellDictionary * pSpellDictionary = new SpellDictionary();
     pSpellDictionary->SetSuggestionErrorTolerance(1);
     pSpellDictionary->SetSuggestionBestErrorTolerance(4);
-    pSpellDictionary->Load(pDictionaryFile);
+    pSpellDictionary->SetMaxSuggestions(15);
+    pSpellDictionary->SetCompoundMaxParts(static_cast<unsigned short>(compound_max_parts));
+    pSpellDictionary->SetCompoundMinPartLength(static_cast<unsigned short>(compound_min_part_length));
+    pSpellDictionary->SetCompoundLinkingMorphemes(compound_linking_morphemes);
+    pSpellDictionary->SetUseUtf8Index(use_utf8_index != 0); // enchant is UTF-8 in and out
+    pSpellDictionary->SetUseExactIndex(use_exact_index != 0);
+    pSpellDictionary->SetUseExactHash(use_exact_hash != 0);
+    pSpellDictionary->SetUseBloomFilter(use_bloom_filter != 0);
+
+    // a variant (en_GB of en_US, say) keeps only the words which differ
+    SpellDictionary* pBase = NULL;
+    if(!base_language_id.empty())
+    {
+        pBase = ascens_request_base_dictionary(base_language_id);
+    }
+    if(pBase != NULL)
+    {
+        ascens_variant_bases[pSpellDictionary] = base_language_id;
+        pSpellDictionary->LoadVariant(*pBase, pDictionaryFile);
+    }
+    else
+    {
+        pSpellDictionary->Load(pDictionaryFile);
+    }
+    return pSpellDictionary;
+}
+
+// the words added to a language's personal list are kept in the user's
+// config dir, apart from its dictionary (which may be shared or read only)
+static std::string
+ascens_get_personal_file_path (const char *const language_id)
+{
+    std::string path;
+
+    GSList *config_dirs = enchant_get_user_config_dirs ();
+    if (config_dirs != NULL)
+    {
+        gchar* dir = g_build_filename((const gchar *)config_dirs->data, "ascens", NULL);
+        g_mkdir_with_parents(dir, 0700);
+        gchar* name = g_strconcat(language_id, ".personal", NULL);
+        gchar* filename = g_build_filename(dir, name, NULL);
+        path = std::string(filename);
+        g_free(filename);
+        g_free(name);
+        g_free(dir);
+    }
+
+    g_slist_foreach (config_dirs, (GFunc)g_free, NULL);
+    g_slist_free (config_dirs);
+
+    return path;
+}
+
+static EnchantDict *
+ascens_provider_request_dict (EnchantProvider *, const char *const language_id)
+{
+	EnchantDict *dict;
+    SpellDictionary * pSpellDictionary = ascens_create_dictionary(language_id, true);
+    if(pSpellDictionary == NULL)
+    {
+        return NULL;
+    }
+
+    // only the dictionaries handed out have personal words, not the bases
+    // they share
+    std::string personal_path = ascens_get_personal_file_path(language_id);
+    if(!personal_path.empty())
+    {
+        pSpellDictionary->LoadPersonal(new LineDictionaryFile(personal_path));
+    }
 
     dict = g_new0 (EnchantDict, 1);
 	dict->check = ascens_dict_check;
 	dict->suggest = ascens_dict_suggest;
-    dict->add_to_exclude = NULL;
-    dict->add_to_session = NULL;
-    dict->add_to_personal = NULL;
+    dict->add_to_exclude = ascens_dict_add_to_exclude;
+    dict->add_to_session = ascens_dict_add_to_session;
+    dict->add_to_personal = ascens_dict_add_to_personal;
     dict->store_replacement = NULL;
     dict->user_data = pSpellDictionary;
 
@@ -317,7 +540,18 @@ static void
 ascens_provider_dispose_dict (EnchantProvider *, EnchantDict * dict)
 {
     SpellDictionary* pSpellDictionary = reinterpret_cast<SpellDictionary*>(dict->user_data);
+    std::string base_language_id;
+    std::map<SpellDictionary*, std::string>::iterator it = ascens_variant_bases.find(pSpellDictionary);
+    if(it != ascens_variant_bases.end())
+    {
+        base_language_id = it->second;
+        ascens_variant_bases.erase(it);
+    }
     delete pSpellDictionary;
+    if(!base_language_id.empty())
+    {
+        ascens_release_base_dictionary(base_language_id);
+    }
 	g_free (dict);
 }
 
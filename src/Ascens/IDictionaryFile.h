@@ -27,9 +27,14 @@ public:
     // return true if file is read only or format is read only
     virtual bool IsReadOnly() const = 0;
 
-    // returns true if was successfully able to save words to file
+    // returns true if was successfully able to save words (and their
+    // frequencies, if the format supports them) to file
     virtual bool SaveWordsToFile(const SpellDictionary::wordlist_type& dictionary) = 0;
 
+    // the same for the words of a variant (see SpellDictionary::LoadVariant),
+    // which are walked rather than kept in one word list
+    virtual bool SaveWordsToFile(SpellDictionary::VariantWords& words) = 0;
+
     // returns true if was successfully able to get words from file
     virtual bool GetWordsFromFile(SpellDictionary::wordlist_type & dictionary) = 0;
 };
\ No newline at end of file
@@ -12,6 +12,7 @@
  */
 #include "LineDictionaryFile.h"
 #include "Convert.h"
+#include <climits>
 bool 
 LineDictionaryFile::SaveWordsToFileSetup()
 {
@@ -37,11 +38,23 @@ LineDictionaryFile::SaveWordsToFileSetup()
   return true;
 }
 
+// a line is the word, optionally followed by a tab and its frequency
 bool 
-LineDictionaryFile::SaveWordToFile(std::basic_string<gunichar> s)
+LineDictionaryFile::SaveWordToFile(std::basic_string<gunichar> s, unsigned int nFrequency)
 {
     if(handle_ == NULL) { return false; }
 
+    if(nFrequency != 0)
+    {
+        std::basic_string<gunichar> digits;
+        for(; nFrequency != 0; nFrequency /= 10)
+        {
+            digits.insert(digits.begin(), '0' + nFrequency % 10);
+        }
+        s += '\t';
+        s += digits;
+    }
+
     try
     {
         if(fIsUtf8_) 
@@ -125,6 +138,7 @@ LineDictionaryFile::GetWordsFromFileSetup()
 
     switch(bom) {
         case WEOF:
+            fIsUtf8_ = true; // an empty file is written as a new one is
             GetWordsFromFileTeardown();
             return false;
             break;
@@ -183,6 +197,7 @@ LineDictionaryFile::FileHasAnotherWord()
         {
             nextWord_ = GetLineUtf16();
         }
+        nextFrequency_ = SplitFrequency(nextWord_);
     }
     // if line is empty (and we still have more to read on the file) start over
     while(nextWord_.empty() && feof(handle_) == 0);
@@ -200,6 +215,12 @@ LineDictionaryFile::GetNextWordFromFile()
     return nextWord_;
 }
 
+unsigned int 
+LineDictionaryFile::GetNextWordFrequencyFromFile()
+{
+    return nextFrequency_;
+}
+
 bool 
 LineDictionaryFile::GetWordsFromFileTeardown()
 {
@@ -233,6 +254,38 @@ LineDictionaryFile::TrimWhitespace(const std::basic_string<gunichar>& s)
     return result;
 }
 
+// removes a trailing tab separated frequency from the line and returns it
+// (0 if there isn't one, UINT_MAX if it is larger than that)
+unsigned int 
+LineDictionaryFile::SplitFrequency(std::basic_string<gunichar>& s)
+{
+    std::basic_string<gunichar>::size_type indexTab = s.rfind('\t');
+    if(indexTab == std::basic_string<gunichar>::npos || indexTab + 1 == s.length())
+    {
+        return 0;
+    }
+
+    unsigned int nFrequency = 0;
+    for(std::basic_string<gunichar>::size_type i = indexTab + 1; i != s.length(); ++i)
+    {
+        if(s[i] < '0' || s[i] > '9')
+        {
+            return 0; // not a frequency so leave the line alone
+        }
+        unsigned int nDigit = s[i] - '0';
+        if(nFrequency > (UINT_MAX - nDigit) / 10)
+        {
+            nFrequency = UINT_MAX; // saturate rather than wrap around
+        }
+        else
+        {
+            nFrequency = nFrequency * 10 + nDigit;
+        }
+    }
+
+    s = TrimWhitespace(s.substr(0, indexTab));
+    return nFrequency;
+}
 
 std::basic_string<gunichar>
 LineDictionaryFile::GetLineUtf8()
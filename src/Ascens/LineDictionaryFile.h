@@ -29,6 +29,7 @@ private:
     void Init()
     {
         handle_ = NULL;
+        fIsUtf8_ = true; // a file which isn't there yet is written as UTF-8
         cbBuffer_ = 2048;
         rgbBuffer_ = new char[cbBuffer_];
     }
@@ -49,12 +50,13 @@ private:
 
 protected:
     virtual bool SaveWordsToFileSetup();
-    virtual bool SaveWordToFile(std::basic_string<gunichar> s);
+    virtual bool SaveWordToFile(std::basic_string<gunichar> s, unsigned int nFrequency);
     virtual bool SaveWordsToFileTeardown();
 
     virtual bool GetWordsFromFileSetup();
     virtual bool FileHasAnotherWord();
     virtual std::basic_string<gunichar> GetNextWordFromFile();
+    virtual unsigned int GetNextWordFrequencyFromFile();
     virtual bool GetWordsFromFileTeardown();
 
 private:
@@ -71,6 +73,7 @@ private:
   std::basic_string<gunichar> GetLineUtf16();
 
   static std::basic_string<gunichar> TrimWhitespace(const std::basic_string<gunichar>& s);
+  static unsigned int SplitFrequency(std::basic_string<gunichar>& s);
 
 
   enum ByteOrder{
@@ -83,4 +86,5 @@ private:
   char*         rgbBuffer_;
   size_t        cbBuffer_;
   std::basic_string<gunichar>  nextWord_;
+  unsigned int  nextFrequency_;
 };
\ No newline at end of file
@@ -25,6 +25,11 @@ public:
     ToNFD(const std::basic_string<gunichar>& s)
     {
         std::basic_string<gunichar> result;
+        // g_unicode_canonical_ordering reads past the end of an empty string
+        if(s.empty())
+        {
+            return result;
+        }
 
         for(size_t i = 0; i != s.length(); ++i)
         {
@@ -44,5 +49,21 @@ public:
         return result;
     }
 
+    // UTF-8 in and out, without widening to UCS-4 first
+    inline
+    static std::string 
+    ToNFD(const std::string& s)
+    {
+        std::string result;
+
+        gchar* decomposed = g_utf8_normalize(s.c_str(), 
+            static_cast<gssize>(s.length()), G_NORMALIZE_NFD);
+        if(decomposed != NULL)
+        {
+            result = std::string(decomposed);
+            g_free(decomposed);
+        }
+        return result;
+    }
 
 };
\ No newline at end of file
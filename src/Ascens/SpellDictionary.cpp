@@ -2,16 +2,34 @@
 #include "IDictionaryFile.h"
 #include "Convert.h"
 #include "Normalize.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 SpellDictionary::SpellDictionary(void)
-: nErrorTolerance_(2), nBestErrorTolerance_(6)
+: nErrorTolerance_(2), nBestErrorTolerance_(6), nMaxSuggestions_(0),
+  nCompoundMaxParts_(1), nCompoundMinPartLength_(3),
+  segmentationMode_(MaximalMatching), nTotalFrequency_(0),
+  fUseUtf8Index_(false), fUtf8IndexBuilt_(false),
+  fUseExactIndex_(false), fExactIndexBuilt_(false),
+  fUseExactHash_(false), fExactHashBuilt_(false), fWordsAddedSinceExactHash_(false),
+  fUseBloomFilter_(false), fBloomFilterBuilt_(false),
+  pBase_(NULL), nWordsVersion_(0), nBaseWordsVersion_(0),
+  pPersonalDictionaryFile_(NULL)
 {
     pDictionaryFile_ = NULL;
+    // words removed one at a time leave holes in the nodes laid out by
+    // Load; once a quarter of those nodes are free, lay it out again
+    rgWordList_.set_compact_threshold(0.25);
 }
 
 SpellDictionary::~SpellDictionary(void)
 {
     ReleaseDictionaryFile();
+    if(pPersonalDictionaryFile_ != NULL)
+    {
+        delete pPersonalDictionaryFile_;
+    }
 }
 
 void 
@@ -29,20 +47,290 @@ SpellDictionary::Load (IDictionaryFile*const pDictionaryFile)
 {
     ReleaseDictionaryFile();
     pDictionaryFile_ = pDictionaryFile;
+    pBase_ = NULL;
+    rgfHidden_.clear();
     Load();
 }
 
+void 
+SpellDictionary::LoadVariant (SpellDictionary& base, IDictionaryFile*const pDictionaryFile)
+{
+    // the hidden bits are numbered by the base's own word list
+    assert(base.pBase_ == NULL);
+    ReleaseDictionaryFile();
+    pDictionaryFile_ = pDictionaryFile;
+    pBase_ = &base;
+    Load();
+}
+
+void 
+SpellDictionary::LoadPersonal (IDictionaryFile*const pPersonalDictionaryFile)
+{
+    if(pPersonalDictionaryFile_ != NULL)
+    {
+        delete pPersonalDictionaryFile_;
+    }
+    pPersonalDictionaryFile_ = pPersonalDictionaryFile;
+    rgPersonalWordList_.clear();
+    LoadPersonalWords();
+}
+
 bool 
 SpellDictionary::IsWordPresent(const std::basic_string<gunichar>& word) 
 {
   Load();
   std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
-  return rgWordList_.find(strWord) != rgWordList_.end(); 
+  if(IsExcluded(strWord)) {
+    return false;
+  }
+  if(IsInWordList(strWord) || IsInLayers(strWord)) {
+    return true;
+  }
+  return nCompoundMaxParts_ > 1 && IsCompound(strWord);
+}
+
+// whether the normalized word is in the word list, through the filter and
+// indexes which are on
+bool 
+SpellDictionary::IsInWordList(const std::basic_string<gunichar>& strWord) 
+{
+  if(pBase_ != NULL) {
+    // the few words of a variant are looked up directly, the base through
+    // its own filter and indexes
+    if(rgWordList_.find(strWord) != rgWordList_.end()) {
+      return true;
+    }
+    return pBase_->IsInWordList(strWord) && !IsHidden(strWord);
+  }
+  if(fUseBloomFilter_ && GetBloomFilter().count(strWord) == 0) {
+    return false;
+  }
+  if(fUseExactHash_) {
+    return GetExactHash().count(strWord) != 0 ||
+           (fWordsAddedSinceExactHash_ && rgWordList_.find(strWord) != rgWordList_.end());
+  }
+  if(fUseExactIndex_) {
+    return GetExactIndex().count(strWord) != 0;
+  }
+  return rgWordList_.find(strWord) != rgWordList_.end();
+}
+
+// the word and its frequency, or NULL if it is not in the dictionary
+const SpellDictionary::wordlist_type::value_type* 
+SpellDictionary::FindWord(const word_iterator& itBegin, const word_iterator& itEnd)
+{
+  wordlist_iterator it = rgWordList_.find(itBegin, itEnd);
+  if(it != rgWordList_.end()) {
+    return &*it;
+  }
+  if(pBase_ == NULL) {
+    return NULL;
+  }
+  const wordlist_type::value_type* pWord = pBase_->FindWord(itBegin, itEnd);
+  if(pWord != NULL && IsHidden(pWord->first)) {
+    return NULL;
+  }
+  return pWord;
+}
+
+// whether the variant leaves out (or gives another frequency to) this word,
+// which must be one of the base's
+bool 
+SpellDictionary::IsHidden(const std::basic_string<gunichar>& strWord)
+{
+  return GetHiddenCount() != 0 && rgfHidden_[pBase_->rgWordList_.rank(strWord)];
+}
+
+size_t 
+SpellDictionary::GetHiddenCount() const
+{
+  return rgfHidden_.rank1(rgfHidden_.size());
+}
+
+// the words of the base hidden which begin with the prefix, which are next
+// to each other in the base
+size_t 
+SpellDictionary::GetHiddenCountWithPrefix(const std::basic_string<gunichar>& strPrefix)
+{
+  const wordlist_type& rgBaseWords = pBase_->rgWordList_;
+  const size_t iFirst = rgBaseWords.rank(strPrefix);
+  return rgfHidden_.rank1(iFirst + rgBaseWords.count_prefix(strPrefix)) - rgfHidden_.rank1(iFirst);
+}
+
+// hides one more word of the base
+void 
+SpellDictionary::Hide(const std::basic_string<gunichar>& strWord)
+{
+  rgfHidden_.set(pBase_->rgWordList_.rank(strWord));
+}
+
+// drops the words of the base the variant hides, giving how many there were
+size_t 
+SpellDictionary::RemoveHidden(std::vector<wordlist_type::const_iterator>& rgIt)
+{
+  size_t cHidden = 0;
+  std::vector<wordlist_type::const_iterator>::iterator itOut = rgIt.begin();
+  for(std::vector<wordlist_type::const_iterator>::iterator it = rgIt.begin(); it != rgIt.end(); ++it) {
+    if(IsHidden((*it)->first)) {
+      ++cHidden;
+    }
+    else {
+      *itOut++ = *it;
+    }
+  }
+  rgIt.erase(itOut, rgIt.end());
+  return cHidden;
+}
+
+bool 
+SpellDictionary::HasLayers() const
+{
+  return !rgPersonalWordList_.empty() || !rgSessionWordList_.empty() || !rgExcludedWordList_.empty();
+}
+
+// whether the normalized word is a personal or session word
+bool 
+SpellDictionary::IsInLayers(const std::basic_string<gunichar>& strWord) const
+{
+  return rgPersonalWordList_.find(strWord) != rgPersonalWordList_.end() 
+    || rgSessionWordList_.find(strWord) != rgSessionWordList_.end();
+}
+
+bool 
+SpellDictionary::IsExcluded(const std::basic_string<gunichar>& strWord) const
+{
+  return !rgExcludedWordList_.empty() && rgExcludedWordList_.find(strWord) != rgExcludedWordList_.end();
+}
+
+// drops the excluded words, giving how many there were
+size_t 
+SpellDictionary::RemoveExcluded(std::vector<wordlist_type::const_iterator>& rgIt) const
+{
+  size_t cExcluded = 0;
+  std::vector<wordlist_type::const_iterator>::iterator itOut = rgIt.begin();
+  for(std::vector<wordlist_type::const_iterator>::iterator it = rgIt.begin(); it != rgIt.end(); ++it) {
+    if(IsExcluded((*it)->first)) {
+      ++cExcluded;
+    }
+    else {
+      *itOut++ = *it;
+    }
+  }
+  rgIt.erase(itOut, rgIt.end());
+  return cExcluded;
+}
+
+// adds the words found in a layer which the word list has not gained since
+// they were added to it (it is found there already)
+void 
+SpellDictionary::AddLayerWords(std::vector<wordlist_type::const_iterator>& rgIt, const std::vector<wordlist_type::const_iterator>& rgLayerIt)
+{
+  for(std::vector<wordlist_type::const_iterator>::const_iterator it = rgLayerIt.begin(); it != rgLayerIt.end(); ++it) {
+    if(FindWord((*it)->first.begin(), (*it)->first.end()) == NULL) {
+      rgIt.push_back(*it);
+    }
+  }
+}
+
+static bool
+IsShorter(const SpellDictionary::wordlist_type::const_iterator& a, const SpellDictionary::wordlist_type::const_iterator& b)
+{
+    return a->first.length() < b->first.length();
+}
+
+// the words the text begins with, shortest first
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::FindPrefixes(const word_iterator& itBegin, const word_iterator& itEnd)
+{
+  std::vector<wordlist_type::const_iterator> rgPrefixes = rgWordList_.find_prefixes(itBegin, itEnd);
+  if(pBase_ != NULL) {
+    std::vector<wordlist_type::const_iterator> rgBasePrefixes = pBase_->FindPrefixes(itBegin, itEnd);
+    RemoveHidden(rgBasePrefixes);
+    rgPrefixes.insert(rgPrefixes.end(), rgBasePrefixes.begin(), rgBasePrefixes.end());
+    std::sort(rgPrefixes.begin(), rgPrefixes.end(), IsShorter);
+  }
+  return rgPrefixes;
+}
+
+void 
+SpellDictionary::SetCompoundLinkingMorphemes(const std::vector<const std::basic_string<gunichar> >& rgstrMorphemes)
+{
+  rgstrCompoundLinkingMorphemes_.clear();
+  for(std::vector<const std::basic_string<gunichar> >::const_iterator it = rgstrMorphemes.begin();
+      it != rgstrMorphemes.end();
+      ++it)
+  {
+    if(!it->empty()) {
+      rgstrCompoundLinkingMorphemes_.push_back(Normalize::ToNFD(*it));
+    }
+  }
+}
+
+// rgParts[i] is the fewest parts that make up the first i characters. The
+// trie is walked once from each position some split reaches, collecting
+// every word that starts there.
+bool 
+SpellDictionary::IsCompound(const std::basic_string<gunichar>& strWord)
+{
+  typedef std::basic_string<gunichar>::const_iterator word_iterator;
+  const unsigned short nUnreached = std::numeric_limits<unsigned short>::max();
+  const size_t cchWord = strWord.length();
+  const word_iterator itBegin = strWord.begin();
+  const word_iterator itEnd = strWord.end();
+
+  std::vector<unsigned short> rgParts(cchWord + 1, nUnreached);
+  rgParts[0] = 0;
+
+  for(size_t i = 0; i != cchWord; ++i) {
+    if(rgParts[i] >= nCompoundMaxParts_) {
+      continue; // unreached or too many parts already
+    }
+    const unsigned short nParts = rgParts[i] + 1;
+
+    std::vector<wordlist_type::const_iterator> rgPrefixes = FindPrefixes(itBegin + i, itEnd);
+    RemoveExcluded(rgPrefixes);
+    for(std::vector<wordlist_type::const_iterator>::const_iterator itPart = rgPrefixes.begin(); 
+        itPart != rgPrefixes.end(); 
+        ++itPart) {
+      const size_t cchPart = (*itPart)->first.length();
+      if(cchPart < nCompoundMinPartLength_ || cchPart == 0) {
+        continue;
+      }
+      const size_t j = i + cchPart;
+      rgParts[j] = std::min(rgParts[j], nParts);
+
+      // a linking morpheme can only join two parts
+      for(std::vector<const std::basic_string<gunichar> >::const_iterator itMorpheme = rgstrCompoundLinkingMorphemes_.begin();
+          itMorpheme != rgstrCompoundLinkingMorphemes_.end();
+          ++itMorpheme) {
+        const size_t k = j + itMorpheme->length();
+        if(k < cchWord && strWord.compare(j, itMorpheme->length(), *itMorpheme) == 0) {
+          rgParts[k] = std::min(rgParts[k], nParts);
+        }
+      }
+    }
+  }
+  return rgParts[cchWord] <= nCompoundMaxParts_;
 }
 
 bool 
 SpellDictionary::IsWordPresentUtf8(const std::string& strWord) 
 {
+    if(fUseUtf8Index_ && pBase_ == NULL)
+    {
+        Load();
+        std::string strNormalized = Normalize::ToNFD(strWord);
+        const utf8_index_type& index = GetUtf8Index();
+        // the layers are looked in with the word itself
+        if(index.find(strNormalized.begin(), strNormalized.end()) != index.end() && rgExcludedWordList_.empty())
+        {
+            return true;
+        }
+        if(nCompoundMaxParts_ <= 1 && !HasLayers())
+        {
+            return false;
+        }
+    }
     return IsWordPresent(Convert::ToUcs4(strWord));
 }
 
@@ -52,49 +340,863 @@ SpellDictionary::IsWordPresentUtf16(const std::basic_string<gunichar2>& strWord)
     return IsWordPresent(Convert::ToUcs4(strWord));
 }
 
+static bool
+IsMoreFrequentConst(const SpellDictionary::wordlist_type::const_iterator& a, const SpellDictionary::wordlist_type::const_iterator& b)
+{
+    return a->second > b->second;
+}
+
+// the edit distance weighted_find counts: insertions, deletions,
+// replacements and transpositions of neighbouring characters
+static unsigned int
+EditDistance(const std::basic_string<gunichar>& a, const std::basic_string<gunichar>& b)
+{
+    std::vector<std::vector<unsigned int> > d(a.length() + 1, std::vector<unsigned int>(b.length() + 1));
+    for(size_t i = 0; i <= a.length(); ++i)
+    {
+        for(size_t j = 0; j <= b.length(); ++j)
+        {
+            if(i == 0 || j == 0)
+            {
+                d[i][j] = static_cast<unsigned int>(i + j);
+                continue;
+            }
+            d[i][j] = std::min(std::min(d[i-1][j] + 1, d[i][j-1] + 1),
+                               d[i-1][j-1] + ((a[i-1] == b[j-1]) ? 0 : 1));
+            if(i > 1 && j > 1 && a[i-1] == b[j-2] && a[i-2] == b[j-1])
+            {
+                d[i][j] = std::min(d[i][j], d[i-2][j-2] + 1);
+            }
+        }
+    }
+    return d[a.length()][b.length()];
+}
+
+// a word found near the word searched for, ordered the way weighted_find
+// orders them: closest, then most frequent, then alphabetically
+struct WeightedWord {
+    unsigned int nDistance;
+    SpellDictionary::wordlist_type::const_iterator it;
+
+    bool operator<(const WeightedWord& other) const
+    {
+        if(nDistance != other.nDistance)
+        {
+            return nDistance < other.nDistance;
+        }
+        if(it->second != other.it->second)
+        {
+            return it->second > other.it->second;
+        }
+        return it->first < other.it->first;
+    }
+};
+
+// puts the words in the order weighted_find gives them, keeping the first
+// nMax (0 is no limit)
+static void
+SortByDistance(const std::basic_string<gunichar>& strWord, std::vector<SpellDictionary::wordlist_type::const_iterator>& rgIt, size_t nMax)
+{
+    std::vector<WeightedWord> rgFound;
+    for(std::vector<SpellDictionary::wordlist_type::const_iterator>::const_iterator it = rgIt.begin(); it != rgIt.end(); ++it)
+    {
+        WeightedWord found;
+        found.nDistance = EditDistance(strWord, (*it)->first);
+        found.it = *it;
+        rgFound.push_back(found);
+    }
+    std::sort(rgFound.begin(), rgFound.end());
+    if(nMax != 0 && rgFound.size() > nMax)
+    {
+        rgFound.resize(nMax);
+    }
+
+    rgIt.clear();
+    for(std::vector<WeightedWord>::const_iterator it = rgFound.begin(); it != rgFound.end(); ++it)
+    {
+        rgIt.push_back(it->it);
+    }
+}
+
+// keeps the words, closest first, which are as close as the first
+static void
+KeepClosest(const std::basic_string<gunichar>& strWord, std::vector<SpellDictionary::wordlist_type::const_iterator>& rgIt)
+{
+    if(rgIt.empty())
+    {
+        return;
+    }
+    const unsigned int nClosest = EditDistance(strWord, rgIt.front()->first);
+    std::vector<SpellDictionary::wordlist_type::const_iterator>::iterator it = rgIt.begin();
+    while(it != rgIt.end() && EditDistance(strWord, (*it)->first) == nClosest)
+    {
+        ++it;
+    }
+    rgIt.erase(it, rgIt.end());
+}
+
+static bool
+IsMoreFrequentThenLess(const SpellDictionary::wordlist_type::const_iterator& a, const SpellDictionary::wordlist_type::const_iterator& b)
+{
+    if(a->second != b->second)
+    {
+        return a->second > b->second;
+    }
+    return a->first < b->first;
+}
+
+static bool
+IsLess(const SpellDictionary::wordlist_type::const_iterator& a, const SpellDictionary::wordlist_type::const_iterator& b)
+{
+    return a->first < b->first;
+}
+
+// the number of bytes the word takes in UTF-8
+static size_t
+Utf8Length(const std::basic_string<gunichar>& strWord)
+{
+    size_t cb = 0;
+    for(size_t i = 0; i != strWord.length(); ++i)
+    {
+        cb += g_unichar_to_utf8(strWord[i], NULL);
+    }
+    return cb;
+}
+
+std::vector<const std::basic_string<gunichar>> 
+SpellDictionary::GetSuggestionsFromWord(const std::basic_string<gunichar>& word) 
+{
+  std::vector<const std::basic_string<gunichar>>        rgstrWords;
+  std::vector<wordlist_type::const_iterator>            rgIt;
+  std::vector<wordlist_type::const_iterator>::iterator  itrgIt;
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  Load();
+  
+  // break word and check if two newly created words are both words.
+  // If so, add this to suggestions. One walk down the trie gives every
+  // word the token begins with, so the rest only has to be looked up there
+  const std::basic_string<gunichar>::const_iterator itBegin = strWord.begin();
+  const std::basic_string<gunichar>::const_iterator itEnd = strWord.end();
+  std::vector<wordlist_type::const_iterator> rgPrefixes = FindPrefixes(itBegin, itEnd);
+  RemoveExcluded(rgPrefixes);
+  for(std::vector<wordlist_type::const_iterator>::const_iterator it = rgPrefixes.begin(); it != rgPrefixes.end(); ++it) {
+    const size_t cchPrefix = (*it)->first.length();
+    if(cchPrefix == 0 || cchPrefix == strWord.length()) {
+      continue;
+    }
+    const wordlist_type::value_type* pRest = FindWord(itBegin + cchPrefix, itEnd);
+    if(pRest != NULL && !IsExcluded(pRest->first)) {
+      std::basic_string<gunichar> strSplit;
+      strSplit.reserve(strWord.length() + 1);
+      strSplit.append(itBegin, itBegin + cchPrefix);
+      strSplit.push_back(L' ');
+      strSplit.append(itBegin + cchPrefix, itEnd);
+      rgstrWords.push_back(strSplit);
+    }
+  }
+
+  rgIt = LayeredWeightedFind(strWord, nErrorTolerance_, nMaxSuggestions_);
+  if(rgIt.empty()) {
+    // we are limiting best_find here since it would be theoretically possible
+    // to get the entire dictionary
+    rgIt = LayeredBestFind(strWord, nBestErrorTolerance_);
+    // all at the same distance so order by frequency alone
+    std::stable_sort(rgIt.begin(), rgIt.end(), IsMoreFrequentConst);
+    if(nMaxSuggestions_ != 0 && rgIt.size() > nMaxSuggestions_) {
+      rgIt.resize(nMaxSuggestions_);
+    }
+  }
+
+  for(itrgIt = rgIt.begin(); itrgIt != rgIt.end(); itrgIt++) {
+    rgstrWords.push_back((*itrgIt)->first);
+  }
+
+  return rgstrWords;
+}
+
+// weighted_find, which for a variant merges what it finds with what the
+// base finds, in the same order
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::WeightedFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance, size_t nMax) 
+{
+  const wordlist_type& rgWords = rgWordList_;
+  std::vector<wordlist_type::const_iterator> rgIt = rgWords.weighted_find(strWord, nDistance, nMax);
+  if(pBase_ == NULL) {
+    return rgIt;
+  }
+
+  std::vector<wordlist_type::const_iterator> rgBaseIt = pBase_->WeightedFind(strWord, nDistance, nMax);
+  const size_t cHidden = RemoveHidden(rgBaseIt);
+  if(cHidden != 0 && nMax != 0 && rgBaseIt.size() + cHidden == nMax) {
+    // the hidden words may have crowded out some which are not
+    rgBaseIt = pBase_->WeightedFind(strWord, nDistance, 0);
+    RemoveHidden(rgBaseIt);
+  }
+
+  rgIt.insert(rgIt.end(), rgBaseIt.begin(), rgBaseIt.end());
+  SortByDistance(strWord, rgIt, nMax);
+  return rgIt;
+}
+
+// best_find. The closest words of a variant's base may all be hidden, so a
+// variant widens the search one edit at a time until it finds some.
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::BestFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance) 
+{
+  if(pBase_ == NULL) {
+    const wordlist_type& rgWords = rgWordList_;
+    return rgWords.best_find(strWord, nDistance);
+  }
+
+  for(unsigned short nWithin = 0; nWithin <= nDistance; ++nWithin) {
+    std::vector<wordlist_type::const_iterator> rgIt = WeightedFind(strWord, nWithin, 0);
+    if(!rgIt.empty()) {
+      KeepClosest(strWord, rgIt);
+      return rgIt;
+    }
+  }
+  return std::vector<wordlist_type::const_iterator>();
+}
+
+// WeightedFind over the word list and the layers, without excluded words
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::LayeredWeightedFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance, size_t nMax) 
+{
+  std::vector<wordlist_type::const_iterator> rgIt = WeightedFind(strWord, nDistance, nMax);
+  if(!HasLayers()) {
+    return rgIt;
+  }
+
+  const size_t cExcluded = RemoveExcluded(rgIt);
+  if(cExcluded != 0 && nMax != 0 && rgIt.size() + cExcluded == nMax) {
+    // the excluded words may have crowded out some which are not
+    rgIt = WeightedFind(strWord, nDistance, 0);
+    RemoveExcluded(rgIt);
+  }
+
+  // all the layers' words within reach, since those the word list has too
+  // are left out and could crowd out others; the layers are small
+  const wordlist_type& rgPersonalWords = rgPersonalWordList_;
+  const wordlist_type& rgSessionWords = rgSessionWordList_;
+  AddLayerWords(rgIt, rgPersonalWords.weighted_find(strWord, nDistance, 0));
+  AddLayerWords(rgIt, rgSessionWords.weighted_find(strWord, nDistance, 0));
+  SortByDistance(strWord, rgIt, nMax);
+  return rgIt;
+}
+
+// BestFind over the word list and the layers. The closest words of the
+// word list may all be excluded, so this widens the search one edit at a
+// time, as a variant does.
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::LayeredBestFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance) 
+{
+  if(!HasLayers()) {
+    return BestFind(strWord, nDistance);
+  }
+
+  for(unsigned short nWithin = 0; nWithin <= nDistance; ++nWithin) {
+    std::vector<wordlist_type::const_iterator> rgIt = LayeredWeightedFind(strWord, nWithin, 0);
+    if(!rgIt.empty()) {
+      KeepClosest(strWord, rgIt);
+      return rgIt;
+    }
+  }
+  return std::vector<wordlist_type::const_iterator>();
+}
+
+// the same as GetSuggestionsFromWord, searching the UTF-8 index
+std::vector<const std::string> 
+SpellDictionary::GetSuggestionsFromUtf8Index(const std::string& word) 
+{
+  std::vector<const std::string>                        rgstrWords;
+  std::vector<wordlist_type::const_iterator>            rgIt;
+  std::vector<wordlist_type::const_iterator>::iterator  itrgIt;
+  std::string strWord = Normalize::ToNFD(word);
+  Load();
+  const utf8_index_type& index = GetUtf8Index();
+
+  const std::string::const_iterator itBegin = strWord.begin();
+  const std::string::const_iterator itEnd = strWord.end();
+  std::vector<wordlist_type::const_iterator> rgPrefixes = index.find_prefixes(itBegin, itEnd);
+  for(std::vector<wordlist_type::const_iterator>::const_iterator it = rgPrefixes.begin(); it != rgPrefixes.end(); ++it) {
+    const size_t cbPrefix = Utf8Length((*it)->first);
+    if(cbPrefix == 0 || cbPrefix == strWord.length()) {
+      continue;
+    }
+    if(index.find(itBegin + cbPrefix, itEnd) != index.end()) {
+      std::string strSplit;
+      strSplit.reserve(strWord.length() + 1);
+      strSplit.append(itBegin, itBegin + cbPrefix);
+      strSplit.push_back(' ');
+      strSplit.append(itBegin + cbPrefix, itEnd);
+      rgstrWords.push_back(strSplit);
+    }
+  }
+
+  rgIt = index.weighted_find(itBegin, itEnd, nErrorTolerance_, nMaxSuggestions_);
+  if(rgIt.empty()) {
+    rgIt = index.best_find(itBegin, itEnd, nBestErrorTolerance_);
+    std::stable_sort(rgIt.begin(), rgIt.end(), IsMoreFrequentConst);
+    if(nMaxSuggestions_ != 0 && rgIt.size() > nMaxSuggestions_) {
+      rgIt.resize(nMaxSuggestions_);
+    }
+  }
+
+  for(itrgIt = rgIt.begin(); itrgIt != rgIt.end(); itrgIt++) {
+    rgstrWords.push_back(Convert::ToUtf8((*itrgIt)->first));
+  }
+
+  return rgstrWords;
+}
+
+std::vector<const std::string> 
+SpellDictionary::GetSuggestionsFromWordUtf8(const std::string& strWord) 
+{
+    Load(); // for the layers
+    if(fUseUtf8Index_ && pBase_ == NULL && !HasLayers())
+    {
+        return GetSuggestionsFromUtf8Index(strWord);
+    }
+
+    std::vector<const std::basic_string<gunichar>> suggestions;
+    suggestions = GetSuggestionsFromWord(Convert::ToUcs4(strWord));
+
+    std::vector<const std::string>        result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = suggestions.begin();
+        it != suggestions.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf8(*it));
+    }
+
+    return result;
+}
+
+std::vector<const std::basic_string<gunichar2>> 
+SpellDictionary::GetSuggestionsFromWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    std::vector<const std::basic_string<gunichar>> suggestions;
+    suggestions = GetSuggestionsFromWord(Convert::ToUcs4(strWord));
+
+    std::vector<const std::basic_string<gunichar2>> result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = suggestions.begin();
+        it != suggestions.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf16(*it));
+    }
+
+    return result;
+}
+
+std::vector<const std::basic_string<gunichar>> 
+SpellDictionary::GetCompletions(const std::basic_string<gunichar>& prefix, size_t nCompletions) 
+{
+  std::vector<const std::basic_string<gunichar>>        rgstrWords;
+  std::vector<wordlist_type::const_iterator>            rgIt;
+  std::vector<wordlist_type::const_iterator>::iterator  itrgIt;
+  std::basic_string<gunichar> strPrefix = Normalize::ToNFD(prefix);
+  Load();
+
+  rgIt = LayeredComplete(strPrefix, nCompletions);
+
+  for(itrgIt = rgIt.begin(); itrgIt != rgIt.end(); itrgIt++) {
+    rgstrWords.push_back((*itrgIt)->first);
+  }
+
+  return rgstrWords;
+}
+
+// complete, which for a variant merges its words with the base's. Asking
+// the base for as many more as the variant hides leaves enough.
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::Complete(const std::basic_string<gunichar>& strPrefix, size_t nCompletions) 
+{
+  const wordlist_type& rgWords = rgWordList_;
+  std::vector<wordlist_type::const_iterator> rgIt = rgWords.complete(strPrefix, nCompletions);
+  if(pBase_ == NULL) {
+    return rgIt;
+  }
+
+  std::vector<wordlist_type::const_iterator> rgBaseIt = 
+    pBase_->Complete(strPrefix, nCompletions + GetHiddenCountWithPrefix(strPrefix));
+  RemoveHidden(rgBaseIt);
+  rgIt.insert(rgIt.end(), rgBaseIt.begin(), rgBaseIt.end());
+  std::sort(rgIt.begin(), rgIt.end(), IsMoreFrequentThenLess);
+  if(rgIt.size() > nCompletions) {
+    rgIt.resize(nCompletions);
+  }
+  return rgIt;
+}
+
+// Complete over the word list and the layers, without excluded words.
+// Asking the word list for as many more as are excluded leaves enough.
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::LayeredComplete(const std::basic_string<gunichar>& strPrefix, size_t nCompletions) 
+{
+  if(!HasLayers()) {
+    return Complete(strPrefix, nCompletions);
+  }
+
+  std::vector<wordlist_type::const_iterator> rgIt = 
+    Complete(strPrefix, nCompletions + rgExcludedWordList_.count_prefix(strPrefix));
+  RemoveExcluded(rgIt);
+
+  const wordlist_type& rgPersonalWords = rgPersonalWordList_;
+  const wordlist_type& rgSessionWords = rgSessionWordList_;
+  AddLayerWords(rgIt, rgPersonalWords.complete(strPrefix, rgPersonalWords.count_prefix(strPrefix)));
+  AddLayerWords(rgIt, rgSessionWords.complete(strPrefix, rgSessionWords.count_prefix(strPrefix)));
+  std::sort(rgIt.begin(), rgIt.end(), IsMoreFrequentThenLess);
+  if(rgIt.size() > nCompletions) {
+    rgIt.resize(nCompletions);
+  }
+  return rgIt;
+}
+
+std::vector<const std::string> 
+SpellDictionary::GetCompletionsUtf8(const std::string& strPrefix, size_t nCompletions) 
+{
+    std::vector<const std::basic_string<gunichar>> completions;
+    completions = GetCompletions(Convert::ToUcs4(strPrefix), nCompletions);
+
+    std::vector<const std::string>        result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = completions.begin();
+        it != completions.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf8(*it));
+    }
+
+    return result;
+}
+
+std::vector<const std::basic_string<gunichar2>> 
+SpellDictionary::GetCompletionsUtf16(const std::basic_string<gunichar2>& strPrefix, size_t nCompletions) 
+{
+    std::vector<const std::basic_string<gunichar>> completions;
+    completions = GetCompletions(Convert::ToUcs4(strPrefix), nCompletions);
+
+    std::vector<const std::basic_string<gunichar2>> result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = completions.begin();
+        it != completions.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf16(*it));
+    }
+
+    return result;
+}
+
+// index of the ] closing the class opened at i, or the pattern length if the
+// [ opens no class, as pattern_find reads it
+static size_t
+ClassEnd(const std::basic_string<gunichar>& strPattern, size_t i)
+{
+    ++i;
+    if(i != strPattern.length() && strPattern[i] == '^')
+    {
+        ++i;
+    }
+    if(i != strPattern.length())
+    {
+        ++i;
+    }
+    const size_t j = strPattern.find(']', i);
+    return (j == std::basic_string<gunichar>::npos) ? strPattern.length() : j;
+}
+
+// appends each alternative to each of the patterns
+static void
+AppendAlternatives(std::vector<std::basic_string<gunichar> >& rgstrPatterns, const std::vector<std::basic_string<gunichar> >& rgstrAlternatives)
+{
+    std::vector<std::basic_string<gunichar> > rgstrResult;
+    for(std::vector<std::basic_string<gunichar> >::const_iterator it = rgstrPatterns.begin(); it != rgstrPatterns.end(); ++it)
+    {
+        for(std::vector<std::basic_string<gunichar> >::const_iterator itAlternative = rgstrAlternatives.begin(); 
+            itAlternative != rgstrAlternatives.end(); 
+            ++itAlternative)
+        {
+            rgstrResult.push_back(*it + *itAlternative);
+        }
+    }
+    rgstrPatterns.swap(rgstrResult);
+}
+
+// The pattern in NFD. The runs outside classes are normalized as they are
+// and each member of a class on its own, since normalizing the class as a
+// whole would break up its members. A class matches one character, so a
+// member which decomposes into several (é is e and a combining acute) is
+// split off into a pattern of its own, with the member as a literal where
+// the class was. A [^...] class drops such members, as one character is
+// never one of them. Ranges are kept as they are.
+static std::vector<std::basic_string<gunichar> >
+NormalizePattern(const std::basic_string<gunichar>& strPattern)
+{
+    std::vector<std::basic_string<gunichar> > rgstrPatterns(1);
+    std::vector<std::basic_string<gunichar> > rgstrAlternatives(1);
+    const size_t cchPattern = strPattern.length();
+    size_t iLiteral = 0;
+    for(size_t i = 0; i != cchPattern; ++i)
+    {
+        if(strPattern[i] == '\\')
+        {
+            ++i; // the next character is literal
+            continue;
+        }
+        size_t j;
+        if(strPattern[i] != '[' || (j = ClassEnd(strPattern, i)) == cchPattern)
+        {
+            continue;
+        }
+
+        rgstrAlternatives.assign(1, Normalize::ToNFD(strPattern.substr(iLiteral, i - iLiteral)));
+        AppendAlternatives(rgstrPatterns, rgstrAlternatives);
+        rgstrAlternatives.clear();
+
+        const bool fNegate = (strPattern[i + 1] == '^');
+        std::basic_string<gunichar> strClass = strPattern.substr(i, fNegate ? 2 : 1);
+        const size_t cchOpen = strClass.length();
+        for(i += cchOpen; i != j; ++i)
+        {
+            if(i + 2 < j && strPattern[i + 1] == '-')
+            {
+                strClass.append(strPattern, i, 3);
+                i += 2;
+                continue;
+            }
+            const std::basic_string<gunichar> strMember = Normalize::ToNFD(strPattern.substr(i, 1));
+            if(strMember.length() == 1)
+            {
+                strClass += strMember;
+            }
+            else if(!fNegate)
+            {
+                std::basic_string<gunichar> strLiteral;
+                for(size_t k = 0; k != strMember.length(); ++k)
+                {
+                    if(strMember[k] == '\\' || strMember[k] == '*' || strMember[k] == '?' || strMember[k] == '[')
+                    {
+                        strLiteral += '\\';
+                    }
+                    strLiteral += strMember[k];
+                }
+                rgstrAlternatives.push_back(strLiteral);
+            }
+        }
+        if(strClass.length() != cchOpen)
+        {
+            rgstrAlternatives.push_back(strClass + static_cast<gunichar>(']'));
+        }
+        else if(fNegate)
+        {
+            rgstrAlternatives.push_back(std::basic_string<gunichar>(1, '?')); // none of nothing
+        }
+        AppendAlternatives(rgstrPatterns, rgstrAlternatives);
+        iLiteral = j + 1;
+    }
+
+    rgstrAlternatives.assign(1, Normalize::ToNFD(strPattern.substr(std::min(iLiteral, cchPattern))));
+    AppendAlternatives(rgstrPatterns, rgstrAlternatives);
+    return rgstrPatterns;
+}
+
+static bool
+IsSameWord(const SpellDictionary::wordlist_type::const_iterator& a, const SpellDictionary::wordlist_type::const_iterator& b)
+{
+    return a->first == b->first;
+}
+
+std::vector<const std::basic_string<gunichar>> 
+SpellDictionary::GetWordsMatchingPattern(const std::basic_string<gunichar>& pattern) 
+{
+  std::vector<const std::basic_string<gunichar>>        rgstrWords;
+  std::vector<wordlist_type::const_iterator>            rgIt;
+  std::vector<wordlist_type::const_iterator>::iterator  itrgIt;
+  std::vector<std::basic_string<gunichar> > rgstrPatterns = NormalizePattern(pattern);
+  Load();
+
+  const wordlist_type& rgPersonalWords = rgPersonalWordList_;
+  const wordlist_type& rgSessionWords = rgSessionWordList_;
+  for(std::vector<std::basic_string<gunichar> >::const_iterator it = rgstrPatterns.begin(); it != rgstrPatterns.end(); ++it) {
+    std::vector<wordlist_type::const_iterator> rgPatternIt = PatternFind(*it);
+    RemoveExcluded(rgPatternIt);
+    rgIt.insert(rgIt.end(), rgPatternIt.begin(), rgPatternIt.end());
+    if(HasLayers()) {
+      AddLayerWords(rgIt, rgPersonalWords.pattern_find(*it));
+      AddLayerWords(rgIt, rgSessionWords.pattern_find(*it));
+    }
+  }
+  if(rgstrPatterns.size() > 1 || HasLayers()) {
+    // a word may match more than one of them, and the layers' words come
+    // after the word list's
+    std::sort(rgIt.begin(), rgIt.end(), IsLess);
+    rgIt.erase(std::unique(rgIt.begin(), rgIt.end(), IsSameWord), rgIt.end());
+  }
+
+  for(itrgIt = rgIt.begin(); itrgIt != rgIt.end(); itrgIt++) {
+    rgstrWords.push_back((*itrgIt)->first);
+  }
+
+  return rgstrWords;
+}
+
+// pattern_find, which for a variant merges its words with the base's
+std::vector<SpellDictionary::wordlist_type::const_iterator> 
+SpellDictionary::PatternFind(const std::basic_string<gunichar>& strPattern) 
+{
+  const wordlist_type& rgWords = rgWordList_;
+  std::vector<wordlist_type::const_iterator> rgIt = rgWords.pattern_find(strPattern);
+  if(pBase_ == NULL) {
+    return rgIt;
+  }
+
+  std::vector<wordlist_type::const_iterator> rgBaseIt = pBase_->PatternFind(strPattern);
+  RemoveHidden(rgBaseIt);
+  rgIt.insert(rgIt.end(), rgBaseIt.begin(), rgBaseIt.end());
+  std::sort(rgIt.begin(), rgIt.end(), IsLess);
+  return rgIt;
+}
+
+std::vector<const std::string> 
+SpellDictionary::GetWordsMatchingPatternUtf8(const std::string& strPattern) 
+{
+    std::vector<const std::basic_string<gunichar>> words;
+    words = GetWordsMatchingPattern(Convert::ToUcs4(strPattern));
+
+    std::vector<const std::string>        result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = words.begin();
+        it != words.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf8(*it));
+    }
+
+    return result;
+}
+
+std::vector<const std::basic_string<gunichar2>> 
+SpellDictionary::GetWordsMatchingPatternUtf16(const std::basic_string<gunichar2>& strPattern) 
+{
+    std::vector<const std::basic_string<gunichar>> words;
+    words = GetWordsMatchingPattern(Convert::ToUcs4(strPattern));
+
+    std::vector<const std::basic_string<gunichar2>> result;
+
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = words.begin();
+        it != words.end(); 
+        ++it) 
+    {
+        result.push_back(Convert::ToUtf16(*it));
+    }
+
+    return result;
+}
+
+static bool
+IsPairLess(const SpellDictionary::WordPair& a, const SpellDictionary::WordPair& b)
+{
+  if(a.strWord != b.strWord) {
+    return a.strWord < b.strWord;
+  }
+  if(a.nDistance != b.nDistance) {
+    return a.nDistance < b.nDistance;
+  }
+  return a.strOtherWord < b.strOtherWord;
+}
+
+static void
+AddPair(const std::basic_string<gunichar>& strWord, const std::basic_string<gunichar>& strOtherWord, unsigned int nDistance, std::vector<SpellDictionary::WordPair>& rgPairs)
+{
+  SpellDictionary::WordPair pair;
+  pair.strWord = strWord;
+  pair.strOtherWord = strOtherWord;
+  pair.nDistance = static_cast<unsigned short>(nDistance);
+  rgPairs.push_back(pair);
+}
+
+std::vector<SpellDictionary::WordPair> 
+SpellDictionary::GetNearDuplicates(SpellDictionary& other, unsigned short nDistance) 
+{
+  std::vector<WordPair> rgPairs;
+  Load();
+  other.Load();
+
+  const bool fSelf = (&other == this);
+  JoinWordLists(rgWordList_, false, other, other.rgWordList_, false, nDistance, fSelf, rgPairs);
+  if(pBase_ == NULL && other.pBase_ == NULL) {
+    return rgPairs;
+  }
+
+  // the words of a variant are in its own word list and its base's, so
+  // each list of one dictionary is joined with each of the other's
+  if(fSelf) {
+    JoinWordLists(pBase_->rgWordList_, true, *this, pBase_->rgWordList_, true, nDistance, true, rgPairs);
+    JoinWordLists(pBase_->rgWordList_, true, *this, rgWordList_, false, nDistance, true, rgPairs);
+  }
+  else {
+    if(pBase_ != NULL) {
+      JoinWordLists(pBase_->rgWordList_, true, other, other.rgWordList_, false, nDistance, false, rgPairs);
+    }
+    if(other.pBase_ != NULL) {
+      JoinWordLists(rgWordList_, false, other, other.pBase_->rgWordList_, true, nDistance, false, rgPairs);
+    }
+    if(pBase_ != NULL && other.pBase_ != NULL) {
+      JoinWordLists(pBase_->rgWordList_, true, other, other.pBase_->rgWordList_, true, nDistance, false, rgPairs);
+    }
+  }
+  std::sort(rgPairs.begin(), rgPairs.end(), IsPairLess);
+  return rgPairs;
+}
+
+// Adds the pairs of one join, leaving out the base words a variant hides
+// (fHiding says a list is a base). With fOnce both lists are words of this
+// dictionary and each pair is added once, later word first, as a self join
+// gives them. Two dictionaries sharing a base take their pairs within it
+// from its self join, which gives each pair once and no word with itself.
+void 
+SpellDictionary::JoinWordLists(const wordlist_type& rgWords, bool fHiding, SpellDictionary& other, const wordlist_type& rgOtherWords, bool fOtherHiding, unsigned short nDistance, bool fOnce, std::vector<WordPair>& rgPairs)
+{
+  const bool fShared = (&rgWords == &rgOtherWords) && !fOnce;
+  std::vector<wordlist_type::approximate_pair> rgJoin = rgWords.approximate_join(rgOtherWords, nDistance);
+  for(std::vector<wordlist_type::approximate_pair>::const_iterator it = rgJoin.begin(); it != rgJoin.end(); ++it) {
+    const std::basic_string<gunichar>& strWord = it->first->first;
+    const std::basic_string<gunichar>& strOtherWord = it->second->first;
+    const bool fWordInThis = !fHiding || !IsHidden(strWord);
+    const bool fOtherWordInOther = !fOtherHiding || !other.IsHidden(strOtherWord);
+
+    if(fShared) {
+      if(fWordInThis && fOtherWordInOther) {
+        AddPair(strWord, strOtherWord, it->distance, rgPairs);
+      }
+      if((!fHiding || !IsHidden(strOtherWord)) && (!fOtherHiding || !other.IsHidden(strWord))) {
+        AddPair(strOtherWord, strWord, it->distance, rgPairs);
+      }
+    }
+    else if(fWordInThis && fOtherWordInOther) {
+      if(fOnce && strWord < strOtherWord) {
+        AddPair(strOtherWord, strWord, it->distance, rgPairs);
+      }
+      else {
+        AddPair(strWord, strOtherWord, it->distance, rgPairs);
+      }
+    }
+  }
+
+  if(fShared) {
+    for(wordlist_type::const_iterator it = rgWords.begin(); it != rgWords.end(); ++it) {
+      if((!fHiding || !IsHidden(it->first)) && (!fOtherHiding || !other.IsHidden(it->first))) {
+        AddPair(it->first, it->first, 0, rgPairs);
+      }
+    }
+  }
+}
+
+// The lattice has an edge for every dictionary word starting at each
+// position (found in one walk down the trie) and an edge for every single
+// character, which is unknown. The best path has the fewest unknown
+// characters and then the lowest cost: a word costs 1 when matching 
+// maximally, or -log p(word) when weighting by frequency.
 std::vector<const std::basic_string<gunichar>> 
-SpellDictionary::GetSuggestionsFromWord(const std::basic_string<gunichar>& word) 
+SpellDictionary::SegmentText(const std::basic_string<gunichar>& text) 
 {
-  std::vector<const std::basic_string<gunichar>>        rgstrWords;
-  std::vector<wordlist_type::iterator>            rgIt;
-  std::vector<wordlist_type::iterator>::iterator  itrgIt;
-  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  std::vector<const std::basic_string<gunichar>> rgstrSegments;
+  // no text has no segments, not one empty one
+  if(text.empty()) {
+    return rgstrSegments;
+  }
+  std::basic_string<gunichar> strText = Normalize::ToNFD(text);
   Load();
-  
-  // break word and check if two newly created words are both words.
-  // If so, add this to suggestions
-  std::basic_string<gunichar>::const_iterator it = strWord.begin();
-  for(++it; it != strWord.end(); ++it) {
-    if( (rgWordList_.find(strWord.begin(), it) != rgWordList_.end()) &&
-      (rgWordList_.find(it, strWord.end()) != rgWordList_.end())) {
-      rgstrWords.push_back(strWord);
-      (*rgstrWords.rbegin()).insert((it-strWord.begin()), 1, L' ');
+
+  const size_t cchText = strText.length();
+  const std::basic_string<gunichar>::const_iterator itBegin = strText.begin();
+  const std::basic_string<gunichar>::const_iterator itEnd = strText.end();
+  // frequencies are smoothed so that no word is impossible
+  const double dTotal = static_cast<double>(nTotalFrequency_ + GetWordCount());
+
+  std::vector<size_t> rgUnknown(cchText + 1, std::numeric_limits<size_t>::max());
+  std::vector<double> rgCost(cchText + 1, 0);
+  std::vector<size_t> rgFrom(cchText + 1, 0);
+  std::vector<bool>   rgIsWord(cchText + 1, false);
+  rgUnknown[0] = 0;
+
+  for(size_t i = 0; i != cchText; ++i) {
+    // every position can be reached through unknown characters
+    if(rgUnknown[i] + 1 < rgUnknown[i + 1] ||
+       (rgUnknown[i] + 1 == rgUnknown[i + 1] && rgCost[i] < rgCost[i + 1])) {
+      rgUnknown[i + 1] = rgUnknown[i] + 1;
+      rgCost[i + 1] = rgCost[i];
+      rgFrom[i + 1] = i;
+      rgIsWord[i + 1] = false;
+    }
+
+    std::vector<wordlist_type::const_iterator> rgPrefixes = FindPrefixes(itBegin + i, itEnd);
+    RemoveExcluded(rgPrefixes);
+    for(std::vector<wordlist_type::const_iterator>::const_iterator it = rgPrefixes.begin(); it != rgPrefixes.end(); ++it) {
+      const size_t cchWord = (*it)->first.length();
+      if(cchWord == 0) {
+        continue;
+      }
+      const size_t j = i + cchWord;
+      double cost = 1;
+      if(segmentationMode_ == FrequencyWeighted) {
+        cost = -std::log(((*it)->second + 1) / dTotal);
+      }
+      if(rgUnknown[i] < rgUnknown[j] ||
+         (rgUnknown[i] == rgUnknown[j] && rgCost[i] + cost < rgCost[j])) {
+        rgUnknown[j] = rgUnknown[i];
+        rgCost[j] = rgCost[i] + cost;
+        rgFrom[j] = i;
+        rgIsWord[j] = true;
+      }
     }
   }
 
-  rgIt = rgWordList_.approximate_find(strWord, nErrorTolerance_);
-  if(rgIt.empty()) {
-    // we are limiting best_find here since it would be theoretically possible
-    // to get the entire dictionary
-    rgIt = rgWordList_.best_find(strWord, nBestErrorTolerance_);
+  // follow the best path back to the start
+  std::vector<size_t> rgEnds;
+  for(size_t j = cchText; j != 0; j = rgFrom[j]) {
+    rgEnds.push_back(j);
   }
 
-  for(itrgIt = rgIt.begin(); itrgIt != rgIt.end(); itrgIt++) {
-    rgstrWords.push_back(**itrgIt);
+  // then forward, joining runs of unknown characters
+  const size_t npos = std::basic_string<gunichar>::npos;
+  size_t iUnknown = npos;
+  for(std::vector<size_t>::reverse_iterator it = rgEnds.rbegin(); it != rgEnds.rend(); ++it) {
+    const size_t j = *it;
+    const size_t i = rgFrom[j];
+    if(!rgIsWord[j]) {
+      if(iUnknown == npos) {
+        iUnknown = i;
+      }
+      continue;
+    }
+    if(iUnknown != npos) {
+      rgstrSegments.push_back(strText.substr(iUnknown, i - iUnknown));
+      iUnknown = npos;
+    }
+    rgstrSegments.push_back(strText.substr(i, j - i));
+  }
+  if(iUnknown != npos) {
+    rgstrSegments.push_back(strText.substr(iUnknown));
   }
 
-  return rgstrWords;
+  return rgstrSegments;
 }
+
 std::vector<const std::string> 
-SpellDictionary::GetSuggestionsFromWordUtf8(const std::string& strWord) 
+SpellDictionary::SegmentTextUtf8(const std::string& strText) 
 {
-    std::vector<const std::basic_string<gunichar>> suggestions;
-    suggestions = GetSuggestionsFromWord(Convert::ToUcs4(strWord));
+    std::vector<const std::basic_string<gunichar>> segments;
+    segments = SegmentText(Convert::ToUcs4(strText));
 
     std::vector<const std::string>        result;
 
-    for(std::vector<const std::basic_string<gunichar>>::iterator it = suggestions.begin();
-        it != suggestions.end(); 
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = segments.begin();
+        it != segments.end(); 
         ++it) 
     {
         result.push_back(Convert::ToUtf8(*it));
@@ -104,15 +1206,15 @@ SpellDictionary::GetSuggestionsFromWordUtf8(const std::string& strWord)
 }
 
 std::vector<const std::basic_string<gunichar2>> 
-SpellDictionary::GetSuggestionsFromWordUtf16(const std::basic_string<gunichar2>& strWord) 
+SpellDictionary::SegmentTextUtf16(const std::basic_string<gunichar2>& strText) 
 {
-    std::vector<const std::basic_string<gunichar>> suggestions;
-    suggestions = GetSuggestionsFromWord(Convert::ToUcs4(strWord));
+    std::vector<const std::basic_string<gunichar>> segments;
+    segments = SegmentText(Convert::ToUcs4(strText));
 
     std::vector<const std::basic_string<gunichar2>> result;
 
-    for(std::vector<const std::basic_string<gunichar>>::iterator it = suggestions.begin();
-        it != suggestions.end(); 
+    for(std::vector<const std::basic_string<gunichar>>::iterator it = segments.begin();
+        it != segments.end(); 
         ++it) 
     {
         result.push_back(Convert::ToUtf16(*it));
@@ -122,15 +1224,26 @@ SpellDictionary::GetSuggestionsFromWordUtf16(const std::basic_string<gunichar2>&
 }
 
 void 
-SpellDictionary::AddWord(const std::basic_string<gunichar>& strWord) 
+SpellDictionary::AddWord(const std::basic_string<gunichar>& word) 
 {
   Load();
+  // as the words read from the file are
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+
   // only bother saving if an insertion actually occured.
-  if(rgWordList_.find(strWord) != rgWordList_.end()){
+  if(FindWord(strWord.begin(), strWord.end()) != NULL){
     return;
   }
 
-  rgWordList_.insert(strWord);
+  // a variant hides the base's word, if it has it, already
+  rgWordList_.insert(wordlist_type::value_type(strWord, 0));
+  ++nWordsVersion_;
+  fUtf8IndexBuilt_ = false;
+  fExactIndexBuilt_ = false;
+  fWordsAddedSinceExactHash_ = true;
+  if(fBloomFilterBuilt_) {
+    bloomFilter_.insert(strWord);
+  }
   Save();
 }
 
@@ -153,7 +1266,21 @@ SpellDictionary::RemoveWord(const std::basic_string<gunichar>& word)
   std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
 
   // only bother saving if a removal actually occured.
-  if (rgWordList_.erase(strWord) != 0){
+  const wordlist_type::value_type* pWord = FindWord(strWord.begin(), strWord.end());
+  if (pWord != NULL){
+    nTotalFrequency_ -= pWord->second;
+    if(rgWordList_.find(strWord) != rgWordList_.end()) {
+      rgWordList_.erase(strWord); // by key, so it may compact
+    }
+    const wordlist_type::value_type* pBaseWord = (pBase_ != NULL) ? pBase_->FindWord(strWord.begin(), strWord.end()) : NULL;
+    if(pBaseWord != NULL && !IsHidden(pBaseWord->first)) {
+      Hide(strWord);
+    }
+    ++nWordsVersion_;
+    fUtf8IndexBuilt_ = false;
+    fExactIndexBuilt_ = false;
+    fExactHashBuilt_ = false;
+    fBloomFilterBuilt_ = false;
     Save();
   }
 }
@@ -170,13 +1297,150 @@ SpellDictionary::RemoveWordUtf16(const std::basic_string<gunichar2>& strWord)
     RemoveWord(Convert::ToUcs4(strWord));
 }
 
+// erases the word if it is there, giving whether it was
+static bool
+EraseWord(SpellDictionary::wordlist_type& rgWords, const std::basic_string<gunichar>& strWord)
+{
+    if(rgWords.find(strWord) == rgWords.end())
+    {
+        return false;
+    }
+    rgWords.erase(strWord);
+    return true;
+}
+
+void 
+SpellDictionary::AddPersonalWord(const std::basic_string<gunichar>& word) 
+{
+  Load();
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  EraseWord(rgExcludedWordList_, strWord);
+  if(IsInWordList(strWord) || rgPersonalWordList_.find(strWord) != rgPersonalWordList_.end()) {
+    return;
+  }
+
+  EraseWord(rgSessionWordList_, strWord);
+  rgPersonalWordList_.insert(wordlist_type::value_type(strWord, 0));
+  SavePersonalWords();
+}
+
+void 
+SpellDictionary::AddPersonalWordUtf8(const std::string& strWord) 
+{
+    AddPersonalWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::AddPersonalWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    AddPersonalWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::AddSessionWord(const std::basic_string<gunichar>& word) 
+{
+  Load();
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  EraseWord(rgExcludedWordList_, strWord);
+  if(IsInWordList(strWord) || IsInLayers(strWord)) {
+    return;
+  }
+
+  rgSessionWordList_.insert(wordlist_type::value_type(strWord, 0));
+}
+
+void 
+SpellDictionary::AddSessionWordUtf8(const std::string& strWord) 
+{
+    AddSessionWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::AddSessionWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    AddSessionWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::RemoveSessionWord(const std::basic_string<gunichar>& word) 
+{
+  EraseWord(rgSessionWordList_, Normalize::ToNFD(word));
+}
+
+void 
+SpellDictionary::RemoveSessionWordUtf8(const std::string& strWord) 
+{
+    RemoveSessionWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::RemoveSessionWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    RemoveSessionWord(Convert::ToUcs4(strWord));
+}
+
+bool 
+SpellDictionary::IsSessionWord(const std::basic_string<gunichar>& word) 
+{
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  return rgSessionWordList_.find(strWord) != rgSessionWordList_.end();
+}
+
+bool 
+SpellDictionary::IsSessionWordUtf8(const std::string& strWord) 
+{
+    return IsSessionWord(Convert::ToUcs4(strWord));
+}
+
+bool 
+SpellDictionary::IsSessionWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    return IsSessionWord(Convert::ToUcs4(strWord));
+}
+
+// an excluded word leaves the personal and session words
+void 
+SpellDictionary::ExcludeWord(const std::basic_string<gunichar>& word) 
+{
+  Load();
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  if(rgExcludedWordList_.find(strWord) == rgExcludedWordList_.end()) {
+    rgExcludedWordList_.insert(wordlist_type::value_type(strWord, 0));
+  }
+  EraseWord(rgSessionWordList_, strWord);
+  if(EraseWord(rgPersonalWordList_, strWord)) {
+    SavePersonalWords();
+  }
+}
+
+void 
+SpellDictionary::ExcludeWordUtf8(const std::string& strWord) 
+{
+    ExcludeWord(Convert::ToUcs4(strWord));
+}
+
+void 
+SpellDictionary::ExcludeWordUtf16(const std::basic_string<gunichar2>& strWord) 
+{
+    ExcludeWord(Convert::ToUcs4(strWord));
+}
+
 void 
 SpellDictionary::RemoveAllWords() 
 {
   Load();
   // only bother saving if a removal actually occured.
-  if(!rgWordList_.empty()){
+  if(GetWordCount() != 0){
     rgWordList_.clear();
+    // with no words there is nothing left to share with the base
+    pBase_ = NULL;
+    rgfHidden_.clear();
+    ++nWordsVersion_;
+    nTotalFrequency_ = 0;
+    fUtf8IndexBuilt_ = false;
+    fExactIndexBuilt_ = false;
+    fExactHashBuilt_ = false;
+    fBloomFilterBuilt_ = false;
     Save();
   }
 }
@@ -186,20 +1450,321 @@ size_t
 SpellDictionary::GetEntryCount() 
 {
   Load();
-  return rgWordList_.size();
+  return GetWordCount();
+}
+
+size_t 
+SpellDictionary::GetEntryCountWithPrefix(const std::basic_string<gunichar>& prefix) 
+{
+  Load();
+  return GetWordCountWithPrefix(Normalize::ToNFD(prefix));
+}
+
+size_t 
+SpellDictionary::GetWordCount() 
+{
+  size_t cWords = rgWordList_.size();
+  if(pBase_ != NULL) {
+    cWords += pBase_->GetWordCount() - GetHiddenCount();
+  }
+  return cWords;
+}
+
+size_t 
+SpellDictionary::GetWordCountWithPrefix(const std::basic_string<gunichar>& strPrefix) 
+{
+  size_t cWords = rgWordList_.count_prefix(strPrefix);
+  if(pBase_ != NULL) {
+    cWords += pBase_->GetWordCountWithPrefix(strPrefix) - GetHiddenCountWithPrefix(strPrefix);
+  }
+  return cWords;
+}
+
+size_t 
+SpellDictionary::GetWordId(const std::basic_string<gunichar>& word) 
+{
+  Load();
+  std::basic_string<gunichar> strWord = Normalize::ToNFD(word);
+  if(FindWord(strWord.begin(), strWord.end()) == NULL) {
+    return static_cast<size_t>(-1);
+  }
+  return GetRank(strWord);
+}
+
+std::basic_string<gunichar> 
+SpellDictionary::GetWordFromId(size_t id) 
+{
+  Load();
+  const wordlist_type::value_type* pWord = SelectWord(id);
+  if(pWord == NULL) {
+    return std::basic_string<gunichar>();
+  }
+  return pWord->first;
+}
+
+// the number of words before the word, which need not be one of them: for
+// a variant, those of the base it does not hide and its own
+size_t 
+SpellDictionary::GetRank(const std::basic_string<gunichar>& strWord)
+{
+  size_t iWord = rgWordList_.rank(strWord);
+  if(pBase_ != NULL) {
+    const size_t iBase = pBase_->rgWordList_.rank(strWord);
+    iWord += iBase - rgfHidden_.rank1(iBase);
+  }
+  return iWord;
+}
+
+// the word GetRank puts at iWord, or NULL if there are not that many. The
+// ranks of a variant's own words grow with their positions in its word
+// list, so a binary search finds how many of them come before iWord; the
+// rest are the base's words it does not hide.
+const SpellDictionary::wordlist_type::value_type* 
+SpellDictionary::SelectWord(size_t iWord)
+{
+  if(pBase_ == NULL) {
+    wordlist_type::const_iterator it = rgWordList_.select(iWord);
+    return (it == rgWordList_.end()) ? NULL : &*it;
+  }
+
+  size_t cOwnBefore = 0;
+  size_t cOwnAfter = rgWordList_.size();
+  while(cOwnBefore != cOwnAfter) {
+    const size_t iMiddle = cOwnBefore + (cOwnAfter - cOwnBefore) / 2;
+    if(GetRank(rgWordList_.select(iMiddle)->first) < iWord) {
+      cOwnBefore = iMiddle + 1;
+    }
+    else {
+      cOwnAfter = iMiddle;
+    }
+  }
+  if(cOwnBefore != rgWordList_.size()) {
+    wordlist_type::const_iterator it = rgWordList_.select(cOwnBefore);
+    if(GetRank(it->first) == iWord) {
+      return &*it;
+    }
+  }
+
+  const size_t iShown = iWord - cOwnBefore;
+  if(iShown >= pBase_->rgWordList_.size() - GetHiddenCount()) {
+    return NULL;
+  }
+  return &*pBase_->rgWordList_.select(rgfHidden_.select0(iShown));
 }
 
 void 
 SpellDictionary::Load()  
 {
-    if(!pDictionaryFile_->HasFileChanged())
+    LoadPersonalWords();
+
+    // a variant is taken again from its file when the base changes
+    bool fBaseChanged = false;
+    if(pBase_ != NULL)
+    {
+        pBase_->Load();
+        fBaseChanged = (pBase_->nWordsVersion_ != nBaseWordsVersion_);
+    }
+    if(!pDictionaryFile_->HasFileChanged() && !fBaseChanged)
     {
         return;
     }
 
     rgWordList_.clear();
+    ++nWordsVersion_;
+    fUtf8IndexBuilt_ = false;
+    fExactIndexBuilt_ = false;
+    fExactHashBuilt_ = false;
+    fBloomFilterBuilt_ = false;
 
     pDictionaryFile_->GetWordsFromFile(rgWordList_);
+
+    nTotalFrequency_ = 0;
+    for(wordlist_iterator it = rgWordList_.begin(); it != rgWordList_.end(); ++it)
+    {
+        nTotalFrequency_ += it->second;
+    }
+
+    if(pBase_ != NULL)
+    {
+        TakeDeltasFromBase();
+        nBaseWordsVersion_ = pBase_->nWordsVersion_;
+    }
+    // the word list is read far more often than it changes
+    rgWordList_.compact();
+}
+
+// the personal words, taken again from their file when it changes
+void 
+SpellDictionary::LoadPersonalWords()  
+{
+    if(pPersonalDictionaryFile_ == NULL || !pPersonalDictionaryFile_->HasFileChanged())
+    {
+        return;
+    }
+    rgPersonalWordList_.clear();
+    pPersonalDictionaryFile_->GetWordsFromFile(rgPersonalWordList_);
+}
+
+// Keeps the words which are not in the base or have another frequency
+// there, and hides those of the base which are not in the word list or
+// have another frequency. Both are in order, so one walk along each does,
+// and the base's words are marked hidden or not in order too.
+void 
+SpellDictionary::TakeDeltasFromBase()  
+{
+    wordlist_type rgWords;
+    rgWords.swap(rgWordList_);
+    rgfHidden_.clear();
+
+    const wordlist_type& rgBaseWords = pBase_->rgWordList_;
+    wordlist_type::const_iterator itBase = rgBaseWords.begin();
+    wordlist_type::const_iterator it = rgWords.begin();
+    while(itBase != rgBaseWords.end() || it != rgWords.end())
+    {
+        if(it == rgWords.end() || (itBase != rgBaseWords.end() && itBase->first < it->first))
+        {
+            rgfHidden_.push_back(true);
+            ++itBase;
+        }
+        else if(itBase == rgBaseWords.end() || it->first < itBase->first)
+        {
+            rgWordList_.insert(*it);
+            ++it;
+        }
+        else
+        {
+            const bool fHidden = (it->second != itBase->second);
+            if(fHidden)
+            {
+                rgWordList_.insert(*it);
+            }
+            rgfHidden_.push_back(fHidden);
+            ++itBase;
+            ++it;
+        }
+    }
+    rgfHidden_.freeze();
+}
+
+SpellDictionary::VariantWords::VariantWords(const SpellDictionary& variant)
+: variant_(variant),
+  itBase_(variant.pBase_->rgWordList_.begin()), iBase_(0),
+  it_(variant.rgWordList_.begin())
+{
+    SkipHidden();
+}
+
+bool 
+SpellDictionary::VariantWords::AtEnd() const
+{
+    return itBase_ == variant_.pBase_->rgWordList_.end() && it_ == variant_.rgWordList_.end();
+}
+
+// no word is in both, as the variant hides a base word it has itself
+bool 
+SpellDictionary::VariantWords::IsBaseNext() const
+{
+    if(itBase_ == variant_.pBase_->rgWordList_.end())
+    {
+        return false;
+    }
+    return it_ == variant_.rgWordList_.end() || itBase_->first < it_->first;
+}
+
+const SpellDictionary::wordlist_type::value_type& 
+SpellDictionary::VariantWords::operator*() const
+{
+    return IsBaseNext() ? *itBase_ : *it_;
+}
+
+const SpellDictionary::wordlist_type::value_type* 
+SpellDictionary::VariantWords::operator->() const
+{
+    return &**this;
+}
+
+void 
+SpellDictionary::VariantWords::Next()
+{
+    if(IsBaseNext())
+    {
+        ++itBase_;
+        ++iBase_;
+        SkipHidden();
+    }
+    else
+    {
+        ++it_;
+    }
+}
+
+void 
+SpellDictionary::VariantWords::SkipHidden()
+{
+    while(itBase_ != variant_.pBase_->rgWordList_.end() && variant_.rgfHidden_[iBase_])
+    {
+        ++itBase_;
+        ++iBase_;
+    }
+}
+
+const SpellDictionary::utf8_index_type& 
+SpellDictionary::GetUtf8Index()  
+{
+    if(!fUtf8IndexBuilt_)
+    {
+        utf8Index_.assign(rgWordList_);
+        fUtf8IndexBuilt_ = true;
+    }
+    return utf8Index_;
+}
+
+const SpellDictionary::exact_index_type& 
+SpellDictionary::GetExactIndex()  
+{
+    if(!fExactIndexBuilt_)
+    {
+        exactIndex_.assign(rgWordList_);
+        fExactIndexBuilt_ = true;
+    }
+    return exactIndex_;
+}
+
+const SpellDictionary::exact_hash_type& 
+SpellDictionary::GetExactHash()  
+{
+    if(!fExactHashBuilt_)
+    {
+        exactHash_.assign(rgWordList_);
+        fExactHashBuilt_ = true;
+        fWordsAddedSinceExactHash_ = false;
+    }
+    return exactHash_;
+}
+
+const SpellDictionary::bloom_filter_type& 
+SpellDictionary::GetBloomFilter()  
+{
+    if(!fBloomFilterBuilt_)
+    {
+        bloomFilter_.assign(rgWordList_);
+        fBloomFilterBuilt_ = true;
+    }
+    return bloomFilter_;
+}
+
+double 
+SpellDictionary::GetExactHashBitsPerKey()  
+{
+    Load();
+    return GetExactHash().bits_per_key();
+}
+
+double 
+SpellDictionary::GetExactHashBuildSeconds()  
+{
+    Load();
+    return GetExactHash().build_seconds();
 }
 
 void 
@@ -211,5 +1776,25 @@ SpellDictionary::Save()
 
     assert(!pDictionaryFile_->HasFileChanged());
 
-    pDictionaryFile_->SaveWordsToFile(rgWordList_);
+    if(pBase_ == NULL)
+    {
+        pDictionaryFile_->SaveWordsToFile(rgWordList_);
+        return;
+    }
+    // a variant's file has all its words, which are put together as they
+    // are written
+    VariantWords words(*this);
+    pDictionaryFile_->SaveWordsToFile(words);
+}
+
+void 
+SpellDictionary::SavePersonalWords() 
+{
+    if(pPersonalDictionaryFile_ == NULL || pPersonalDictionaryFile_->IsReadOnly()) {
+        return;
+    }
+
+    assert(!pPersonalDictionaryFile_->HasFileChanged());
+
+    pPersonalDictionaryFile_->SaveWordsToFile(rgPersonalWordList_);
 }
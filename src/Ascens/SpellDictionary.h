@@ -24,7 +24,13 @@
 
 #include <string>
 #include <vector>
-#include "trie_set"
+#include "trie_map"
+#include "stl_radix_trie.h"
+#include "stl_double_array.h"
+#include "stl_louds_trie.h"
+#include "stl_perfect_hash.h"
+#include "stl_bloom_filter.h"
+#include "stl_rank_select.h"
 #include <glib.h>
 
 class IDictionaryFile; // don't include IDictionaryFile.h since IDictionaryFile.h includes SpellDictionary.h for wordlist_type
@@ -34,8 +40,68 @@ class IDictionaryFile; // don't include IDictionaryFile.h since IDictionaryFile.
 class SpellDictionary
 {
 public:
-  typedef trie::trie_set<std::basic_string<gunichar>>     wordlist_type;
+  enum SegmentationMode {
+    MaximalMatching,    // fewest words
+    FrequencyWeighted   // most probable words, by their frequencies
+  };
+
+  // each word maps to its frequency (0 if unknown) which orders suggestions
+  typedef trie::trie_map<std::basic_string<gunichar>, unsigned int>  wordlist_type;
   typedef wordlist_type::iterator                         wordlist_iterator;
+  typedef std::basic_string<gunichar>::const_iterator     word_iterator;
+
+  // the word list keyed on UTF-8 bytes, for the UTF-8 entry points. UTF-8
+  // uses at most 243 distinct bytes, so guint8 codes always number them. It
+  // is an index besides the word list, not a UTF-8 store in its place: the
+  // UCS-4 word list still backs every other entry point, the files and the
+  // edits, and the index keeps an iterator into it for each word, so it adds
+  // to the memory of a dictionary rather than shrinking it. With
+  // ASCENS_SUCCINCT_INDEX it is a LOUDS trie, whose tree structure takes a
+  // tenth of the radix trie's nodes but is slower to search. It is still an
+  // index of this word list and cannot stand in for it: see
+  // stl_louds_trie.h.
+#if defined(ASCENS_SUCCINCT_INDEX)
+  typedef trie::louds_trie<wordlist_type, guint8, trie::__utf8_units> utf8_index_type;
+#else
+  typedef trie::radix_trie<wordlist_type, guint8, trie::__utf8_units> utf8_index_type;
+#endif
+
+  // the words of the word list alone, for IsWordPresent
+  typedef trie::double_array<wordlist_type> exact_index_type;
+
+  // a fingerprint of each word of the word list, for IsWordPresent
+  typedef trie::perfect_hash<wordlist_type> exact_hash_type;
+
+  // rules out most words not in the word list before it is searched
+  typedef trie::bloom_filter<wordlist_type> bloom_filter_type;
+
+  // a word from each dictionary and the edit distance between them
+  struct WordPair {
+    std::basic_string<gunichar> strWord;
+    std::basic_string<gunichar> strOtherWord;
+    unsigned short nDistance;
+  };
+
+  // the words of a variant in order, those of its base it does not hide
+  // merged with its own as they are walked, so it is saved without
+  // putting them together (see IDictionaryFile::SaveWordsToFile)
+  class VariantWords {
+  public:
+    VariantWords(const SpellDictionary& variant);
+    bool AtEnd() const;
+    const wordlist_type::value_type& operator*() const;
+    const wordlist_type::value_type* operator->() const;
+    void Next();
+
+  private:
+    void SkipHidden();
+    bool IsBaseNext() const;
+
+    const SpellDictionary& variant_;
+    wordlist_type::const_iterator itBase_;
+    size_t iBase_;                     // the position of itBase_ in the base
+    wordlist_type::const_iterator it_;
+  };
 
 public:
   SpellDictionary();
@@ -45,16 +111,53 @@ public:
 // the dictionaryFile's lifetime is then managed by this class
 void Load (IDictionaryFile * const pDictionaryFile);
 
+//     LoadVariant              -- associates the dictionary file of a variant of base's language --
+// (en_GB of en_US, say). Only the words which differ from base are kept:
+// those the file adds or gives another frequency, and those of base it
+// leaves out. Everything else is looked up in base, which is shared by all
+// its variants, must outlive them and must not be a variant itself. The
+// file still lists all the words of the variant and is saved that way, and
+// it is read and compared with base again whenever base's words change.
+void LoadVariant (SpellDictionary& base, IDictionaryFile * const pDictionaryFile);
+
 //     IsWordPresent            -- determines if the word exists in the dictionary --
+// (or is a compound of words in the dictionary, see SetCompoundMaxParts)
 bool IsWordPresent(const std::basic_string<gunichar>& strWord);
 bool IsWordPresentUtf8(const std::string& strWord);
 bool IsWordPresentUtf16(const std::basic_string<gunichar2>& strWord);
   
 //     GetSuggestionsFromWord   -- gives a list of words which a similar by N distinctions --
+// closest and then most frequent first
 std::vector<const std::basic_string<gunichar> > GetSuggestionsFromWord(const std::basic_string<gunichar>& strWord);
 std::vector<const std::string> GetSuggestionsFromWordUtf8(const std::string& strWord);
 std::vector<const std::basic_string<gunichar2> > GetSuggestionsFromWordUtf16(const std::basic_string<gunichar2>& strWord);
 
+//     GetCompletions           -- gives the N most frequent words which begin with the prefix --
+std::vector<const std::basic_string<gunichar> > GetCompletions(const std::basic_string<gunichar>& strPrefix, size_t nCompletions);
+std::vector<const std::string> GetCompletionsUtf8(const std::string& strPrefix, size_t nCompletions);
+std::vector<const std::basic_string<gunichar2> > GetCompletionsUtf16(const std::basic_string<gunichar2>& strPrefix, size_t nCompletions);
+
+//     GetWordsMatchingPattern  -- gives the words matching a pattern like "c?t", "re*ing" or "[bc]at" --
+// ? matches any character, * any run of characters, [abc] [a-z] [^abc] a
+// class of characters and \ makes the next character literal. The pattern is
+// normalized (NFD), so ? matches a combining mark on its own, but a class
+// member such as é still matches é as a whole.
+std::vector<const std::basic_string<gunichar> > GetWordsMatchingPattern(const std::basic_string<gunichar>& strPattern);
+std::vector<const std::string> GetWordsMatchingPatternUtf8(const std::string& strPattern);
+std::vector<const std::basic_string<gunichar2> > GetWordsMatchingPatternUtf16(const std::basic_string<gunichar2>& strPattern);
+
+//     GetNearDuplicates        -- gives the pairs of words within nDistance edits of each other --
+// one from this dictionary and one from the other, found in one walk of both
+// word lists. Given this dictionary itself, each pair is given once.
+std::vector<WordPair> GetNearDuplicates(SpellDictionary& other, unsigned short nDistance);
+
+//     SegmentText              -- splits text without spaces (Thai, Lao, Khmer, Japanese) into words --
+// in linear time. A run of characters that are not part of any word is
+// returned as one segment. Segments are normalized (NFD).
+std::vector<const std::basic_string<gunichar> > SegmentText(const std::basic_string<gunichar>& strText);
+std::vector<const std::string> SegmentTextUtf8(const std::string& strText);
+std::vector<const std::basic_string<gunichar2> > SegmentTextUtf16(const std::basic_string<gunichar2>& strText);
+
 //     AddWord                  -- adds the word to the dictionary if it does not exist --
   void AddWord(const std::basic_string<gunichar>& strWord);
   void AddWordUtf8(const std::string& strWord);
@@ -67,7 +170,46 @@ std::vector<const std::basic_string<gunichar2> > GetSuggestionsFromWordUtf16(con
   
   void RemoveAllWords();
 
+//     Layers                   -- personal and session words kept apart from the word list --
+// Personal words are saved to a file of their own, which LoadPersonal hands
+// over like Load, and session words are forgotten with the dictionary;
+// adding either never touches the word list, its file or a variant's base.
+// An excluded word is neither accepted nor suggested, whichever layer has
+// it, for as long as the dictionary lives. Checks look in the word list
+// and then the layers; suggestions, completions and pattern matches are
+// found in all of them at once. Layer words are not parts of compounds or
+// split suggestions. The UTF-8 index is not used for suggestions while the
+// layers have words, nor for accepting words while some are excluded.
+void LoadPersonal (IDictionaryFile * const pPersonalDictionaryFile);
+
+  void AddPersonalWord(const std::basic_string<gunichar>& strWord);
+  void AddPersonalWordUtf8(const std::string& strWord);
+  void AddPersonalWordUtf16(const std::basic_string<gunichar2>& strWord);
+
+  void AddSessionWord(const std::basic_string<gunichar>& strWord);
+  void AddSessionWordUtf8(const std::string& strWord);
+  void AddSessionWordUtf16(const std::basic_string<gunichar2>& strWord);
+
+  void RemoveSessionWord(const std::basic_string<gunichar>& strWord);
+  void RemoveSessionWordUtf8(const std::string& strWord);
+  void RemoveSessionWordUtf16(const std::basic_string<gunichar2>& strWord);
+
+  bool IsSessionWord(const std::basic_string<gunichar>& strWord);
+  bool IsSessionWordUtf8(const std::string& strWord);
+  bool IsSessionWordUtf16(const std::basic_string<gunichar2>& strWord);
+
+  void ExcludeWord(const std::basic_string<gunichar>& strWord);
+  void ExcludeWordUtf8(const std::string& strWord);
+  void ExcludeWordUtf16(const std::basic_string<gunichar2>& strWord);
+
   size_t GetEntryCount();
+  size_t GetEntryCountWithPrefix(const std::basic_string<gunichar>& strPrefix);
+
+//     GetWordId                -- gives a dense id (0 to GetEntryCount()-1) for the word --
+// so data about words can be kept in arrays. Returns -1 if the word is not
+// present. Ids stay the same until a word is added or removed.
+  size_t GetWordId(const std::basic_string<gunichar>& strWord);
+  std::basic_string<gunichar> GetWordFromId(size_t id);
 
   unsigned short GetSuggestionErrorTolerance() const
   {
@@ -85,13 +227,175 @@ std::vector<const std::basic_string<gunichar2> > GetSuggestionsFromWordUtf16(con
       nBestErrorTolerance_ = value;
   }
 
+  // the most suggestions taken from the word list (0 is no limit)
+  size_t GetMaxSuggestions() const
+  {
+      return nMaxSuggestions_;
+  }
+  void SetMaxSuggestions(size_t value){
+      nMaxSuggestions_ = value;
+  }
+
+//     Compounds                -- words made by joining dictionary words (German, Dutch) --
+// are accepted when they need no more than CompoundMaxParts parts (1, the
+// default, turns compounds off). Each part must be at least
+// CompoundMinPartLength long and parts may be joined by one of the linking
+// morphemes (e.g. the German "s" in "Arbeitsamt").
+  unsigned short GetCompoundMaxParts() const
+  {
+      return nCompoundMaxParts_;
+  }
+  void SetCompoundMaxParts(unsigned short value){
+      nCompoundMaxParts_ = value;
+  }
+
+  unsigned short GetCompoundMinPartLength() const
+  {
+      return nCompoundMinPartLength_;
+  }
+  void SetCompoundMinPartLength(unsigned short value){
+      nCompoundMinPartLength_ = value;
+  }
+
+  void SetCompoundLinkingMorphemes(const std::vector<const std::basic_string<gunichar> >& rgstrMorphemes);
+
+//     Utf8Index                -- lets IsWordPresentUtf8 and GetSuggestionsFromWordUtf8 --
+// search a copy of the word list keyed on UTF-8 bytes, so their words are
+// never converted to UCS-4 (edits are still counted per character). The
+// copy is built when first needed and again after the words change, and is
+// kept besides the word list, so it trades memory for speed; it is off
+// unless asked for. A variant (see LoadVariant) does without it rather
+// than copy the base.
+  bool GetUseUtf8Index() const
+  {
+      return fUseUtf8Index_;
+  }
+  void SetUseUtf8Index(bool value){
+      fUseUtf8Index_ = value;
+  }
+
+//     ExactIndex               -- lets IsWordPresent look words up in a double-array --
+// copy of the word list, which costs two array reads a character instead of
+// a walk along each list of siblings. Like the Utf8Index it is built when
+// first needed and again after the words change.
+  bool GetUseExactIndex() const
+  {
+      return fUseExactIndex_;
+  }
+  void SetUseExactIndex(bool value){
+      fUseExactIndex_ = value;
+  }
+
+//     ExactHash                -- lets IsWordPresent check words with a minimal perfect --
+// hash and a 32 bit fingerprint of each word: one hash and one comparison.
+// A word not in the dictionary is accepted about once in 4 billion checks.
+// Words added since the hash was built are looked for in the word list; it
+// is built again after a word is removed or the dictionary file reloaded.
+// Takes precedence over the ExactIndex.
+  bool GetUseExactHash() const
+  {
+      return fUseExactHash_;
+  }
+  void SetUseExactHash(bool value){
+      fUseExactHash_ = value;
+  }
+  // the bits a word and the build time in seconds of the hash, for reporting
+  double GetExactHashBitsPerKey();
+  double GetExactHashBuildSeconds();
+
+//     BloomFilter              -- lets IsWordPresent turn away most words which are --
+// not in the dictionary after reading one cache line, before the word list
+// or an index is searched. Added words are put in the filter; it is built
+// again after a word is removed or the dictionary file reloaded.
+  bool GetUseBloomFilter() const
+  {
+      return fUseBloomFilter_;
+  }
+  void SetUseBloomFilter(bool value){
+      fUseBloomFilter_ = value;
+  }
+
+  SegmentationMode GetSegmentationMode() const
+  {
+      return segmentationMode_;
+  }
+  void SetSegmentationMode(SegmentationMode value){
+      segmentationMode_ = value;
+  }
+
 private:
+    friend class VariantWords;
+
+    // a bit for each word of a variant's base, in order
+    typedef trie::__rank_select_bits hidden_bits_type;
+
+    bool IsInWordList(const std::basic_string<gunichar>& strWord);
+    const wordlist_type::value_type* FindWord(const word_iterator& itBegin, const word_iterator& itEnd);
+    bool IsHidden(const std::basic_string<gunichar>& strWord);
+    size_t GetHiddenCount() const;
+    size_t GetHiddenCountWithPrefix(const std::basic_string<gunichar>& strPrefix);
+    void Hide(const std::basic_string<gunichar>& strWord);
+    std::vector<wordlist_type::const_iterator> FindPrefixes(const word_iterator& itBegin, const word_iterator& itEnd);
+    std::vector<wordlist_type::const_iterator> WeightedFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance, size_t nMax);
+    std::vector<wordlist_type::const_iterator> BestFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance);
+    std::vector<wordlist_type::const_iterator> Complete(const std::basic_string<gunichar>& strPrefix, size_t nCompletions);
+    std::vector<wordlist_type::const_iterator> PatternFind(const std::basic_string<gunichar>& strPattern);
+    size_t RemoveHidden(std::vector<wordlist_type::const_iterator>& rgIt);
+    size_t GetWordCount();
+    size_t GetWordCountWithPrefix(const std::basic_string<gunichar>& strPrefix);
+    size_t GetRank(const std::basic_string<gunichar>& strWord);
+    const wordlist_type::value_type* SelectWord(size_t iWord);
+    void TakeDeltasFromBase();
+    void JoinWordLists(const wordlist_type& rgWords, bool fHiding, SpellDictionary& other, const wordlist_type& rgOtherWords, bool fOtherHiding, unsigned short nDistance, bool fOnce, std::vector<WordPair>& rgPairs);
+    bool HasLayers() const;
+    bool IsInLayers(const std::basic_string<gunichar>& strWord) const;
+    bool IsExcluded(const std::basic_string<gunichar>& strWord) const;
+    size_t RemoveExcluded(std::vector<wordlist_type::const_iterator>& rgIt) const;
+    void AddLayerWords(std::vector<wordlist_type::const_iterator>& rgIt, const std::vector<wordlist_type::const_iterator>& rgLayerIt);
+    std::vector<wordlist_type::const_iterator> LayeredWeightedFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance, size_t nMax);
+    std::vector<wordlist_type::const_iterator> LayeredBestFind(const std::basic_string<gunichar>& strWord, unsigned short nDistance);
+    std::vector<wordlist_type::const_iterator> LayeredComplete(const std::basic_string<gunichar>& strPrefix, size_t nCompletions);
+    void LoadPersonalWords();
+    void SavePersonalWords();
+    bool IsCompound(const std::basic_string<gunichar>& strWord);
+    const utf8_index_type& GetUtf8Index();
+    const exact_index_type& GetExactIndex();
+    const exact_hash_type& GetExactHash();
+    const bloom_filter_type& GetBloomFilter();
+    std::vector<const std::string> GetSuggestionsFromUtf8Index(const std::string& strWord);
     void ReleaseDictionaryFile();
     void Load();
     void Save();
 
-  wordlist_type rgWordList_;
+  wordlist_type rgWordList_;           // for a variant, the words not as in the base
   IDictionaryFile* pDictionaryFile_;
   unsigned short nErrorTolerance_;
   unsigned short nBestErrorTolerance_;
+  size_t nMaxSuggestions_;
+  unsigned short nCompoundMaxParts_;
+  unsigned short nCompoundMinPartLength_;
+  std::vector<const std::basic_string<gunichar> > rgstrCompoundLinkingMorphemes_;
+  SegmentationMode segmentationMode_;
+  unsigned long long nTotalFrequency_;
+  utf8_index_type utf8Index_;
+  bool fUseUtf8Index_;
+  bool fUtf8IndexBuilt_;
+  exact_index_type exactIndex_;
+  bool fUseExactIndex_;
+  bool fExactIndexBuilt_;
+  exact_hash_type exactHash_;
+  bool fUseExactHash_;
+  bool fExactHashBuilt_;
+  bool fWordsAddedSinceExactHash_;
+  bloom_filter_type bloomFilter_;
+  bool fUseBloomFilter_;
+  bool fBloomFilterBuilt_;
+  SpellDictionary* pBase_;             // the dictionary this is a variant of, or NULL
+  hidden_bits_type rgfHidden_;         // whether each word of the base, in order, is not in the variant
+  unsigned long nWordsVersion_;        // changes whenever the words do
+  unsigned long nBaseWordsVersion_;    // the base's when the variant was last loaded
+  wordlist_type rgPersonalWordList_;   // personal words not in the word list
+  IDictionaryFile* pPersonalDictionaryFile_;
+  wordlist_type rgSessionWordList_;    // session words in neither of the others
+  wordlist_type rgExcludedWordList_;   // words never accepted
 };
\ No newline at end of file
@@ -64,7 +64,7 @@ public:
     {
         return false;
     }
-    virtual bool SaveWordToFile(std::basic_string<gunichar> s)
+    virtual bool SaveWordToFile(std::basic_string<gunichar> s, unsigned int nFrequency)
     {
         return false;
     }
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A blocked Bloom filter of the keys of one of the trie containers, which
+ * tells that a key is certainly not in the trie.
+ *
+ * F. Putze, P. Sanders and J. Singler, "Cache-, Hash- and Space-Efficient
+ * Bloom Filters", 6th Workshop on Experimental Algorithms, 2007.
+ *
+ * A key sets _S_probes bits, all in the one block of 512 bits (a cache
+ * line) picked by its hash, so a key is tested by reading a single block.
+ * With ten bits a key about one key in a hundred that is not in the trie
+ * passes; one which is always does. Keys can be added but not taken out, so
+ * the filter must be built again (assign) after a key is erased from the
+ * trie.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_BLOOM_FILTER_H
+#define __INTERNAL_BLOOM_FILTER_H
+
+#include <vector>
+#include <algorithm>
+#include <stl_trie_hash.h>
+
+namespace trie {
+
+template <class _Trie>
+class bloom_filter {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::size_type       size_type;
+
+  enum { _S_block_words = 8,     // 512 bits
+         _S_probes = 7,          // bits set by a key, 9 bits of hash each
+         _S_bits_per_key = 10
+  };
+
+private:
+  // sets the bits of each key of the trie
+  class _KeyInserter {
+  public:
+    _KeyInserter(bloom_filter* __filter) : _M_filter(__filter) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref) {
+      _M_filter->_M_insert(__hash_key(__first, __last));
+    }
+  private:
+    bloom_filter* _M_filter;
+  };
+
+  std::vector<unsigned long long> _M_words;
+
+public:
+  // allocation/deallocation
+
+  bloom_filter() {}
+
+  explicit bloom_filter(const _Trie& __t, size_type __cBitsPerKey = _S_bits_per_key) {
+    assign(__t, __cBitsPerKey);
+  }
+
+  // builds the filter from the keys of __t, with about __cBitsPerKey bits
+  // for each of them
+  void assign(const _Trie& __t, size_type __cBitsPerKey = _S_bits_per_key) {
+    const size_type __cBlocks = std::max<size_type>(1, (__t.size() * __cBitsPerKey + 511) / 512);
+    _M_words.assign(__cBlocks * _S_block_words, 0);
+    __t.for_each(_KeyInserter(this));
+  }
+
+  void clear() { _M_words.clear(); }
+
+  size_type memory_size() const { return _M_words.size() * sizeof(unsigned long long); }
+
+  // adds a key to the filter
+  void insert(const key_type& __x) {
+    insert(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  void insert(_InputIterator __itKey, const _InputIterator& __itKeyEnd) {
+    if(!_M_words.empty()) {
+      _M_insert(__hash_key(__itKey, __itKeyEnd));
+    }
+  }
+
+  // 0 if the key __x is certainly not in the filter, 1 if it may be
+  size_type count(const key_type& __x) const {
+    return count(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  size_type count(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    if(_M_words.empty()) {
+      return 1; // never built, so nothing is ruled out
+    }
+    const unsigned long long __h = __hash_key(__itKey, __itKeyEnd);
+    const unsigned long long* __block = _M_block(__h);
+    unsigned long long __bits = __hash_mix(__h);
+    for(int __i = 0; __i != _S_probes; ++__i, __bits >>= 9) {
+      if((__block[(__bits >> 6) & 7] & (1ULL << (__bits & 63))) == 0) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+
+private:
+  const unsigned long long* _M_block(unsigned long long __h) const {
+    return &_M_words[0] + (size_type) (__h % (_M_words.size() / _S_block_words)) * _S_block_words;
+  }
+
+  void _M_insert(unsigned long long __h) {
+    unsigned long long* __block = const_cast<unsigned long long*>(_M_block(__h));
+    unsigned long long __bits = __hash_mix(__h);
+    for(int __i = 0; __i != _S_probes; ++__i, __bits >>= 9) {
+      __block[(__bits >> 6) & 7] |= 1ULL << (__bits & 63);
+    }
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_BLOOM_FILTER_H */
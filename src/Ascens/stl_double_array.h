@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A double-array trie of the keys of one of the trie containers, for exact
+ * lookups only.
+ *
+ * J. Aoe, "An Efficient Digital Search Algorithm by Using a Double-Array
+ * Structure", IEEE Transactions on Software Engineering, Vol. 15, No. 9,
+ * September 1989.
+ *
+ * A state is an index into two arrays. The state reached from s by the
+ * character with code c is t = base[s] + c, and it is a child of s only if
+ * check[t] == s, so every character costs two array reads whatever the
+ * number of siblings. Codes come from the alphabet of the keys (see
+ * stl_trie_alphabet.h), plus one; code 0 marks the end of a key and the
+ * base of the state it reaches holds the number of values with that key.
+ *
+ * The double array is read only and keeps nothing of the trie it was built
+ * from, so it must be built again (assign) after that trie changes.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_DOUBLE_ARRAY_H
+#define __INTERNAL_DOUBLE_ARRAY_H
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <stl_trie_alphabet.h>
+#include <stl_radix_trie.h> // for the units
+
+namespace trie {
+
+template <class _Trie,
+          class _Units = __identity_units<typename _Trie::sub_key_type, typename _Trie::key_compare> >
+class double_array {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::size_type       size_type;
+  typedef typename _Units::unit_type      unit_type;
+  typedef typename _Units::unit_compare   unit_compare;
+  typedef alphabet<unit_type, unsigned int, unit_compare> alphabet_type;
+
+private:
+  enum { _S_free = -1, _S_root_check = -2 };
+
+  // collects the keys of the trie as units, in the order of its iterators
+  class _KeyCollector {
+  public:
+    _KeyCollector(std::vector<unit_type>& __rgUnits, std::vector<size_type>& __rgEnds)
+      : _M_units(&__rgUnits), _M_ends(&__rgEnds) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref) {
+      for(; __first != __last; ++__first) {
+        _Units::to_units(*__first, std::back_inserter(*_M_units));
+      }
+      _M_ends->push_back(_M_units->size());
+    }
+  private:
+    std::vector<unit_type>* _M_units;
+    std::vector<size_type>* _M_ends;
+  };
+
+  // keys [_M_lo, _M_hi) all begin with the same _M_depth units and lead to
+  // _M_state
+  struct _BuildFrame {
+    int       _M_state;
+    size_type _M_lo;
+    size_type _M_hi;
+    size_type _M_depth;
+  };
+
+  std::vector<int> _M_base;
+  std::vector<int> _M_check;
+  size_type        _M_size;
+  alphabet_type    _M_alphabet;
+
+public:
+  // allocation/deallocation
+
+  double_array() : _M_size(0) {}
+
+  explicit double_array(const _Trie& __t) : _M_size(0) { assign(__t); }
+
+  // builds the double array from the keys of __t
+  void assign(const _Trie& __t) {
+    std::vector<unit_type> __rgUnits;
+    std::vector<size_type> __rgEnds;
+
+    clear();
+    __t.for_each(_KeyCollector(__rgUnits, __rgEnds));
+    _M_size = __rgEnds.size();
+    _M_alphabet.assign(__rgUnits.begin(), __rgUnits.end());
+
+    std::vector<unsigned int> __rgCodes(__rgUnits.size());
+    _M_alphabet.encode(__rgUnits.begin(), __rgUnits.end(), __rgCodes.begin());
+    for(std::vector<unsigned int>::iterator __it = __rgCodes.begin(); __it != __rgCodes.end(); ++__it) {
+      ++*__it; // 0 ends a key
+    }
+
+    _M_base.assign(1, 0);
+    _M_check.assign(1, _S_root_check);
+    _M_build(__rgCodes, __rgEnds);
+
+    // no state goes past the end of the arrays, even by an unknown code
+    const size_type __cStates = _M_check.size() + _M_alphabet.size() + 2;
+    _M_base.resize(__cStates, 0);
+    _M_check.resize(__cStates, _S_free);
+  }
+
+  void clear() {
+    _M_base.clear();
+    _M_check.clear();
+    _M_size = 0;
+    _M_alphabet.clear();
+  }
+
+  bool empty() const { return _M_size == 0; }
+  size_type size() const { return _M_size; }
+
+  // the length of the two arrays, and how many of the states are used
+  size_type state_count() const { return _M_check.size(); }
+  size_type used_state_count() const {
+    return _M_check.size() - std::count(_M_check.begin(), _M_check.end(), int(_S_free));
+  }
+
+  // set operations:
+  //
+  // A key is given either as a key_type, when the units are the characters
+  // themselves, or as a range of units.
+
+  // the number of values with the key __x
+  size_type count(const key_type& __x) const {
+    return count(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  size_type count(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    if(_M_check.empty()) {
+      return 0;
+    }
+    int __s = 0;
+    for(; __itKey != __itKeyEnd; ++__itKey) {
+      const int __t = _M_base[__s] + (int) _M_alphabet.encode(*__itKey) + 1;
+      if(_M_check[__t] != __s) {
+        return 0;
+      }
+      __s = __t;
+    }
+    const int __t = _M_base[__s];
+    return (_M_check[__t] == __s) ? (size_type) _M_base[__t] : 0;
+  }
+
+private:
+  void _M_reserve(size_type __n) {
+    if(_M_check.size() < __n) {
+      _M_base.resize(__n, 0);
+      _M_check.resize(__n, _S_free);
+    }
+  }
+
+  // the lowest base at which every code in __rgCodes lands on a free state.
+  // __iFree is the first state that may be free.
+  int _M_find_base(const std::vector<unsigned int>& __rgCodes, size_type& __iFree) {
+    while(__iFree < _M_check.size() && _M_check[__iFree] != _S_free) {
+      ++__iFree;
+    }
+    for(size_type __i = std::max<size_type>(__iFree, __rgCodes.front() + 1);; ++__i) {
+      _M_reserve(__i + 1);
+      if(_M_check[__i] != _S_free) {
+        continue;
+      }
+      const size_type __base = __i - __rgCodes.front();
+      _M_reserve(__base + __rgCodes.back() + 1);
+      bool __fFits = true;
+      for(std::vector<unsigned int>::const_iterator __it = __rgCodes.begin() + 1; __it != __rgCodes.end() && __fFits; ++__it) {
+        __fFits = (_M_check[__base + *__it] == _S_free);
+      }
+      if(__fFits) {
+        return (int) __base;
+      }
+    }
+  }
+
+  // the children of a state are placed together, then each of them is
+  // filled in, depth first
+  void _M_build(const std::vector<unsigned int>& __rgCodes, const std::vector<size_type>& __rgEnds) {
+    size_type __iFree = 1;
+    std::vector<_BuildFrame> __stack;
+    _BuildFrame __root = { 0, 0, __rgEnds.size(), 0 };
+    __stack.push_back(__root);
+
+    std::vector<unsigned int> __rgChildCodes;
+    std::vector<_BuildFrame>  __rgChildren;
+    while(!__stack.empty()) {
+      const _BuildFrame __frame = __stack.back();
+      __stack.pop_back();
+
+      __rgChildCodes.clear();
+      __rgChildren.clear();
+
+      // keys which end here go to the state of code 0
+      size_type __lo = __frame._M_lo;
+      while(__lo != __frame._M_hi && _S_length(__rgEnds, __lo) == __frame._M_depth) {
+        ++__lo;
+      }
+      const size_type __cValues = __lo - __frame._M_lo;
+      if(__cValues != 0) {
+        __rgChildCodes.push_back(0);
+      }
+
+      // the rest are grouped by their next unit
+      while(__lo != __frame._M_hi) {
+        const unsigned int __c = __rgCodes[_S_begin(__rgEnds, __lo) + __frame._M_depth];
+        size_type __hi = __lo + 1;
+        while(__hi != __frame._M_hi && __c == __rgCodes[_S_begin(__rgEnds, __hi) + __frame._M_depth]) {
+          ++__hi;
+        }
+        __rgChildCodes.push_back(__c);
+        _BuildFrame __child = { 0, __lo, __hi, __frame._M_depth + 1 };
+        __rgChildren.push_back(__child);
+        __lo = __hi;
+      }
+      if(__rgChildCodes.empty()) {
+        continue; // the empty trie
+      }
+
+      const int __base = _M_find_base(__rgChildCodes, __iFree);
+      _M_base[__frame._M_state] = __base;
+      for(std::vector<unsigned int>::const_iterator __it = __rgChildCodes.begin(); __it != __rgChildCodes.end(); ++__it) {
+        _M_check[__base + *__it] = __frame._M_state;
+      }
+      if(__cValues != 0) {
+        _M_base[__base] = (int) __cValues;
+      }
+      for(typename std::vector<_BuildFrame>::reverse_iterator __it = __rgChildren.rbegin(); __it != __rgChildren.rend(); ++__it) {
+        __it->_M_state = __base + (int) __rgCodes[_S_begin(__rgEnds, __it->_M_lo) + __frame._M_depth];
+        __stack.push_back(*__it);
+      }
+    }
+  }
+
+  static size_type _S_begin(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return (__i == 0) ? 0 : __rgEnds[__i - 1];
+  }
+
+  static size_type _S_length(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return __rgEnds[__i] - _S_begin(__rgEnds, __i);
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_DOUBLE_ARRAY_H */
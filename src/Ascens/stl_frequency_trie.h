@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A trie of the keys of one of the trie containers whose siblings are kept
+ * in the order of how often they are reached, for exact lookups.
+ *
+ * The trie containers keep the children of a node in key order, so that
+ * they iterate in order, and a lookup reads them one after the other until
+ * it meets its character. For the words of a language that is about the
+ * worst order there is: 'e', 's' and 't' sit in the middle of the list and
+ * are passed over by every lookup which goes on to them. Here the children
+ * of a node are next to each other in one array, heaviest first, so the
+ * characters most lookups want are the first ones read.
+ *
+ * A key weighs one, plus the weight of its value (see __value_weight; for a
+ * map of words to their frequencies in a corpus, the frequency), and a node
+ * weighs what the keys below it do. record() looks a key up and adds one to
+ * every node on its path, and reorder() sorts the children again by these
+ * weights, so the order can follow the lookups actually made.
+ *
+ * for_each visits the keys in key order, sorting the children of each node
+ * as it comes to them; the container it was built from iterates in order
+ * too.
+ *
+ * The frequency trie is read only and keeps nothing of the trie it was
+ * built from, so it must be built again (assign) after that trie changes.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_FREQUENCY_TRIE_H
+#define __INTERNAL_FREQUENCY_TRIE_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stl_trie.h> // for __value_weight
+
+namespace trie {
+
+template <class _Trie>
+class frequency_trie {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::value_type      value_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_compare     key_compare;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::size_type       size_type;
+
+private:
+  struct _Node {
+    sub_key_type _M_key;
+    unsigned int _M_values;    // the number of values whose key ends here
+    unsigned int _M_first;     // the children are [_M_first, _M_first + _M_children)
+    unsigned int _M_children;
+    size_type    _M_weight;    // of the keys below, and the lookups recorded through it
+  };
+
+  struct _HeavierNode : public std::binary_function<_Node, _Node, bool> {
+    bool operator()(const _Node& __a, const _Node& __b) const {
+      return __a._M_weight > __b._M_weight;
+    }
+  };
+
+  // orders child indices by the weights of their nodes, heaviest first
+  class _HeavierIndex : public std::binary_function<size_type, size_type, bool> {
+  public:
+    _HeavierIndex(const std::vector<_Node>& __rgNodes) : _M_nodes(&__rgNodes) {}
+
+    bool operator()(size_type __a, size_type __b) const {
+      return (*_M_nodes)[__a]._M_weight > (*_M_nodes)[__b]._M_weight;
+    }
+  private:
+    const std::vector<_Node>* _M_nodes;
+  };
+
+  // orders node indices by the keys of their nodes, greatest first
+  class _GreaterKey : public std::binary_function<unsigned int, unsigned int, bool> {
+  public:
+    _GreaterKey(const std::vector<_Node>& __rgNodes, const key_compare& __comp)
+      : _M_nodes(&__rgNodes), _M_compare(__comp) {}
+
+    bool operator()(unsigned int __a, unsigned int __b) const {
+      return _M_compare((*_M_nodes)[__b]._M_key, (*_M_nodes)[__a]._M_key);
+    }
+  private:
+    const std::vector<_Node>* _M_nodes;
+    key_compare               _M_compare;
+  };
+
+  // collects the keys of the trie, in order, with their weights
+  class _KeyCollector {
+  public:
+    _KeyCollector(std::vector<sub_key_type>& __rgKeys, std::vector<size_type>& __rgEnds,
+                  std::vector<size_type>& __rgWeights)
+      : _M_keys(&__rgKeys), _M_ends(&__rgEnds), _M_weights(&__rgWeights) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref __v) {
+      _M_keys->insert(_M_keys->end(), __first, __last);
+      _M_ends->push_back(_M_keys->size());
+      _M_weights->push_back(1 + __value_weight<value_type>()(__v));
+    }
+  private:
+    std::vector<sub_key_type>* _M_keys;
+    std::vector<size_type>*    _M_ends;
+    std::vector<size_type>*    _M_weights;
+  };
+
+  // keys [_M_lo, _M_hi) all begin with the same _M_depth sub keys and lead
+  // to _M_node
+  struct _BuildFrame {
+    unsigned int _M_node;
+    size_type    _M_lo;
+    size_type    _M_hi;
+    size_type    _M_depth;
+  };
+
+  std::vector<_Node> _M_nodes;   // the root first
+  size_type          _M_size;
+  key_compare        _M_key_compare;
+
+public:
+  // allocation/deallocation
+
+  frequency_trie() : _M_size(0) {}
+
+  explicit frequency_trie(const _Trie& __t) : _M_size(0) { assign(__t); }
+
+  // builds the frequency trie from the keys of __t, with the siblings in
+  // the order of the weights of their keys
+  void assign(const _Trie& __t) {
+    std::vector<sub_key_type> __rgKeys;
+    std::vector<size_type> __rgEnds;
+    std::vector<size_type> __rgWeights;
+
+    clear();
+    _M_key_compare = __t.key_comp();
+    __t.for_each(_KeyCollector(__rgKeys, __rgEnds, __rgWeights));
+    _M_build(__rgKeys, __rgEnds, __rgWeights);
+  }
+
+  void clear() {
+    _M_nodes.clear();
+    _M_size = 0;
+  }
+
+  // the number of distinct keys
+  bool empty() const { return _M_size == 0; }
+  size_type size() const { return _M_size; }
+
+  size_type node_count() const { return _M_nodes.size(); }
+  size_type memory_size() const { return _M_nodes.size() * sizeof(_Node); }
+
+  // set operations:
+
+  // the number of values with the key __x
+  size_type count(const key_type& __x) const {
+    return count(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  size_type count(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    const _Node* __x = _M_find(__itKey, __itKeyEnd);
+    return (__x == 0) ? 0 : __x->_M_values;
+  }
+
+  // count, adding one to the weight of each node the lookup goes through
+  size_type record(const key_type& __x) {
+    return record(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  size_type record(_InputIterator __itKey, const _InputIterator& __itKeyEnd) {
+    if(_M_nodes.empty()) {
+      return 0;
+    }
+    _Node* __x = &_M_nodes[0];
+    for(; __itKey != __itKeyEnd; ++__itKey) {
+      __x = _M_child(__x, *__itKey);
+      if(__x == 0) {
+        return 0;
+      }
+      ++__x->_M_weight;
+    }
+    return __x->_M_values;
+  }
+
+  // puts the children of every node back in the order of their weights
+  void reorder() {
+    for(typename std::vector<_Node>::iterator __it = _M_nodes.begin(); __it != _M_nodes.end(); ++__it) {
+      std::stable_sort(_M_nodes.begin() + __it->_M_first,
+                       _M_nodes.begin() + __it->_M_first + __it->_M_children, _HeavierNode());
+    }
+  }
+
+  // traversal
+
+  // calls __f(__first, __last, __n) for every key in key order, where
+  // [__first, __last) are its sub keys and __n the number of its values
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const {
+    std::vector<sub_key_type> __path;
+    std::vector<std::pair<unsigned int, size_type> > __stack; // a node and its depth
+    std::vector<unsigned int> __rgChildren;
+
+    if(!_M_nodes.empty()) {
+      __stack.push_back(std::make_pair(0u, size_type(0)));
+    }
+    while(!__stack.empty()) {
+      const _Node& __x = _M_nodes[__stack.back().first];
+      const size_type __depth = __stack.back().second;
+      __stack.pop_back();
+      if(__depth != 0) {
+        __path.resize(__depth - 1);
+        __path.push_back(__x._M_key);
+      }
+      if(__x._M_values != 0) {
+        const sub_key_type* __first = __path.empty() ? 0 : &__path[0];
+        __f(__first, __first + __path.size(), size_type(__x._M_values));
+      }
+
+      // the least key is pushed last, so it is the next one visited
+      __rgChildren.clear();
+      for(unsigned int __i = __x._M_first; __i != __x._M_first + __x._M_children; ++__i) {
+        __rgChildren.push_back(__i);
+      }
+      std::sort(__rgChildren.begin(), __rgChildren.end(), _GreaterKey(_M_nodes, _M_key_compare));
+      for(std::vector<unsigned int>::const_iterator __it = __rgChildren.begin(); __it != __rgChildren.end(); ++__it) {
+        __stack.push_back(std::make_pair(*__it, __depth + 1));
+      }
+    }
+    return __f;
+  }
+
+private:
+  template <class _InputIterator>
+  const _Node* _M_find(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    if(_M_nodes.empty()) {
+      return 0;
+    }
+    const _Node* __x = &_M_nodes[0];
+    for(; __itKey != __itKeyEnd && __x != 0; ++__itKey) {
+      __x = _M_child(__x, *__itKey);
+    }
+    return __x;
+  }
+
+  // the child of __x with the sub key __k, or 0; the children are read in
+  // the order of their weights, so there is no stopping early on a miss
+  const _Node* _M_child(const _Node* __x, const sub_key_type& __k) const {
+    const _Node* __c = &_M_nodes[0] + __x->_M_first;
+    const _Node* const __cEnd = __c + __x->_M_children;
+    for(; __c != __cEnd; ++__c) {
+      if(!_M_key_compare(__c->_M_key, __k) && !_M_key_compare(__k, __c->_M_key)) {
+        return __c;
+      }
+    }
+    return 0;
+  }
+  _Node* _M_child(_Node* __x, const sub_key_type& __k) {
+    return const_cast<_Node*>(static_cast<const frequency_trie*>(this)->_M_child(__x, __k));
+  }
+
+  void _M_build(const std::vector<sub_key_type>& __rgKeys, const std::vector<size_type>& __rgEnds,
+                const std::vector<size_type>& __rgWeights) {
+    _Node __root = _Node();
+    _M_nodes.push_back(__root);
+    if(__rgEnds.empty()) {
+      return;
+    }
+
+    std::vector<_BuildFrame> __stack;
+    _BuildFrame __top = { 0, 0, __rgEnds.size(), 0 };
+    __stack.push_back(__top);
+    while(!__stack.empty()) {
+      const _BuildFrame __f = __stack.back();
+      __stack.pop_back();
+
+      // the keys which end here come first; the multi containers give a
+      // key once for each of its values
+      size_type __i = __f._M_lo;
+      for(; __i != __f._M_hi && _S_length(__rgEnds, __i) == __f._M_depth; ++__i) {
+        ++_M_nodes[__f._M_node]._M_values;
+      }
+      if(__i != __f._M_lo) {
+        ++_M_size;
+      }
+
+      // each run of keys with the same next sub key is a child
+      std::vector<_BuildFrame> __rgChildFrames;
+      std::vector<_Node> __rgChildren;
+      while(__i != __f._M_hi) {
+        const sub_key_type& __k = __rgKeys[_S_begin(__rgEnds, __i) + __f._M_depth];
+        _BuildFrame __child = { 0, __i, __i, __f._M_depth + 1 };
+        _Node __node = _Node();
+        __node._M_key = __k;
+        for(; __child._M_hi != __f._M_hi; ++__child._M_hi) {
+          const sub_key_type& __kT = __rgKeys[_S_begin(__rgEnds, __child._M_hi) + __f._M_depth];
+          if(_M_key_compare(__k, __kT) || _M_key_compare(__kT, __k)) {
+            break;
+          }
+          __node._M_weight += __rgWeights[__child._M_hi];
+        }
+        __rgChildFrames.push_back(__child);
+        __rgChildren.push_back(__node);
+        __i = __child._M_hi;
+      }
+
+      // heaviest first; the frames are sorted along with the nodes
+      std::vector<size_type> __rgOrder(__rgChildren.size());
+      for(size_type __c = 0; __c != __rgOrder.size(); ++__c) {
+        __rgOrder[__c] = __c;
+      }
+      std::stable_sort(__rgOrder.begin(), __rgOrder.end(), _HeavierIndex(__rgChildren));
+
+      _M_nodes[__f._M_node]._M_first = (unsigned int) _M_nodes.size();
+      _M_nodes[__f._M_node]._M_children = (unsigned int) __rgChildren.size();
+      for(size_type __c = 0; __c != __rgOrder.size(); ++__c) {
+        __rgChildFrames[__rgOrder[__c]]._M_node = (unsigned int) _M_nodes.size();
+        _M_nodes.push_back(__rgChildren[__rgOrder[__c]]);
+      }
+      // so the children of the heaviest are laid out next
+      for(size_type __c = __rgOrder.size(); __c != 0; --__c) {
+        __stack.push_back(__rgChildFrames[__rgOrder[__c - 1]]);
+      }
+    }
+  }
+
+  static size_type _S_begin(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return (__i == 0) ? 0 : __rgEnds[__i - 1];
+  }
+  static size_type _S_length(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return __rgEnds[__i] - _S_begin(__rgEnds, __i);
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_FREQUENCY_TRIE_H */
@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A succinct trie built from one of the trie containers, with the tree
+ * structure kept apart from the content.
+ *
+ * G. Jacobson, "Space-efficient Static Trees and Graphs", 30th Annual
+ * Symposium on Foundations of Computer Science, 1989.
+ *
+ * The nodes are numbered in level order (breadth first, children in key
+ * order) and the shape of the tree is a level-order unary degree sequence:
+ * after a leading "10" for a super root above the root, each node in turn
+ * adds a 1 for each of its children and then a 0. Node v's children are
+ * found from the v'th 0 and the number of 1s before it, so the structure
+ * costs two bits a node plus the small tables of __rank_select_bits. Each
+ * node but the root has a label, the code of its unit (see
+ * stl_trie_alphabet.h), and the children of a node are numbered together so
+ * their labels can be searched as an array. A third bit a node marks the
+ * ends of keys; its rank numbers the keys, which index the values.
+ *
+ * find, find_if_prefix, find_prefixes and the approximate searches work on
+ * the encoding as it is and take and return what those of radix_trie do, so
+ * either of them can index a container; the radix trie is the faster, this
+ * is the smaller. Only the structure is succinct, though: like the radix
+ * trie it keeps an iterator and the start of the values for each key, and
+ * it is an index besides the container rather than a replacement for it.
+ *
+ * The LOUDS trie is read only: it refers to the values of the trie it was
+ * built from through their iterators, so it must be built again (assign)
+ * after that trie changes. Its searches give back that trie's iterators,
+ * not keys and values of its own, so it cannot replace the trie as the
+ * store of a read only dictionary, and a dictionary file cannot be loaded
+ * straight into it; a succinct container would have to own both.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_LOUDS_TRIE_H
+#define __INTERNAL_LOUDS_TRIE_H
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stl_trie_alphabet.h>
+#include <stl_rank_select.h>
+#include <stl_radix_trie.h> // for the units
+
+namespace trie {
+
+template <class _Trie,
+          class _Code = typename _Trie::sub_key_type,
+          class _Units = __identity_units<typename _Trie::sub_key_type, typename _Trie::key_compare> >
+class louds_trie {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::value_type      value_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::const_iterator  const_iterator;
+  typedef typename _Trie::size_type       size_type;
+  typedef typename _Units::unit_type      unit_type;
+  typedef typename _Units::unit_compare   unit_compare;
+  typedef _Code                           code_type;
+  typedef alphabet<unit_type, _Code, unit_compare> alphabet_type;
+
+private:
+  // collects the keys of the trie as units, in the order of its iterators
+  class _KeyCollector {
+  public:
+    _KeyCollector(std::vector<unit_type>& __rgUnits, std::vector<size_type>& __rgEnds)
+      : _M_units(&__rgUnits), _M_ends(&__rgEnds) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref) {
+      for(; __first != __last; ++__first) {
+        _Units::to_units(*__first, std::back_inserter(*_M_units));
+      }
+      _M_ends->push_back(_M_units->size());
+    }
+  private:
+    std::vector<unit_type>* _M_units;
+    std::vector<size_type>* _M_ends;
+  };
+
+  // keys [_M_lo, _M_hi) all begin with the same _M_depth units
+  struct _BuildFrame {
+    size_type _M_lo;
+    size_type _M_hi;
+    size_type _M_depth;
+  };
+
+  // _M_node and the rows of the edit distance table up to _M_depth. The
+  // character being read when the node was reached still wants _M_pending
+  // units; _M_partial holds those read so far.
+  struct _MatchFrame {
+    size_type          _M_node;
+    size_type          _M_depth;
+    unsigned int       _M_pending;
+    unsigned long long _M_partial;
+  };
+
+  // a value found by approximate matching, by its index in _M_values
+  typedef __weighted_candidate<size_type> _candidate;
+
+  __rank_select_bits          _M_louds;        // the shape of the tree
+  __rank_select_bits          _M_terminal;     // a bit a node, set where a key ends
+  std::vector<_Code>          _M_labels;       // a label a node; the root's is not used
+  std::vector<unsigned int>   _M_value_starts; // the first value of each key, and the end
+  std::vector<const_iterator> _M_values;       // by key, in level order
+  const_iterator              _M_end;
+  alphabet_type               _M_alphabet;
+
+public:
+  // allocation/deallocation
+
+  louds_trie() {}
+
+  explicit louds_trie(const _Trie& __t) { assign(__t); }
+
+  // builds the LOUDS trie from the keys of __t. If _Code cannot number
+  // their characters this throws std::length_error and leaves it empty.
+  void assign(const _Trie& __t) {
+    std::vector<unit_type> __rgUnits;
+    std::vector<size_type> __rgEnds;
+
+    clear();
+    _M_end = __t.end();
+
+    __t.for_each(_KeyCollector(__rgUnits, __rgEnds));
+    _M_alphabet.assign(__rgUnits.begin(), __rgUnits.end());
+    std::vector<_Code> __rgCodes(__rgUnits.size());
+    _M_alphabet.encode(__rgUnits.begin(), __rgUnits.end(), __rgCodes.begin());
+    std::vector<unit_type>().swap(__rgUnits);
+
+    std::vector<const_iterator> __rgValues;
+    __rgValues.reserve(__rgEnds.size());
+    for(const_iterator __it = __t.begin(); __it != __t.end(); ++__it) {
+      __rgValues.push_back(__it);
+    }
+    assert(__rgValues.size() == __rgEnds.size());
+
+    _M_build(__rgCodes, __rgEnds, __rgValues);
+  }
+
+  void clear() {
+    _M_louds.clear();
+    _M_terminal.clear();
+    _M_labels.clear();
+    _M_value_starts.clear();
+    _M_values.clear();
+    _M_alphabet.clear();
+  }
+
+  bool empty() const { return _M_values.empty(); }
+  size_type size() const { return _M_values.size(); }
+  size_type node_count() const { return _M_labels.size(); }
+  const alphabet_type& get_alphabet() const { return _M_alphabet; }
+
+  // the bytes taken by the tree structure and the labels, without the values
+  size_type structure_size() const {
+    return _M_louds.memory_size() + _M_terminal.memory_size() + _M_labels.size() * sizeof(_Code);
+  }
+
+  // the end of the trie it was built from
+  const_iterator end() const { return _M_end; }
+
+  // set operations:
+  //
+  // A key is given either as a key_type, when the units are the characters
+  // themselves, or as a range of units.
+
+  const_iterator find(const key_type& __x) const {
+    return find(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  const_iterator find(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    if(_M_labels.empty()) {
+      return _M_end;
+    }
+    size_type __v = 0;
+    for(; __itKey != __itKeyEnd; ++__itKey) {
+      if(!_M_child(__v, _M_alphabet.encode(*__itKey), __v)) {
+        return _M_end;
+      }
+    }
+    return _M_terminal[__v] ? _M_first_value(__v) : _M_end;
+  }
+
+  // the longest key in the trie that is a prefix of __x (or __x itself)
+  const_iterator find_if_prefix(const key_type& __x) const {
+    return find_if_prefix(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  const_iterator find_if_prefix(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    const_iterator __j = _M_end;
+    if(_M_labels.empty()) {
+      return __j;
+    }
+    size_type __v = 0;
+    for(; __itKey != __itKeyEnd; ++__itKey) {
+      if(!_M_child(__v, _M_alphabet.encode(*__itKey), __v)) {
+        return __j;
+      }
+      if(_M_terminal[__v]) {
+        __j = _M_first_value(__v);
+      }
+    }
+    return __j;
+  }
+
+  // the keys in the trie that are prefixes of __x (or __x itself), shortest
+  // first. The empty key is not one of them.
+  std::vector<const_iterator> find_prefixes(const key_type& __x) const {
+    return find_prefixes(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> find_prefixes(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    std::vector<const_iterator> __rgIt;
+    if(_M_labels.empty()) {
+      return __rgIt;
+    }
+    size_type __v = 0;
+    for(; __itKey != __itKeyEnd; ++__itKey) {
+      if(!_M_child(__v, _M_alphabet.encode(*__itKey), __v)) {
+        return __rgIt;
+      }
+      if(_M_terminal[__v]) {
+        __rgIt.push_back(_M_first_value(__v));
+      }
+    }
+    return __rgIt;
+  }
+
+  // approximate string matching
+  //
+  // Edits are insertions, deletions, replacements and transpositions of
+  // characters. One row of the edit distance table is added for each
+  // character read and a subtrie is cut off once no entry in the row is
+  // within the cutoff. The empty key is never found.
+
+  // the values within __k edits of __x, in the order of the trie
+  std::vector<const_iterator> approximate_find(const key_type& __x, unsigned int __k = 1) const {
+    return approximate_find(key_begin()(__x), key_end()(__x), __k);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> approximate_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = 1) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), false, __k, __rgFound);
+    return _M_found_values(__rgFound);
+  }
+
+  // the values closest to __x, if they are within __k edits
+  std::vector<const_iterator> best_find(const key_type& __x, unsigned int __k = TRIE_INFINITY) const {
+    return best_find(key_begin()(__x), key_end()(__x), __k);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> best_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = TRIE_INFINITY) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), true, __k, __rgFound);
+    return _M_found_values(__rgFound);
+  }
+
+  // the __n best values within __k edits, ordered by distance and then by
+  // weight (heaviest first). __n == 0 returns every value within __k edits.
+  std::vector<const_iterator> weighted_find(const key_type& __x, unsigned int __k = 1, size_type __n = 0) const {
+    return weighted_find(key_begin()(__x), key_end()(__x), __k, __n);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> weighted_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = 1, size_type __n = 0) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), false, __k, __rgFound);
+    std::sort(__rgFound.begin(), __rgFound.end());
+    if(__n != 0 && __rgFound.size() > __n) {
+      __rgFound.resize(__n);
+    }
+    return _M_found_values(__rgFound);
+  }
+
+private:
+  // the children of node __v are the nodes [__iFirst, __iFirst + __cChildren)
+  void _M_children(size_type __v, size_type& __iFirst, size_type& __cChildren) const {
+    const size_type __p = _M_louds.select0(__v) + 1;
+    __iFirst = _M_louds.rank1(__p);
+    __cChildren = _M_louds.select0(__v + 1) - __p;
+  }
+
+  // the child of __v labelled __c, if there is one
+  bool _M_child(size_type __v, _Code __c, size_type& __child) const {
+    size_type __first, __count;
+    _M_children(__v, __first, __count);
+    const _Code* __begin = &_M_labels[0] + __first;
+    const _Code* __it = std::lower_bound(__begin, __begin + __count, __c);
+    if(__it == __begin + __count || *__it != __c) {
+      return false;
+    }
+    __child = __it - &_M_labels[0];
+    return true;
+  }
+
+  // the values of the key ending at __v, a node whose terminal bit is set
+  size_type _M_value_index(size_type __v) const {
+    return _M_value_starts[_M_terminal.rank1(__v)];
+  }
+
+  const_iterator _M_first_value(size_type __v) const {
+    return _M_values[_M_value_index(__v)];
+  }
+
+  // the nodes are made a level at a time, in key order within each level
+  void _M_build(const std::vector<_Code>& __rgSubKeys, const std::vector<size_type>& __rgEnds,
+                const std::vector<const_iterator>& __rgValues) {
+    _M_louds.push_back(true); // the super root
+    _M_louds.push_back(false);
+
+    std::deque<_BuildFrame> __queue;
+    _BuildFrame __root = { 0, __rgEnds.size(), 0 };
+    __queue.push_back(__root);
+    _M_labels.push_back(_Code());
+
+    while(!__queue.empty()) {
+      const _BuildFrame __frame = __queue.front();
+      __queue.pop_front();
+
+      // keys which end here have their values here
+      size_type __lo = __frame._M_lo;
+      while(__lo != __frame._M_hi && _S_length(__rgEnds, __lo) == __frame._M_depth) {
+        ++__lo;
+      }
+      _M_terminal.push_back(__lo != __frame._M_lo);
+      if(__lo != __frame._M_lo) {
+        _M_value_starts.push_back((unsigned int) _M_values.size());
+        _M_values.insert(_M_values.end(), __rgValues.begin() + __frame._M_lo, __rgValues.begin() + __lo);
+      }
+
+      // the rest are grouped by their next unit
+      while(__lo != __frame._M_hi) {
+        const _Code __c = __rgSubKeys[_S_begin(__rgEnds, __lo) + __frame._M_depth];
+        size_type __hi = __lo + 1;
+        while(__hi != __frame._M_hi && __c == __rgSubKeys[_S_begin(__rgEnds, __hi) + __frame._M_depth]) {
+          ++__hi;
+        }
+        _BuildFrame __child = { __lo, __hi, __frame._M_depth + 1 };
+        __queue.push_back(__child);
+        _M_labels.push_back(__c);
+        _M_louds.push_back(true);
+        __lo = __hi;
+      }
+      _M_louds.push_back(false);
+    }
+    _M_value_starts.push_back((unsigned int) _M_values.size());
+
+    _M_louds.freeze();
+    _M_terminal.freeze();
+  }
+
+  static size_type _S_begin(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return (__i == 0) ? 0 : __rgEnds[__i - 1];
+  }
+
+  static size_type _S_length(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return __rgEnds[__i] - _S_begin(__rgEnds, __i);
+  }
+
+  // a character is the codes of its units, one digit each, so that
+  // characters of different lengths differ too
+  static unsigned long long _S_add_unit(unsigned long long __c, _Code __code) {
+    return __c * ((unsigned long long) _Code(-1) + 2) + __code + 1;
+  }
+
+  template <class _InputIterator>
+  std::vector<unsigned long long> _M_characters(_InputIterator __itKey, _InputIterator __itKeyEnd) const {
+    std::vector<unsigned long long> __rgChars;
+    while(__itKey != __itKeyEnd) {
+      unsigned long long __c = 0;
+      for(unsigned int __cUnits = _Units::length(*__itKey); __cUnits != 0 && __itKey != __itKeyEnd; --__cUnits, ++__itKey) {
+        __c = _S_add_unit(__c, _M_alphabet.encode(*__itKey));
+      }
+      __rgChars.push_back(__c);
+    }
+    return __rgChars;
+  }
+
+  std::vector<const_iterator> _M_found_values(const std::vector<_candidate>& __rgFound) const {
+    std::vector<const_iterator> __rgIt;
+    __rgIt.reserve(__rgFound.size());
+    for(typename std::vector<_candidate>::const_iterator __it = __rgFound.begin(); __it != __rgFound.end(); ++__it) {
+      __rgIt.push_back(_M_values[__it->_M_node]);
+    }
+    return __rgIt;
+  }
+
+  // every value within __k edits of __rgKey, in the order of the trie. With
+  // __fBestCase only the closest are kept and the cutoff drops to their
+  // distance as they are found. The walk is depth first, so the values are
+  // found in key order although they are stored in level order.
+  void _M_approximate_match(const std::vector<unsigned long long>& __rgKey, bool __fBestCase, unsigned int __k,
+                            std::vector<_candidate>& __rgFound) const {
+    if(_M_labels.empty()) {
+      return;
+    }
+
+    const size_type __m = __rgKey.size();
+    std::vector<unsigned long long> __W;    // the characters down to the node
+    std::vector<unsigned int> __DT(__m + 1); // row __i is at __i*(__m+1)
+    for(size_type __j = 0; __j <= __m; ++__j) {
+      __DT[__j] = (unsigned int) __j;
+    }
+    __value_weight<value_type> __weight;
+    size_type __cFound = 0; // the order of the values found
+
+    std::vector<_MatchFrame> __stack;
+    _MatchFrame __root = { 0, 0, 0, 0 };
+    __stack.push_back(__root);
+    while(!__stack.empty()) {
+      _MatchFrame __frame = __stack.back();
+      __stack.pop_back();
+
+      size_type __i = __frame._M_depth;
+      __W.resize(__i);
+      __DT.resize((__i + 1) * (__m + 1));
+      if(__frame._M_node != 0) {
+        const _Code __c = _M_labels[__frame._M_node];
+        if(__frame._M_pending == 0) {
+          __frame._M_pending = _Units::length(_M_alphabet.decode(__c));
+          __frame._M_partial = 0;
+        }
+        __frame._M_partial = _S_add_unit(__frame._M_partial, __c);
+        if(--__frame._M_pending == 0) {
+          __W.push_back(__frame._M_partial);
+          ++__i;
+          if(_S_next_row(__rgKey, __W, __DT, __i, __k)) {
+            continue;
+          }
+        }
+      }
+
+      const unsigned int __d = __DT[__i * (__m + 1) + __m];
+      if(_M_terminal[__frame._M_node] && __i != 0 && __frame._M_pending == 0 && __d <= __k) {
+        if(__fBestCase && __d < __k) {
+          __k = __d;
+          __rgFound.clear();
+        }
+        const size_type __t = _M_terminal.rank1(__frame._M_node);
+        for(size_type __v = _M_value_starts[__t]; __v != _M_value_starts[__t + 1]; ++__v) {
+          _candidate __found = { __d, __weight(*_M_values[__v]), __cFound++, __v };
+          __rgFound.push_back(__found);
+        }
+      }
+
+      size_type __first, __count;
+      _M_children(__frame._M_node, __first, __count);
+      for(size_type __c = __count; __c != 0; --__c) {
+        _MatchFrame __child = { __first + __c - 1, __i, __frame._M_pending, __frame._M_partial };
+        __stack.push_back(__child);
+      }
+    }
+  }
+
+  // fills in row __i of the edit distance table between __rgKey and the
+  // first __i characters of __W, true if every entry is over __k
+  static bool _S_next_row(const std::vector<unsigned long long>& __rgKey, const std::vector<unsigned long long>& __W,
+                          std::vector<unsigned int>& __DT, size_type __i, unsigned int __k) {
+    const size_type __m = __rgKey.size();
+    __DT.resize((__i + 1) * (__m + 1));
+    unsigned int* __row = &__DT[__i * (__m + 1)];
+    const unsigned int* __prev = __row - (__m + 1);
+    const unsigned long long __w = __W[__i - 1];
+
+    __row[0] = (unsigned int) __i;
+    unsigned int __min = __row[0];
+    for(size_type __j = 1; __j <= __m; ++__j) {
+      unsigned int __d = std::min(__row[__j - 1] + 1, __prev[__j] + 1);
+      __d = std::min(__d, __prev[__j - 1] + ((__rgKey[__j - 1] == __w) ? 0 : 1));
+      if(__i > 1 && __j > 1 && __rgKey[__j - 2] == __w && __rgKey[__j - 1] == __W[__i - 2]) {
+        __d = std::min(__d, __prev[__j - 2 - (__m + 1)] + 1);
+      }
+      __row[__j] = __d;
+      __min = std::min(__min, __d);
+    }
+    return __min > __k;
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_LOUDS_TRIE_H */
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A minimal perfect hash of the keys of one of the trie containers, with a
+ * fingerprint of each key, for membership tests only.
+ *
+ * A. Limasset, G. Rizk, R. Chikhi and P. Peterlongo, "Fast and Scalable
+ * Minimal Perfect Hashing for Massive Key Sets", 16th International
+ * Symposium on Experimental Algorithms, 2017.
+ *
+ * The keys are hashed into a bit array _S_gamma times as long as their
+ * number; those alone in their position set its bit, those which collide
+ * are hashed again into the array of the next level, and so on. The rank of
+ * a key's bit among the set bits of all the levels is its slot, which holds
+ * a fingerprint taken from a different part of its hash. A key is counted
+ * as present when its bit is set and the fingerprints are equal: one hash
+ * and a comparison, and about 3.7 bits a key plus the fingerprints.
+ *
+ * Nothing of the keys themselves is kept, so a key which is not in the
+ * container is taken to be one when its fingerprint happens to match, with
+ * a chance of one in 2 to the number of bits in _Fingerprint (2^-32 for an
+ * unsigned int).
+ *
+ * The hash is read only and must be built again (assign) after the trie it
+ * was built from changes.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_PERFECT_HASH_H
+#define __INTERNAL_PERFECT_HASH_H
+
+#include <vector>
+#include <algorithm>
+#include <ctime>
+#include <stl_rank_select.h>
+#include <stl_trie_hash.h>
+
+namespace trie {
+
+template <class _Trie, class _Fingerprint = unsigned int>
+class perfect_hash {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::size_type       size_type;
+  typedef _Fingerprint                    fingerprint_type;
+
+  enum { _S_gamma = 2,       // the bits of a level for each key hashed into it
+         _S_max_levels = 32  // keys still colliding after these are kept aside
+  };
+
+private:
+  // collects the hashes of the keys of the trie
+  class _KeyHasher {
+  public:
+    _KeyHasher(std::vector<unsigned long long>& __rgHashes) : _M_hashes(&__rgHashes) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref) {
+      _M_hashes->push_back(__hash_key(__first, __last));
+    }
+  private:
+    std::vector<unsigned long long>* _M_hashes;
+  };
+
+  __rank_select_bits              _M_bits;          // the levels, one after the other
+  std::vector<size_type>          _M_level_offsets; // where each level begins, and the end
+  std::vector<_Fingerprint>       _M_fingerprints;  // by slot
+  std::vector<unsigned long long> _M_fallback;      // the hashes kept aside, sorted
+  double                          _M_build_seconds;
+
+public:
+  // allocation/deallocation
+
+  perfect_hash() : _M_build_seconds(0) {}
+
+  explicit perfect_hash(const _Trie& __t) : _M_build_seconds(0) { assign(__t); }
+
+  // builds the hash from the keys of __t
+  void assign(const _Trie& __t) {
+    const clock_t __start = clock();
+    std::vector<unsigned long long> __rgHashes;
+
+    clear();
+    __t.for_each(_KeyHasher(__rgHashes));
+    // the multi containers give a key once for each of its values
+    std::sort(__rgHashes.begin(), __rgHashes.end());
+    __rgHashes.erase(std::unique(__rgHashes.begin(), __rgHashes.end()), __rgHashes.end());
+
+    _M_build(__rgHashes);
+    _M_build_seconds = double(clock() - __start) / CLOCKS_PER_SEC;
+  }
+
+  void clear() {
+    _M_bits.clear();
+    _M_level_offsets.clear();
+    _M_fingerprints.clear();
+    _M_fallback.clear();
+    _M_build_seconds = 0;
+  }
+
+  // the number of distinct keys
+  size_type size() const { return _M_fingerprints.size() + _M_fallback.size(); }
+  bool empty() const { return size() == 0; }
+
+  size_type level_count() const { return _M_level_offsets.empty() ? 0 : _M_level_offsets.size() - 1; }
+
+  // the bytes taken, and the bits a key; for reporting
+  size_type memory_size() const {
+    return _M_bits.memory_size() + _M_level_offsets.size() * sizeof(size_type) +
+           _M_fingerprints.size() * sizeof(_Fingerprint) + _M_fallback.size() * sizeof(unsigned long long);
+  }
+  double bits_per_key() const { return empty() ? 0 : 8.0 * memory_size() / size(); }
+
+  // the processor time the last assign took, in seconds
+  double build_seconds() const { return _M_build_seconds; }
+
+  // set operations:
+
+  // 1 if the key __x is (very probably) in the trie it was built from
+  size_type count(const key_type& __x) const {
+    return count(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  size_type count(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    const unsigned long long __h = __hash_key(__itKey, __itKeyEnd);
+    for(size_type __l = 0; __l + 1 < _M_level_offsets.size(); ++__l) {
+      const size_type __i = _M_position(__h, __l);
+      if(_M_bits[__i]) {
+        return (_M_fingerprints[_M_bits.rank1(__i)] == _S_fingerprint(__h)) ? 1 : 0;
+      }
+    }
+    return std::binary_search(_M_fallback.begin(), _M_fallback.end(), __h) ? 1 : 0;
+  }
+
+private:
+  void _M_build(std::vector<unsigned long long>& __rgHashes) {
+    std::vector<size_type> __rgSlots;  // the bit (and so the slot) of each placed key
+    std::vector<unsigned long long> __rgPlaced;
+    std::vector<unsigned char> __rgUsed;  // 0 free, 1 taken, 2 collided
+
+    _M_level_offsets.push_back(0);
+    for(size_type __l = 0; !__rgHashes.empty() && __l != (size_type) _S_max_levels; ++__l) {
+      const size_type __cBits = std::max<size_type>(64, __rgHashes.size() * _S_gamma);
+      _M_level_offsets.push_back(_M_level_offsets.back() + __cBits);
+
+      __rgUsed.assign(__cBits, 0);
+      for(std::vector<unsigned long long>::const_iterator __it = __rgHashes.begin(); __it != __rgHashes.end(); ++__it) {
+        unsigned char& __used = __rgUsed[_M_position(*__it, __l) - _M_level_offsets[__l]];
+        __used = (__used == 0) ? 1 : 2;
+      }
+
+      // the keys alone in their bit stay on this level, the rest go on
+      std::vector<unsigned long long>::iterator __itNext = __rgHashes.begin();
+      for(std::vector<unsigned long long>::const_iterator __it = __rgHashes.begin(); __it != __rgHashes.end(); ++__it) {
+        const size_type __i = _M_position(*__it, __l);
+        if(__rgUsed[__i - _M_level_offsets[__l]] == 1) {
+          __rgSlots.push_back(__i);
+          __rgPlaced.push_back(*__it);
+        }
+        else {
+          *__itNext++ = *__it;
+        }
+      }
+      __rgHashes.erase(__itNext, __rgHashes.end());
+
+      for(size_type __i = 0; __i != __cBits; ++__i) {
+        _M_bits.push_back(__rgUsed[__i] == 1);
+      }
+    }
+    _M_bits.freeze();
+
+    _M_fingerprints.resize(__rgPlaced.size());
+    for(size_type __k = 0; __k != __rgPlaced.size(); ++__k) {
+      _M_fingerprints[_M_bits.rank1(__rgSlots[__k])] = _S_fingerprint(__rgPlaced[__k]);
+    }
+    _M_fallback.swap(__rgHashes);
+  }
+
+  // the bit of the hash __h on level __l
+  size_type _M_position(unsigned long long __h, size_type __l) const {
+    const size_type __cBits = _M_level_offsets[__l + 1] - _M_level_offsets[__l];
+    return _M_level_offsets[__l] + (size_type) (__hash_mix(__h + 0x9E3779B97F4A7C15ULL * (__l + 1)) % __cBits);
+  }
+
+  static _Fingerprint _S_fingerprint(unsigned long long __h) {
+    return (_Fingerprint) __hash_mix(__h ^ 0x2545F4914F6CDD1DULL);
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_PERFECT_HASH_H */
@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A radix (path-compressed) trie built from one of the trie containers.
+ *
+ * In the binary trie every character of a key is a key node of its own, so
+ * the long unique tail of a word is a chain of nodes with one child each and
+ * a lookup follows a link for every character. Here such a chain is one node
+ * holding the run of characters inline, and the children of a node are kept
+ * next to each other in one array, so find, find_if_prefix and
+ * approximate_find compare a whole run before they follow anything. A run
+ * longer than _S_run_capacity goes on in the node's only child.
+ *
+ * The characters are kept as codes from the alphabet of the keys (see
+ * stl_trie_alphabet.h). With a _Code of unsigned char or unsigned short a
+ * node holds more of a run in the same space, and the runs and the edit
+ * distance table compare small integers. A key looked up is encoded once,
+ * as it is read.
+ *
+ * _Units says how the characters of the keys are stored: as they are
+ * (__identity_units) or as the bytes of their UTF-8 encoding (__utf8_units).
+ * Keys looked up are given in the same units, so a UTF-8 radix trie is
+ * searched with UTF-8 strings as they come. The edit distance still counts
+ * characters, not units: a row of the table is added once the last unit of
+ * a character has been read.
+ *
+ * The radix trie is read only: it refers to the values of the trie it was
+ * built from through their iterators, so it must be built again (assign)
+ * after that trie changes.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_RADIX_TRIE_H
+#define __INTERNAL_RADIX_TRIE_H
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <functional>
+#include <stl_trie_alphabet.h>
+
+namespace trie {
+
+// Each character is one unit.
+template <class _SubKeyType, class _Compare = std::less<_SubKeyType> >
+struct __identity_units {
+  typedef _SubKeyType unit_type;
+  typedef _Compare    unit_compare;
+
+  template <class _OutputIterator>
+  static _OutputIterator to_units(const _SubKeyType& __c, _OutputIterator __result) {
+    *__result = __c;
+    return ++__result;
+  }
+
+  // the number of units in the character beginning with __u
+  static unsigned int length(const unit_type&) { return 1; }
+};
+
+// Each character (a code point) is the one to four bytes of its UTF-8
+// encoding. Bytes compare unsigned so that keys keep their order.
+struct __utf8_units {
+  typedef char unit_type;
+
+  struct unit_compare {
+    bool operator()(char __a, char __b) const {
+      return (unsigned char) __a < (unsigned char) __b;
+    }
+  };
+
+  template <class _SubKeyType, class _OutputIterator>
+  static _OutputIterator to_units(const _SubKeyType& __c, _OutputIterator __result) {
+    const unsigned long __cp = (unsigned long) __c;
+    if(__cp < 0x80) {
+      *__result = (char) __cp; ++__result;
+    }
+    else if(__cp < 0x800) {
+      *__result = (char) (0xC0 | (__cp >> 6)); ++__result;
+      *__result = (char) (0x80 | (__cp & 0x3F)); ++__result;
+    }
+    else if(__cp < 0x10000) {
+      *__result = (char) (0xE0 | (__cp >> 12)); ++__result;
+      *__result = (char) (0x80 | ((__cp >> 6) & 0x3F)); ++__result;
+      *__result = (char) (0x80 | (__cp & 0x3F)); ++__result;
+    }
+    else {
+      *__result = (char) (0xF0 | (__cp >> 18)); ++__result;
+      *__result = (char) (0x80 | ((__cp >> 12) & 0x3F)); ++__result;
+      *__result = (char) (0x80 | ((__cp >> 6) & 0x3F)); ++__result;
+      *__result = (char) (0x80 | (__cp & 0x3F)); ++__result;
+    }
+    return __result;
+  }
+
+  // a stray continuation byte is a character of its own
+  static unsigned int length(char __u) {
+    const unsigned char __b = (unsigned char) __u;
+    return (__b < 0xC0) ? 1 : (__b < 0xE0) ? 2 : (__b < 0xF0) ? 3 : 4;
+  }
+};
+
+template <class _Trie,
+          class _Code = typename _Trie::sub_key_type,
+          class _Units = __identity_units<typename _Trie::sub_key_type, typename _Trie::key_compare> >
+class radix_trie {
+public:
+  // typedefs:
+
+  typedef typename _Trie::key_type        key_type;
+  typedef typename _Trie::value_type      value_type;
+  typedef typename _Trie::sub_key_type    sub_key_type;
+  typedef typename _Trie::key_begin       key_begin;
+  typedef typename _Trie::key_end         key_end;
+  typedef typename _Trie::const_iterator  const_iterator;
+  typedef typename _Trie::size_type       size_type;
+  typedef typename _Units::unit_type      unit_type;
+  typedef typename _Units::unit_compare   unit_compare;
+  typedef _Code                           code_type;
+  typedef alphabet<unit_type, _Code, unit_compare> alphabet_type;
+
+  enum { _S_run_capacity = 12 / sizeof(_Code) }; // units held inline by a node
+
+private:
+  struct _Node {
+    _Code         _M_run[_S_run_capacity];
+    unsigned char _M_run_length;
+    unsigned int  _M_first_child;
+    unsigned int  _M_child_count;
+    unsigned int  _M_first_value;  // into _M_values
+    unsigned int  _M_value_count;  // more than one in the multi containers
+  };
+
+  // collects the keys of the trie as units, in the order of its iterators
+  class _KeyCollector {
+  public:
+    _KeyCollector(std::vector<unit_type>& __rgUnits, std::vector<size_type>& __rgEnds)
+      : _M_units(&__rgUnits), _M_ends(&__rgEnds) {}
+
+    template <class _Ref>
+    void operator()(const sub_key_type* __first, const sub_key_type* __last, _Ref) {
+      for(; __first != __last; ++__first) {
+        _Units::to_units(*__first, std::back_inserter(*_M_units));
+      }
+      _M_ends->push_back(_M_units->size());
+    }
+  private:
+    std::vector<unit_type>* _M_units;
+    std::vector<size_type>* _M_ends;
+  };
+
+  // keys [_M_lo, _M_hi) all begin with the same _M_depth units and
+  // below _M_node
+  struct _BuildFrame {
+    size_type _M_node;
+    size_type _M_lo;
+    size_type _M_hi;
+    size_type _M_depth;
+  };
+
+  // _M_node and the rows of the edit distance table up to _M_depth. The
+  // character being read when the node was reached still wants _M_pending
+  // units; _M_partial holds those read so far.
+  struct _MatchFrame {
+    size_type          _M_node;
+    size_type          _M_depth;
+    unsigned int       _M_pending;
+    unsigned long long _M_partial;
+  };
+
+  // a value found by approximate matching, by its index in _M_values
+  typedef __weighted_candidate<size_type> _candidate;
+
+  std::vector<_Node>          _M_nodes; // the root is first
+  std::vector<const_iterator> _M_values;
+  const_iterator              _M_end;
+  alphabet_type               _M_alphabet;
+
+public:
+  // allocation/deallocation
+
+  radix_trie() {}
+
+  explicit radix_trie(const _Trie& __t) { assign(__t); }
+
+  // builds the radix trie from the keys of __t. If _Code cannot number
+  // their characters this throws std::length_error and leaves it empty.
+  void assign(const _Trie& __t) {
+    std::vector<unit_type> __rgUnits;
+    std::vector<size_type> __rgEnds;
+
+    clear();
+    _M_end = __t.end();
+
+    __t.for_each(_KeyCollector(__rgUnits, __rgEnds));
+    _M_alphabet.assign(__rgUnits.begin(), __rgUnits.end());
+    std::vector<_Code> __rgCodes(__rgUnits.size());
+    _M_alphabet.encode(__rgUnits.begin(), __rgUnits.end(), __rgCodes.begin());
+
+    _M_values.reserve(__rgEnds.size());
+    for(const_iterator __it = __t.begin(); __it != __t.end(); ++__it) {
+      _M_values.push_back(__it);
+    }
+    assert(_M_values.size() == __rgEnds.size());
+
+    _M_nodes.push_back(_S_make_node(0, 0, 0));
+    if(!__rgEnds.empty()) {
+      _M_build(__rgCodes, __rgEnds);
+    }
+  }
+
+  void clear() {
+    _M_nodes.clear();
+    _M_values.clear();
+    _M_alphabet.clear();
+  }
+
+  bool empty() const { return _M_values.empty(); }
+  size_type size() const { return _M_values.size(); }
+  size_type node_count() const { return _M_nodes.size(); }
+  size_type node_size() const { return sizeof(_Node); }
+  const alphabet_type& get_alphabet() const { return _M_alphabet; }
+
+  // the end of the trie it was built from
+  const_iterator end() const { return _M_end; }
+
+  // set operations:
+  //
+  // A key is given either as a key_type, when the units are the characters
+  // themselves, or as a range of units.
+
+  const_iterator find(const key_type& __x) const {
+    return find(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  const_iterator find(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    if(_M_nodes.empty()) {
+      return _M_end;
+    }
+    const _Node* __node = &_M_nodes.front();
+    for(size_type __iRun = 0;; __iRun = 1, ++__itKey) { // a child matches the first of its run
+      for(size_type __i = __iRun; __i != __node->_M_run_length; ++__i, ++__itKey) {
+        if(__itKey == __itKeyEnd || __node->_M_run[__i] != _M_alphabet.encode(*__itKey)) {
+          return _M_end;
+        }
+      }
+      if(__itKey == __itKeyEnd) {
+        return (__node->_M_value_count != 0) ? _M_values[__node->_M_first_value] : _M_end;
+      }
+      __node = _M_child(*__node, _M_alphabet.encode(*__itKey));
+      if(__node == 0) {
+        return _M_end;
+      }
+    }
+  }
+
+  // the longest key in the trie that is a prefix of __x (or __x itself)
+  const_iterator find_if_prefix(const key_type& __x) const {
+    return find_if_prefix(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  const_iterator find_if_prefix(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    const_iterator __j = _M_end;
+    if(_M_nodes.empty() || __itKey == __itKeyEnd) {
+      return __j;
+    }
+    const _Node* __node = &_M_nodes.front();
+    for(size_type __iRun = 0;; __iRun = 1, ++__itKey) { // a child matches the first of its run
+      for(size_type __i = __iRun; __i != __node->_M_run_length; ++__i, ++__itKey) {
+        if(__itKey == __itKeyEnd || __node->_M_run[__i] != _M_alphabet.encode(*__itKey)) {
+          return __j;
+        }
+      }
+      if(__node->_M_value_count != 0 && __node != &_M_nodes.front()) {
+        __j = _M_values[__node->_M_first_value];
+      }
+      if(__itKey == __itKeyEnd) {
+        return __j;
+      }
+      __node = _M_child(*__node, _M_alphabet.encode(*__itKey));
+      if(__node == 0) {
+        return __j;
+      }
+    }
+  }
+
+  // the keys in the trie that are prefixes of __x (or __x itself), shortest
+  // first. The empty key is not one of them.
+  std::vector<const_iterator> find_prefixes(const key_type& __x) const {
+    return find_prefixes(key_begin()(__x), key_end()(__x));
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> find_prefixes(_InputIterator __itKey, const _InputIterator& __itKeyEnd) const {
+    std::vector<const_iterator> __rgIt;
+    if(_M_nodes.empty() || __itKey == __itKeyEnd) {
+      return __rgIt;
+    }
+    const _Node* __node = &_M_nodes.front();
+    for(size_type __iRun = 0;; __iRun = 1, ++__itKey) { // a child matches the first of its run
+      for(size_type __i = __iRun; __i != __node->_M_run_length; ++__i, ++__itKey) {
+        if(__itKey == __itKeyEnd || __node->_M_run[__i] != _M_alphabet.encode(*__itKey)) {
+          return __rgIt;
+        }
+      }
+      if(__node->_M_value_count != 0 && __node != &_M_nodes.front()) {
+        __rgIt.push_back(_M_values[__node->_M_first_value]);
+      }
+      if(__itKey == __itKeyEnd) {
+        return __rgIt;
+      }
+      __node = _M_child(*__node, _M_alphabet.encode(*__itKey));
+      if(__node == 0) {
+        return __rgIt;
+      }
+    }
+  }
+
+  // approximate string matching
+  //
+  // Edits are insertions, deletions, replacements and transpositions of
+  // characters. One row of the edit distance table is added for each
+  // character read and a subtrie is cut off once no entry in the row is
+  // within the cutoff. The empty key is never found.
+
+  // the values within __k edits of __x, in the order of the trie
+  std::vector<const_iterator> approximate_find(const key_type& __x, unsigned int __k = 1) const {
+    return approximate_find(key_begin()(__x), key_end()(__x), __k);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> approximate_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = 1) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), false, __k, __rgFound);
+    return _M_found_values(__rgFound);
+  }
+
+  // the values closest to __x, if they are within __k edits
+  std::vector<const_iterator> best_find(const key_type& __x, unsigned int __k = TRIE_INFINITY) const {
+    return best_find(key_begin()(__x), key_end()(__x), __k);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> best_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = TRIE_INFINITY) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), true, __k, __rgFound);
+    return _M_found_values(__rgFound);
+  }
+
+  // the __n best values within __k edits, ordered by distance and then by
+  // weight (heaviest first). __n == 0 returns every value within __k edits.
+  std::vector<const_iterator> weighted_find(const key_type& __x, unsigned int __k = 1, size_type __n = 0) const {
+    return weighted_find(key_begin()(__x), key_end()(__x), __k, __n);
+  }
+
+  template <class _InputIterator>
+  std::vector<const_iterator> weighted_find(_InputIterator __itKey, _InputIterator __itKeyEnd, unsigned int __k = 1, size_type __n = 0) const {
+    std::vector<_candidate> __rgFound;
+    _M_approximate_match(_M_characters(__itKey, __itKeyEnd), false, __k, __rgFound);
+    std::sort(__rgFound.begin(), __rgFound.end());
+    if(__n != 0 && __rgFound.size() > __n) {
+      __rgFound.resize(__n);
+    }
+    return _M_found_values(__rgFound);
+  }
+
+private:
+  static _Node _S_make_node(size_type __cRun, size_type __iFirstValue, size_type __cValues) {
+    _Node __node;
+    __node._M_run_length = (unsigned char) __cRun;
+    __node._M_first_child = 0;
+    __node._M_child_count = 0;
+    __node._M_first_value = (unsigned int) __iFirstValue;
+    __node._M_value_count = (unsigned int) __cValues;
+    return __node;
+  }
+
+  // the child whose run begins with __c; children are in key order
+  const _Node* _M_child(const _Node& __node, _Code __c) const {
+    const _Node* __first = &_M_nodes[0] + __node._M_first_child;
+    const _Node* __last = __first + __node._M_child_count;
+    while(__first != __last) {
+      const _Node* __mid = __first + (__last - __first) / 2;
+      if(__mid->_M_run[0] < __c) {
+        __first = __mid + 1;
+      }
+      else {
+        __last = __mid;
+      }
+    }
+    if(__first != &_M_nodes[0] + __node._M_first_child + __node._M_child_count &&
+       __first->_M_run[0] == __c) {
+      return __first;
+    }
+    return 0;
+  }
+
+  // the children of a node are made together so that they are next to each
+  // other, then each of them is filled in, depth first
+  void _M_build(const std::vector<_Code>& __rgSubKeys, const std::vector<size_type>& __rgEnds) {
+    std::vector<_BuildFrame> __stack;
+    _BuildFrame __root = { 0, 0, __rgEnds.size(), 0 };
+    __stack.push_back(__root);
+
+    while(!__stack.empty()) {
+      const _BuildFrame __frame = __stack.back();
+      __stack.pop_back();
+
+      // keys which end here are the values of the node
+      size_type __lo = __frame._M_lo;
+      while(__lo != __frame._M_hi && _S_length(__rgEnds, __lo) == __frame._M_depth) {
+        ++__lo;
+      }
+      _M_nodes[__frame._M_node]._M_first_value = (unsigned int) __frame._M_lo;
+      _M_nodes[__frame._M_node]._M_value_count = (unsigned int) (__lo - __frame._M_lo);
+      _M_nodes[__frame._M_node]._M_first_child = (unsigned int) _M_nodes.size();
+
+      // the rest are grouped by their next unit
+      const size_type __iFirstChild = _M_nodes.size();
+      std::vector<_BuildFrame> __rgChildren;
+      while(__lo != __frame._M_hi) {
+        const _Code __c = __rgSubKeys[_S_begin(__rgEnds, __lo) + __frame._M_depth];
+        size_type __hi = __lo + 1;
+        while(__hi != __frame._M_hi &&
+              __c == __rgSubKeys[_S_begin(__rgEnds, __hi) + __frame._M_depth]) {
+          ++__hi;
+        }
+
+        // the keys are sorted so the first and the last share the run
+        const size_type __iFirst = _S_begin(__rgEnds, __lo);
+        const size_type __iLast = _S_begin(__rgEnds, __hi - 1);
+        const size_type __cMax = std::min(_S_length(__rgEnds, __lo), _S_length(__rgEnds, __hi - 1));
+        size_type __cRun = 1;
+        while(__frame._M_depth + __cRun != __cMax && __cRun != (size_type) _S_run_capacity &&
+              __rgSubKeys[__iFirst + __frame._M_depth + __cRun] ==
+              __rgSubKeys[__iLast + __frame._M_depth + __cRun]) {
+          ++__cRun;
+        }
+
+        _Node __child = _S_make_node(__cRun, __lo, 0);
+        std::copy(__rgSubKeys.begin() + __iFirst + __frame._M_depth,
+                  __rgSubKeys.begin() + __iFirst + __frame._M_depth + __cRun,
+                  __child._M_run);
+        _BuildFrame __childFrame = { _M_nodes.size(), __lo, __hi, __frame._M_depth + __cRun };
+        _M_nodes.push_back(__child);
+        __rgChildren.push_back(__childFrame);
+        __lo = __hi;
+      }
+      _M_nodes[__frame._M_node]._M_child_count = (unsigned int) (_M_nodes.size() - __iFirstChild);
+      __stack.insert(__stack.end(), __rgChildren.rbegin(), __rgChildren.rend());
+    }
+  }
+
+  static size_type _S_begin(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return (__i == 0) ? 0 : __rgEnds[__i - 1];
+  }
+
+  static size_type _S_length(const std::vector<size_type>& __rgEnds, size_type __i) {
+    return __rgEnds[__i] - _S_begin(__rgEnds, __i);
+  }
+
+  // a character is the codes of its units, one digit each, so that
+  // characters of different lengths differ too
+  static unsigned long long _S_add_unit(unsigned long long __c, _Code __code) {
+    return __c * ((unsigned long long) _Code(-1) + 2) + __code + 1;
+  }
+
+  template <class _InputIterator>
+  std::vector<unsigned long long> _M_characters(_InputIterator __itKey, _InputIterator __itKeyEnd) const {
+    std::vector<unsigned long long> __rgChars;
+    while(__itKey != __itKeyEnd) {
+      unsigned long long __c = 0;
+      for(unsigned int __cUnits = _Units::length(*__itKey); __cUnits != 0 && __itKey != __itKeyEnd; --__cUnits, ++__itKey) {
+        __c = _S_add_unit(__c, _M_alphabet.encode(*__itKey));
+      }
+      __rgChars.push_back(__c);
+    }
+    return __rgChars;
+  }
+
+  std::vector<const_iterator> _M_found_values(const std::vector<_candidate>& __rgFound) const {
+    std::vector<const_iterator> __rgIt;
+    __rgIt.reserve(__rgFound.size());
+    for(typename std::vector<_candidate>::const_iterator __it = __rgFound.begin(); __it != __rgFound.end(); ++__it) {
+      __rgIt.push_back(_M_values[__it->_M_node]);
+    }
+    return __rgIt;
+  }
+
+  // every value within __k edits of __rgKey, in the order of the trie. With
+  // __fBestCase only the closest are kept and the cutoff drops to their
+  // distance as they are found.
+  void _M_approximate_match(const std::vector<unsigned long long>& __rgKey, bool __fBestCase, unsigned int __k,
+                            std::vector<_candidate>& __rgFound) const {
+    if(_M_nodes.empty()) {
+      return;
+    }
+
+    const size_type __m = __rgKey.size();
+    std::vector<unsigned long long> __W;    // the characters down to the node
+    std::vector<unsigned int> __DT(__m + 1); // row __i is at __i*(__m+1)
+    for(size_type __j = 0; __j <= __m; ++__j) {
+      __DT[__j] = (unsigned int) __j;
+    }
+    __value_weight<value_type> __weight;
+
+    std::vector<_MatchFrame> __stack;
+    _MatchFrame __root = { 0, 0, 0, 0 };
+    __stack.push_back(__root);
+    while(!__stack.empty()) {
+      _MatchFrame __frame = __stack.back();
+      __stack.pop_back();
+      const _Node& __node = _M_nodes[__frame._M_node];
+
+      size_type __i = __frame._M_depth;
+      __W.resize(__i);
+      __DT.resize((__i + 1) * (__m + 1));
+      bool __fCutoff = false;
+      for(size_type __r = 0; __r != __node._M_run_length && !__fCutoff; ++__r) {
+        if(__frame._M_pending == 0) {
+          __frame._M_pending = _Units::length(_M_alphabet.decode(__node._M_run[__r]));
+          __frame._M_partial = 0;
+        }
+        __frame._M_partial = _S_add_unit(__frame._M_partial, __node._M_run[__r]);
+        if(--__frame._M_pending == 0) {
+          __W.push_back(__frame._M_partial);
+          ++__i;
+          __fCutoff = _S_next_row(__rgKey, __W, __DT, __i, __k);
+        }
+      }
+      if(__fCutoff) {
+        continue;
+      }
+
+      const unsigned int __d = __DT[__i * (__m + 1) + __m];
+      if(__node._M_value_count != 0 && __i != 0 && __frame._M_pending == 0 && __d <= __k) {
+        if(__fBestCase && __d < __k) {
+          __k = __d;
+          __rgFound.clear();
+        }
+        for(size_type __v = __node._M_first_value; __v != __node._M_first_value + __node._M_value_count; ++__v) {
+          _candidate __found = { __d, __weight(*_M_values[__v]), __v, __v };
+          __rgFound.push_back(__found);
+        }
+      }
+      for(size_type __c = __node._M_child_count; __c != 0; --__c) {
+        _MatchFrame __child = { __node._M_first_child + __c - 1, __i, __frame._M_pending, __frame._M_partial };
+        __stack.push_back(__child);
+      }
+    }
+  }
+
+  // fills in row __i of the edit distance table between __rgKey and the
+  // first __i characters of __W, true if every entry is over __k
+  static bool _S_next_row(const std::vector<unsigned long long>& __rgKey, const std::vector<unsigned long long>& __W,
+                          std::vector<unsigned int>& __DT, size_type __i, unsigned int __k) {
+    const size_type __m = __rgKey.size();
+    __DT.resize((__i + 1) * (__m + 1));
+    unsigned int* __row = &__DT[__i * (__m + 1)];
+    const unsigned int* __prev = __row - (__m + 1);
+    const unsigned long long __w = __W[__i - 1];
+
+    __row[0] = (unsigned int) __i;
+    unsigned int __min = __row[0];
+    for(size_type __j = 1; __j <= __m; ++__j) {
+      unsigned int __d = std::min(__row[__j - 1] + 1, __prev[__j] + 1);
+      __d = std::min(__d, __prev[__j - 1] + ((__rgKey[__j - 1] == __w) ? 0 : 1));
+      if(__i > 1 && __j > 1 && __rgKey[__j - 2] == __w && __rgKey[__j - 1] == __W[__i - 2]) {
+        __d = std::min(__d, __prev[__j - 2 - (__m + 1)] + 1);
+      }
+      __row[__j] = __d;
+      __min = std::min(__min, __d);
+    }
+    return __min > __k;
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_RADIX_TRIE_H */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A bit vector with rank and select, for the succinct structures
+ * (stl_louds_trie.h, stl_perfect_hash.h).
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_RANK_SELECT_H
+#define __INTERNAL_RANK_SELECT_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace trie {
+
+// A vector of bits, appended to and then frozen, which counts the 1s before
+// a bit (rank1) and finds the i'th 0 (select0) in about constant time. A
+// frozen bit can still be set, at the cost of a pass over the block ranks.
+class __rank_select_bits {
+public:
+  typedef size_t size_type;
+
+  enum { _S_word_bits = 64,
+         _S_block_words = 8,   // the number of 1s before every 512 bits is kept
+         _S_zero_sample = 512  // and the block of every 512th 0
+  };
+
+private:
+  std::vector<unsigned long long> _M_words;
+  std::vector<unsigned int>       _M_block_ranks;
+  std::vector<unsigned int>       _M_zero_samples;
+  size_type                       _M_size;
+
+public:
+  __rank_select_bits() : _M_size(0) {}
+
+  void push_back(bool __f) {
+    if(_M_size % _S_word_bits == 0) {
+      _M_words.push_back(0);
+    }
+    if(__f) {
+      _M_words.back() |= 1ULL << (_M_size % _S_word_bits);
+    }
+    ++_M_size;
+  }
+
+  // makes the tables for rank1 and select0, once every bit is in
+  void freeze() {
+    _M_block_ranks.clear();
+    _M_zero_samples.clear();
+    _M_words.resize((_M_words.size() + _S_block_words - 1) / _S_block_words * _S_block_words + _S_block_words, 0);
+
+    size_type __cOnes = 0;
+    size_type __cZeros = 0;
+    const size_type __cBlocks = _M_words.size() / _S_block_words;
+    for(size_type __b = 0; __b != __cBlocks; ++__b) {
+      _M_block_ranks.push_back((unsigned int) __cOnes);
+      size_type __cBlockOnes = 0;
+      for(size_type __w = 0; __w != _S_block_words; ++__w) {
+        __cBlockOnes += _S_popcount(_M_words[__b * _S_block_words + __w]);
+      }
+      // the zeros in the padding past _M_size are not counted
+      const size_type __cBits = std::min<size_type>(_S_block_words * _S_word_bits,
+        (_M_size > __b * _S_block_words * _S_word_bits) ? _M_size - __b * _S_block_words * _S_word_bits : 0);
+      const size_type __cBlockZeros = __cBits - __cBlockOnes;
+      while(_M_zero_samples.size() * _S_zero_sample < __cZeros + __cBlockZeros) {
+        _M_zero_samples.push_back((unsigned int) __b);
+      }
+      __cOnes += __cBlockOnes;
+      __cZeros += __cBlockZeros;
+    }
+  }
+
+  // sets a bit of a frozen vector; the zero samples are left as they were,
+  // as the zeros they record only move to later blocks and select0 walks
+  // forward from them
+  void set(size_type __i) {
+    unsigned long long& __w = _M_words[__i / _S_word_bits];
+    const unsigned long long __bit = 1ULL << (__i % _S_word_bits);
+    if((__w & __bit) != 0) {
+      return;
+    }
+    __w |= __bit;
+    for(size_type __b = __i / (_S_block_words * _S_word_bits) + 1; __b < _M_block_ranks.size(); ++__b) {
+      ++_M_block_ranks[__b];
+    }
+  }
+
+  void clear() {
+    _M_words.clear();
+    _M_block_ranks.clear();
+    _M_zero_samples.clear();
+    _M_size = 0;
+  }
+
+  size_type size() const { return _M_size; }
+
+  bool operator[](size_type __i) const {
+    return ((_M_words[__i / _S_word_bits] >> (__i % _S_word_bits)) & 1) != 0;
+  }
+
+  // the number of 1s in [0, __i)
+  size_type rank1(size_type __i) const {
+    const size_type __iWord = __i / _S_word_bits;
+    size_type __r = _M_block_ranks[__iWord / _S_block_words];
+    for(size_type __w = __iWord - __iWord % _S_block_words; __w != __iWord; ++__w) {
+      __r += _S_popcount(_M_words[__w]);
+    }
+    if(__i % _S_word_bits != 0) {
+      __r += _S_popcount(_M_words[__iWord] & ((1ULL << (__i % _S_word_bits)) - 1));
+    }
+    return __r;
+  }
+
+  // the position of the __i'th 0, counting from 0; there must be one
+  size_type select0(size_type __i) const {
+    size_type __b = _M_zero_samples[__i / _S_zero_sample];
+    while(__b + 1 < _M_block_ranks.size() && _M_zeros_before(__b + 1) <= __i) {
+      ++__b;
+    }
+    __i -= _M_zeros_before(__b);
+    size_type __w = __b * _S_block_words;
+    for(;; ++__w) {
+      const size_type __cZeros = _S_word_bits - _S_popcount(_M_words[__w]);
+      if(__i < __cZeros) {
+        break;
+      }
+      __i -= __cZeros;
+    }
+    unsigned long long __x = ~_M_words[__w];
+    for(; __i != 0; --__i) {
+      __x &= __x - 1; // drops the lowest 0 of the word
+    }
+    size_type __bit = 0;
+    for(; (__x & 1) == 0; __x >>= 1) {
+      ++__bit;
+    }
+    return __w * _S_word_bits + __bit;
+  }
+
+  // the bytes taken by the bits and the tables
+  size_type memory_size() const {
+    return _M_words.size() * sizeof(unsigned long long) +
+           (_M_block_ranks.size() + _M_zero_samples.size()) * sizeof(unsigned int);
+  }
+
+private:
+  size_type _M_zeros_before(size_type __b) const {
+    return __b * _S_block_words * _S_word_bits - _M_block_ranks[__b];
+  }
+
+  static size_type _S_popcount(unsigned long long __x) {
+    __x = __x - ((__x >> 1) & 0x5555555555555555ULL);
+    __x = (__x & 0x3333333333333333ULL) + ((__x >> 2) & 0x3333333333333333ULL);
+    __x = (__x + (__x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (size_type) ((__x * 0x0101010101010101ULL) >> 56);
+  }
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_RANK_SELECT_H */
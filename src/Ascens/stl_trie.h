@@ -95,6 +95,20 @@
   #define TRACE  1 ? (void)0 : Trace
 #endif
 
+// __TRIE_PREFETCH(p) asks for the node at p to be brought into the cache
+// while the current one is still being looked at, for the walks which go
+// from node to node; p may be 0. Define ASCENS_NO_PREFETCH to leave it out.
+#if defined(ASCENS_NO_PREFETCH)
+  #define __TRIE_PREFETCH(p) ((void)0)
+#elif defined(__GNUC__)
+  #define __TRIE_PREFETCH(p) __builtin_prefetch((const void*)(p))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  #include <xmmintrin.h>
+  #define __TRIE_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+  #define __TRIE_PREFETCH(p) ((void)0)
+#endif
+
 /*
   Trie class, designed for use in implementing STL associative containers 
   (trie_set, trie_multiset, trie_map, and trie_multimap).
@@ -181,6 +195,10 @@
 #include <functional>
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <queue>
+#include <map>
+#include <set>
 
 #define __STL_CLASS_PARTIAL_SPECIALIZATION
 //#include <stl_vector.h>
@@ -215,6 +233,63 @@ struct _Identity : public std::unary_function<_Tp,_Tp> {
   const _Tp& operator()(const _Tp& __x) const { return __x; }
 };
 
+// The weight of a value ranks it against other values which match equally well
+// (see weighted_find). Values have no weight unless they map a key to an
+// unsigned int, in which case the mapped value is the weight (a frequency).
+template <class _Value>
+struct __value_weight : public std::unary_function<_Value, unsigned int> {
+  unsigned int operator()(const _Value&) const { return 0; }
+};
+
+template <class _Key>
+struct __value_weight<std::pair<const _Key, unsigned int> >
+  : public std::unary_function<std::pair<const _Key, unsigned int>, unsigned int> {
+  unsigned int operator()(const std::pair<const _Key, unsigned int>& __x) const { return __x.second; }
+};
+
+
+// A value found by weighted_find. Candidates are ordered best first: by
+// distance, then by weight (heaviest first), then in trie order.
+template <class _Link>
+struct __weighted_candidate {
+  unsigned int _M_distance;
+  unsigned int _M_weight;
+  size_t       _M_order;
+  _Link        _M_node;
+
+  bool operator<(const __weighted_candidate& __x) const {
+    if(_M_distance != __x._M_distance) {
+      return _M_distance < __x._M_distance;
+    }
+    if(_M_weight != __x._M_weight) {
+      return _M_weight > __x._M_weight;
+    }
+    return _M_order < __x._M_order;
+  }
+  bool operator>(const __weighted_candidate& __x) const {
+    return __x < *this;
+  }
+};
+
+// One element of a pattern for pattern_find: a sub key, any single sub key
+// (?), any run of sub keys (*) or a class of sub keys ([abc], [a-z], [^abc]).
+template <class _SubKeyType>
+struct __pattern_element {
+  enum __type { __literal, __any, __star, __class };
+
+  __type  _M_type;
+  bool    _M_negate;  // [^...]
+  std::vector< std::pair<_SubKeyType, _SubKeyType> > _M_ranges; // a literal is _M_ranges[0].first
+};
+
+// A pair of values found by approximate_join: first from the trie joined,
+// second from the other trie, and the edit distance between their keys.
+template <class _Iterator>
+struct __approximate_pair {
+  _Iterator    first;
+  _Iterator    second;
+  unsigned int distance;
+};
 
 // END TRIE_SPECIALIZATION
 
@@ -311,6 +386,8 @@ public:
   typedef _b_trie_key_node<_SubKeyType>*   _key_link_type;
 
   typename _SubKeyType   _M_key_field;
+  unsigned int           _M_weight;  // greatest weight of any value below this node
+  size_t                 _M_count;   // number of values below this node
 };
 
 template <class _Value>
@@ -550,23 +627,112 @@ public:
   
   _b_trie_alloc_base(const _Alloc& __a)
     : _M_allocator(__a),
-      _M_header(0) {}
+      _M_header(0),
+      _M_free_keys(0),
+      _M_free_values(0),
+      _M_free_key_count(0),
+      _M_free_value_count(0) {}
 
 protected:
   _key_link_type _M_header;
 
+  // a node freed from one of the blocks is reused before a new one is
+  // allocated
   _key_link_type _M_allocate_key_node() { 
+    if(_M_free_keys != 0) {
+      _key_link_type __k = _M_free_keys;
+      _M_free_keys = (_key_link_type) __k->_M_right;
+      --_M_free_key_count;
+      return __k;
+    }
     return _allocator_type::rebind<_key_node_type>::other(_M_allocator).allocate(1);
   }
   _value_link_type _M_allocate_value_node() { 
+    if(_M_free_values != 0) {
+      _value_link_type __v = _M_free_values;
+      _M_free_values = (_value_link_type) __v->_M_right;
+      --_M_free_value_count;
+      return __v;
+    }
     return _allocator_type::rebind<_value_node_type>::other(_M_allocator).allocate(1);
   }
 
+  // a node in one of the blocks laid out by compact() is not given back on
+  // its own but kept on a free list, linked through _M_right; the whole
+  // block is given back once none of its nodes are left
   void _M_deallocate_key_node(_key_link_type __k) {
-    _allocator_type::rebind<_key_node_type>::other(_M_allocator).deallocate(__k, 1);
+    if(_S_in_blocks(_M_key_blocks, __k)) {
+      __k->_M_right = _M_free_keys;
+      _M_free_keys = __k;
+      ++_M_free_key_count;
+    }
+    else {
+      _allocator_type::rebind<_key_node_type>::other(_M_allocator).deallocate(__k, 1);
+    }
   }
   void _M_deallocate_value_node(_value_link_type __v) { 
-    _allocator_type::rebind<_value_node_type>::other(_M_allocator).deallocate(__v, 1);
+    if(_S_in_blocks(_M_value_blocks, __v)) {
+      __v->_M_right = _M_free_values;
+      _M_free_values = __v;
+      ++_M_free_value_count;
+    }
+    else {
+      _allocator_type::rebind<_value_node_type>::other(_M_allocator).deallocate(__v, 1);
+    }
+  }
+
+  // room for the record of a block is made before it is allocated, so
+  // that recording it cannot throw and lose it
+  _key_link_type _M_allocate_key_block(size_t __n) {
+    if(_M_key_blocks.size() == _M_key_blocks.capacity()) {
+      _M_key_blocks.reserve(2 * _M_key_blocks.size() + 1);
+    }
+    _key_link_type __k = _allocator_type::rebind<_key_node_type>::other(_M_allocator).allocate(__n);
+    _M_key_blocks.push_back(std::make_pair(__k, __n));
+    return __k;
+  }
+  _value_link_type _M_allocate_value_block(size_t __n) {
+    if(_M_value_blocks.size() == _M_value_blocks.capacity()) {
+      _M_value_blocks.reserve(2 * _M_value_blocks.size() + 1);
+    }
+    _value_link_type __v = _allocator_type::rebind<_value_node_type>::other(_M_allocator).allocate(__n);
+    _M_value_blocks.push_back(std::make_pair(__v, __n));
+    return __v;
+  }
+
+  // gives back the key blocks [__iKeyFirst, __iKeyLast) and the value
+  // blocks [__iValueFirst, __iValueLast), which must hold no nodes but free
+  // ones
+  void _M_deallocate_blocks(size_t __iKeyFirst, size_t __iKeyLast, size_t __iValueFirst, size_t __iValueLast) {
+    // the free nodes of these blocks come off the lists first
+    if(__iKeyFirst != __iKeyLast) {
+      const std::vector<std::pair<_key_link_type, size_t> > __rgGone(_M_key_blocks.begin() + __iKeyFirst, _M_key_blocks.begin() + __iKeyLast);
+      _M_free_key_count = _S_drop_in_blocks(__rgGone, _M_free_keys);
+    }
+    if(__iValueFirst != __iValueLast) {
+      const std::vector<std::pair<_value_link_type, size_t> > __rgGone(_M_value_blocks.begin() + __iValueFirst, _M_value_blocks.begin() + __iValueLast);
+      _M_free_value_count = _S_drop_in_blocks(__rgGone, _M_free_values);
+    }
+    for(size_t __i = __iKeyFirst; __i != __iKeyLast; ++__i) {
+      _allocator_type::rebind<_key_node_type>::other(_M_allocator).deallocate(_M_key_blocks[__i].first, _M_key_blocks[__i].second);
+    }
+    for(size_t __i = __iValueFirst; __i != __iValueLast; ++__i) {
+      _allocator_type::rebind<_value_node_type>::other(_M_allocator).deallocate(_M_value_blocks[__i].first, _M_value_blocks[__i].second);
+    }
+    _M_key_blocks.erase(_M_key_blocks.begin() + __iKeyFirst, _M_key_blocks.begin() + __iKeyLast);
+    _M_value_blocks.erase(_M_value_blocks.begin() + __iValueFirst, _M_value_blocks.begin() + __iValueLast);
+  }
+
+  // the number of nodes the blocks hold, in use or free
+  size_t _M_block_node_count() const {
+    size_t __n = 0;
+    for(size_t __i = 0; __i != _M_key_blocks.size(); ++__i) {
+      __n += _M_key_blocks[__i].second;
+    }
+    for(size_t __i = 0; __i != _M_value_blocks.size(); ++__i) {
+      __n += _M_value_blocks[__i].second;
+    }
+    return __n;
   }
 
   void _M_construct_key(_key_link_type __x, _sub_key_type __k) {
@@ -583,7 +749,43 @@ protected:
     _allocator_type::rebind<_value_type>::other(_M_allocator).destroy(&__v->_M_value_field);
   }
 
+  std::vector<std::pair<_key_link_type, size_t> >   _M_key_blocks;
+  std::vector<std::pair<_value_link_type, size_t> > _M_value_blocks;
+  _key_link_type   _M_free_keys;     // free nodes of the blocks
+  _value_link_type _M_free_values;
+  size_t           _M_free_key_count;
+  size_t           _M_free_value_count;
+
 private:    
+  // takes the nodes in __rgBlocks off the free list __free; the number left
+  template <class _Link>
+  static size_t _S_drop_in_blocks(const std::vector<std::pair<_Link, size_t> >& __rgBlocks, _Link& __free) {
+    size_t __n = 0;
+    _Link __kept = 0;
+    for(_Link __x = __free; __x != 0; ) {
+      _Link __next = (_Link) __x->_M_right;
+      if(!_S_in_blocks(__rgBlocks, __x)) {
+        __x->_M_right = __kept;
+        __kept = __x;
+        ++__n;
+      }
+      __x = __next;
+    }
+    __free = __kept;
+    return __n;
+  }
+
+  template <class _Link>
+  static bool _S_in_blocks(const std::vector<std::pair<_Link, size_t> >& __rgBlocks, _Link __x) {
+    std::less<_Link> __less;
+    for(size_t __i = 0; __i != __rgBlocks.size(); ++__i) {
+      if(!__less(__x, __rgBlocks[__i].first) && __less(__x, __rgBlocks[__i].first + __rgBlocks[__i].second)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   typename _allocator_type    _M_allocator;
 };
 
@@ -663,6 +865,16 @@ protected:
     using _Base::_M_construct_key;
     using _Base::_M_construct_value;
     using _Base::_M_header;
+    using _Base::_M_allocate_key_block;
+    using _Base::_M_allocate_value_block;
+    using _Base::_M_deallocate_blocks;
+    using _Base::_M_key_blocks;
+    using _Base::_M_value_blocks;
+    using _Base::_M_free_keys;
+    using _Base::_M_free_values;
+    using _Base::_M_free_key_count;
+    using _Base::_M_free_value_count;
+    using _Base::_M_block_node_count;
 
 protected:
     _key_link_type _M_create_key_node(const sub_key_type& __x) {
@@ -678,6 +890,8 @@ protected:
         (_M_deallocate_key_node(__tmp));
         throw; 
       }
+      __tmp->_M_weight = 0;
+      __tmp->_M_count = 0;
       return __tmp;
     }
 
@@ -708,6 +922,8 @@ protected:
         assert(__x != NULL);
         assert(__x->_debugfIsEdge == false);
         __tmp = _M_create_key_node(_S_key(__x));
+        _key_link_type(__tmp)->_M_weight = _key_link_type(__x)->_M_weight;
+        _key_link_type(__tmp)->_M_count = _key_link_type(__x)->_M_count;
       }
       assert(__tmp != NULL);
       __tmp->_M_left = 0;
@@ -738,6 +954,7 @@ protected:
     _base_ptr      _M_bp_leftmost; // allows header to be distinct from all other nodes during iteration
 
     _Compare       _M_key_compare;
+    double         _M_compact_threshold; // see set_compact_threshold
 
     _key_link_type _M_set_root(_key_link_type __x) {
       assert(_M_header != NULL); 
@@ -844,6 +1061,9 @@ private:
 
     _base_ptr _M_copy(_base_ptr __x, _base_ptr __p);
 
+    void _M_annotate_insert(_base_ptr __x, unsigned int __w);
+    void _M_reweight(_key_link_type __x);
+
     enum __partial_find_type {
       __lower_bound,
       __upper_bound,
@@ -864,13 +1084,15 @@ public:
     _b_trie() 
         : _Base(allocator_type()), 
           _M_node_count(0),
-          _M_key_compare()
+          _M_key_compare(),
+          _M_compact_threshold(0)
     { _empty_initialize(); }
 
     _b_trie(const _Compare& __comp)
       : _Base(allocator_type()), 
         _M_node_count(0), 
-        _M_key_compare(__comp)
+        _M_key_compare(__comp),
+        _M_compact_threshold(0)
       { _empty_initialize(); }
 
 
@@ -878,13 +1100,15 @@ public:
            const allocator_type __a)
       : _Base(__a), 
         _M_node_count(0), 
-        _M_key_compare(__comp)
+        _M_key_compare(__comp),
+        _M_compact_threshold(0)
       { _empty_initialize(); }
 
     _b_trie(const _self& __x) 
       : _Base(__x.get_allocator()), 
         _M_node_count(0),
-        _M_key_compare(__x._M_key_compare)
+        _M_key_compare(__x._M_key_compare),
+        _M_compact_threshold(__x._M_compact_threshold)
       { 
         if (__x._M_get_root() == 0) {
             _empty_initialize();
@@ -935,6 +1159,13 @@ public:
       std::swap(_M_node_count, __t._M_node_count);
       std::swap(_M_key_compare, __t._M_key_compare);
       std::swap(_M_bp_leftmost, __t._M_bp_leftmost);
+      std::swap(_M_compact_threshold, __t._M_compact_threshold);
+      _M_key_blocks.swap(__t._M_key_blocks);
+      _M_value_blocks.swap(__t._M_value_blocks);
+      std::swap(_M_free_keys, __t._M_free_keys);
+      std::swap(_M_free_values, __t._M_free_values);
+      std::swap(_M_free_key_count, __t._M_free_key_count);
+      std::swap(_M_free_value_count, __t._M_free_value_count);
     }
     
 public:
@@ -956,10 +1187,16 @@ public:
     void insert_equal(const value_type* __first, const value_type* __last);
 #endif // __STL_MEMBER_TEMPLATES
 
+    // erasing by key may compact the trie, see set_compact_threshold
     void erase(iterator __position);
     size_type erase(const key_type& __x);
     void erase(iterator __first, iterator __last);
     void erase(const key_type* __first, const key_type* __last);
+
+    // must be called after the weight of a value has been changed in place
+    // (e.g. a trie_map<_Key, unsigned int> assignment) so weighted_find can
+    // still prune on it
+    void reweight(iterator __position) { _M_reweight(_S_trie_parent(__position._M_node)); }
     
     void clear() {
       if (_M_node_count != 0) {
@@ -969,8 +1206,60 @@ public:
         _M_rightmost() = _M_header;
         _M_node_count = 0;
       }
+      _M_deallocate_blocks(0, _M_key_blocks.size(), 0, _M_value_blocks.size());
     }      
 
+    // lays the nodes out again in two blocks, one of key nodes and one of
+    // value nodes, depth first with each list of siblings together, so that
+    // a walk down the trie reads neighbouring nodes. Invalidates iterators.
+    void compact();
+
+    // the nodes of those blocks which have been erased and wait on a free
+    // list to be reused, and all the nodes the blocks hold
+    size_type free_node_count() const  { return _M_free_key_count + _M_free_value_count; }
+    size_type block_node_count() const { return _M_block_node_count(); }
+
+    // once more than this share of the nodes of the blocks are free, erasing
+    // by key compacts the trie, which invalidates iterators; 0, the default,
+    // leaves compacting to the caller
+    double compact_threshold() const { return _M_compact_threshold; }
+    void set_compact_threshold(double __r) { _M_compact_threshold = __r; }
+
+private:
+    void _M_compact_if_fragmented() {
+      if(_M_compact_threshold > 0 && free_node_count() > _M_compact_threshold * block_node_count()) {
+        compact();
+      }
+    }
+
+public:
+
+                                // operations between tries:
+    // each is one walk of the sibling lists of both tries together. 
+    // merge_unique and merge_equal move the nodes of __x in as insert_unique
+    // and insert_equal would place them and leave __x empty (values with a
+    // key already present are destroyed by merge_unique). For each key, 
+    // intersect keeps and subtract erases as many values as __x has.
+    void merge_unique(_self& __x) { _M_merge(__x, true); }
+    void merge_equal(_self& __x)  { _M_merge(__x, false); }
+    // insert_unique and insert_equal of every value of __x: as merge_unique
+    // and merge_equal, but copying the nodes and leaving __x as it was
+    void insert_unique(const _self& __x) { _M_merge_copy(__x, true); }
+    void insert_equal(const _self& __x)  { _M_merge_copy(__x, false); }
+    void intersect(const _self& __x);
+    void subtract(const _self& __x);
+
+private:
+    void _M_merge(_self& __x, bool __fUnique);
+    void _M_merge_children(_base_ptr __p, _base_ptr __x, bool __fUnique);
+    void _M_merge_copy(const _self& __x, bool __fUnique);
+    void _M_merge_copy_children(_base_ptr __p, _base_ptr __x, bool __fUnique);
+    _base_ptr _M_copy_subtrie(_base_ptr __x);
+    void _M_intersect_children(_base_ptr __p, _base_ptr __x);
+    void _M_subtract_children(_base_ptr __p, _base_ptr __x);
+    void _M_relink_children(_base_ptr __p, const std::vector<_base_ptr>& __rgChildren);
+    void _M_reset_ends();
+
 public:
                                 // set operations:
     iterator find(const key_type& __x);
@@ -990,6 +1279,18 @@ public:
 #endif
 
     size_type count(const key_type& __x) const;
+    // number of values whose keys begin with __x
+    size_type count_prefix(const key_type& __x) const;
+    // number of values whose keys are less than __x, so for a unique key
+    // in the trie it is a dense id from 0 to size()-1
+    size_type rank(const key_type& __x) const;
+    // the value with rank __n (end() if __n >= size())
+    iterator select(size_type __n);
+    const_iterator select(size_type __n) const;
+    // splits the values into at most __n disjoint ranges [first, last), in
+    // order and nearly equal in size, so each can be given to its own thread
+    std::vector< std::pair<iterator, iterator> > partition(size_type __n);
+    std::vector< std::pair<const_iterator, const_iterator> > partition(size_type __n) const;
 #ifdef __STL_MEMBER_TEMPLATES
     template <class _InputIterator>
     size_type count(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) const;
@@ -1062,6 +1363,69 @@ public:
     const_iterator find_if_prefix(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) const;
 #endif
 
+    // in one walk down the trie, the (first) value of every prefix of the 
+    // key which has one, shortest first
+#ifdef __STL_MEMBER_TEMPLATES
+    template <class _InputIterator>
+    std::vector<const_iterator> find_prefixes(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) const;
+#else
+    std::vector<const_iterator> find_prefixes(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) const;
+#endif
+
+
+    // traversal
+public:
+    // calls __f(__first, __last, __v) for every value __v in order, where 
+    // [__first, __last) are the sub keys of its key. They point into one 
+    // path buffer, which only holds them for the length of the call. This 
+    // is one preorder walk with an explicit stack and builds no keys, so it
+    // is much cheaper than incrementing an iterator from begin() to end().
+    template <class _Visitor>
+    _Visitor for_each(_Visitor __f) 
+    { _M_for_each<_Visitor, reference>(__f); return __f; }
+    template <class _Visitor>
+    _Visitor for_each(_Visitor __f) const 
+    { _M_for_each<_Visitor, const_reference>(__f); return __f; }
+
+    // true if __x holds equal values in the same order, found in one walk 
+    // of both tries together (see operator==)
+    bool equal_values(const _self& __x) const;
+
+private:
+    template <class _Visitor, class _Ref>
+    void _M_for_each(_Visitor& __f) const;
+
+    // completion
+public:
+    // the __n heaviest values whose keys begin with __x, heaviest first and
+    // equal weights in key order
+    std::vector< iterator > complete(const key_type& __x, size_type __n);
+    std::vector< const_iterator > complete(const key_type& __x, size_type __n) const;
+
+private:
+    _key_link_type _M_prefix_key(const key_type& __x) const;
+    _base_ptr _M_subtrie(const key_type& __x) const;
+    _base_ptr _M_select(size_type __n) const;
+    std::vector<_base_ptr> _M_partition(size_type __n) const;
+    std::vector< _base_ptr > _M_complete(const key_type& __x, size_type __n) const;
+
+    // pattern matching
+public:
+    // values whose keys match __pattern, in which ? matches any sub key, 
+    // * any run of sub keys, [abc] [a-z] [^abc] a class of sub keys and \ 
+    // makes the next sub key literal
+    std::vector< iterator > pattern_find(const key_type& __pattern);
+    std::vector< const_iterator > pattern_find(const key_type& __pattern) const;
+
+private:
+    typedef __pattern_element<sub_key_type> _pattern_element;
+
+    std::vector<_pattern_element> _M_compile_pattern(const key_type& __pattern) const;
+    size_t _M_class_end(const std::vector<sub_key_type>& __rgSubKeys, size_t __i) const;
+    bool _M_pattern_match(const _pattern_element& __e, const sub_key_type& __k) const;
+    void _M_pattern_closure(const std::vector<_pattern_element>& __rgElements,
+                            std::vector<unsigned int>& __rgStates) const;
+    std::vector< _base_ptr > _M_pattern_find(const key_type& __pattern) const;
 
     // approximate string matching
 public:
@@ -1075,6 +1439,46 @@ public:
     std::vector< const_iterator > best_find(const key_type& __x, 
                                               unsigned int __k=TRIE_INFINITY) const;
 
+    // the __n best values within __k edits, ordered by distance and then by
+    // weight (heaviest first). __n == 0 returns every value within __k edits.
+    std::vector< iterator > weighted_find(const key_type& __x, 
+                                            unsigned int __k=1, size_type __n=0);
+    std::vector< const_iterator > weighted_find(const key_type& __x, 
+                                                  unsigned int __k=1, size_type __n=0) const;
+
+    // every pair of values, one from this trie and one from __x, whose keys
+    // are within __k edits, ordered by the first value and then by distance.
+    // Joining a trie with itself gives each pair once.
+    typedef __approximate_pair<const_iterator> approximate_pair;
+    std::vector< approximate_pair > approximate_join(const _b_trie& __x, 
+                                                     unsigned int __k=1) const;
+
+private:
+    // key nodes of the other trie (the header for the empty key) whose keys
+    // are within the cutoff of the current key, and their distances
+    typedef std::map<_base_ptr, unsigned int> _active_set;
+
+    struct _approximate_pair_less {
+      _Compare _M_key_compare;
+      _approximate_pair_less(const _Compare& __comp) : _M_key_compare(__comp) {}
+      bool operator()(const approximate_pair& __x, const approximate_pair& __y) const {
+        if(__x.distance != __y.distance) {
+          return __x.distance < __y.distance;
+        }
+        const key_type& __xKey = _KeyOfValue()(*__x.second);
+        const key_type& __yKey = _KeyOfValue()(*__y.second);
+        return std::lexicographical_compare(_KeyBegin()(__xKey), _KeyEnd()(__xKey), 
+                                            _KeyBegin()(__yKey), _KeyEnd()(__yKey), 
+                                            _M_key_compare);
+      }
+    };
+
+    static void _S_join_update(_active_set& __S, _base_ptr __x, unsigned int __d);
+    void _M_join_closure(_active_set& __S, unsigned int __k) const;
+    void _M_join_step(const _active_set& __S, const _active_set* __pSParent, 
+                      const sub_key_type* __pkParent, const sub_key_type& __k, 
+                      unsigned int __kCutoff, _active_set& __SNext) const;
+
 private:
     unsigned int __edit_distance(const _Key& __P, 
                                  _key_link_type __W, 
@@ -1089,8 +1493,11 @@ private:
                                   std::vector< std::vector<unsigned int> > & __DT) const;
 #endif
 
+    unsigned int __subtrie_distance(const std::vector< std::vector<unsigned int> >& __DT,
+                                    unsigned int __i /*level*/) const;
+
     std::vector< _key_link_type > __approximate_match(const key_type& __P, 
-                                bool __fBestCase, unsigned int __k) const;
+                                bool __fBestCase, unsigned int __k, size_type __n = 0) const;
 };
 
 
@@ -1101,7 +1508,7 @@ operator==(const B_TRIE& __x,
            const B_TRIE& __y) 
 {
   return  __x.size() == __y.size() && 
-          equal(__x.begin(), __x.end(), __y.begin());
+          __x.equal_values(__y);
 }
 
 TRIE_TEMPLATE 
@@ -1161,6 +1568,7 @@ B_TRIE& B_TRIE::operator=(const B_TRIE& __x)
     clear();
     _M_node_count = 0;
     _M_key_compare = __x._M_key_compare;
+    _M_compact_threshold = __x._M_compact_threshold;
     if (__x._M_get_root() == 0) {
       _M_set_root(_base_ptr(0));
       _M_leftmost() = _M_header;
@@ -1353,6 +1761,9 @@ B_TRIE::_M_insert(bool __fInsertUnique /*allow only one value per key?*/,
     }
   }
 
+  if(__inserted) {
+    _M_annotate_insert(__j._M_node, __value_weight<_Value>()(__v));
+  }
   return _STD pair<iterator, bool> (__j, __inserted);
 }
 
@@ -1427,6 +1838,14 @@ B_TRIE::erase(iterator __position)
   bool __fErasableNode;
   bool __fIsEdge = true;
 
+  // find the closest key which will survive the erase; its weight may drop
+  _base_ptr __nodeW = __position._M_node;
+  _key_link_type __survivor = _S_trie_parent(__nodeW);
+  while(__survivor != 0 && _S_left(__survivor) == __nodeW && _S_right(__nodeW) == 0) {
+    __nodeW = __survivor;
+    __survivor = _S_trie_parent(__survivor);
+  }
+
   if(_S_left(__position._M_node) != 0) {
     assert(false); // this should be the value so this should never happen!
   }
@@ -1487,6 +1906,10 @@ B_TRIE::erase(iterator __position)
       _M_erase(__fIsEdge, _key_link_type(__position._M_node));
     }
   }
+  for(_key_link_type __y = __survivor; __y != 0; __y = _S_trie_parent(__y)) {
+    --__y->_M_count;
+  }
+  _M_reweight(__survivor);
   assert(_M_get_root() == 0 || _M_leftmost() == _S_minimum(_M_get_root()));
   assert(_M_get_root() == 0 || _M_rightmost() == _S_maximum(_M_get_root()));
   assert(_M_get_root() != 0 || _M_leftmost() == _M_header);
@@ -1500,6 +1923,7 @@ B_TRIE::erase(const key_type& __x)
   std::pair<iterator, iterator> __p = equal_range(__x);
   size_type __n = std::distance(__p.first, __p.second);
   erase(__p.first, __p.second);
+  _M_compact_if_fragmented();
   return __n;
 }
 
@@ -1541,6 +1965,121 @@ B_TRIE::_M_copy(_base_ptr __x, _base_ptr __p)
   return __top;
 }
 
+TRIE_TEMPLATE 
+void 
+B_TRIE::compact() 
+{
+  const size_t __cOldKeyBlocks = _M_key_blocks.size();
+  const size_t __cOldValueBlocks = _M_value_blocks.size();
+  if(_M_get_root() == 0) {
+    _M_deallocate_blocks(0, __cOldKeyBlocks, 0, __cOldValueBlocks);
+    return;
+  }
+
+  // the nodes in the order they will be laid out: each list of siblings,
+  // then the children of each of them in turn. A node's parent (the node
+  // it is the left or right link of) is kept by its index.
+  const size_type __npos = size_type(-1);
+  std::vector<_base_ptr> __rgNodes;
+  std::vector<size_type> __rgParents;
+  std::vector<std::pair<_base_ptr, size_type> > __stack(1, std::make_pair(_M_get_root(), __npos));
+  size_type __cKeys = 0;
+  while(!__stack.empty()) {
+    const std::pair<_base_ptr, size_type> __chain = __stack.back();
+    __stack.pop_back();
+    const size_type __iFirst = __rgNodes.size();
+    size_type __iParent = __chain.second;
+    for(_base_ptr __x = __chain.first; __x != 0; __x = _S_right(__x)) {
+      __rgNodes.push_back(__x);
+      __rgParents.push_back(__iParent);
+      __iParent = __rgNodes.size() - 1;
+    }
+    for(size_type __i = __rgNodes.size(); __i != __iFirst; --__i) {
+      if(_S_edge(__rgNodes[__i - 1]) != _S_b_trie_edge) {
+        ++__cKeys;
+        __stack.push_back(std::make_pair(_S_left(__rgNodes[__i - 1]), __i - 1));
+      }
+    }
+  }
+
+  _key_link_type __rgKeys = 0;
+  _value_link_type __rgValues = 0;
+  std::vector<_base_ptr> __rgNew;
+  _key_link_type __k = 0;
+  _value_link_type __v = 0;
+  try {
+    __rgKeys = __k = _M_allocate_key_block(__cKeys);
+    __rgValues = __v = _M_allocate_value_block(__rgNodes.size() - __cKeys);
+    __rgNew.resize(__rgNodes.size());
+    for(size_type __i = 0; __i != __rgNodes.size(); ++__i) {
+      _base_ptr __x = __rgNodes[__i];
+      if(_S_edge(__x) == _S_b_trie_edge) {
+        _M_construct_value(__v, _S_value(__x));
+#if _DEBUG
+        __v->_debugfIsEdge = true;
+#endif
+        __rgNew[__i] = __v++;
+      }
+      else {
+        _M_construct_key(__k, _S_key(__x));
+#if _DEBUG
+        __k->_debugfIsEdge = false;
+#endif
+        __k->_M_weight = _key_link_type(__x)->_M_weight;
+        __k->_M_count = _key_link_type(__x)->_M_count;
+        __rgNew[__i] = __k++;
+      }
+      __rgNew[__i]->_M_left = 0;
+      __rgNew[__i]->_M_right = 0;
+    }
+  }
+  catch(...) {
+    // the trie is left as it was
+    while(__k != __rgKeys) {
+      _M_destroy_key(--__k);
+    }
+    while(__v != __rgValues) {
+      _M_destroy_value(--__v);
+    }
+    // whichever of the new blocks were allocated
+    _M_deallocate_blocks(__cOldKeyBlocks, _M_key_blocks.size(), __cOldValueBlocks, _M_value_blocks.size());
+    throw;
+  }
+
+  // link the new nodes as the old ones are, then let the old ones go
+  for(size_type __i = 0; __i != __rgNodes.size(); ++__i) {
+    if(__rgParents[__i] == __npos) {
+      __rgNew[__i]->_M_parent = _M_header;
+    }
+    else {
+      _base_ptr __p = __rgNew[__rgParents[__i]];
+      __rgNew[__i]->_M_parent = __p;
+      if(_S_left(__rgNodes[__rgParents[__i]]) == __rgNodes[__i]) {
+        __p->_M_left = __rgNew[__i];
+      }
+      else {
+        __p->_M_right = __rgNew[__i];
+      }
+    }
+  }
+  for(size_type __i = 0; __i != __rgNodes.size(); ++__i) {
+    _base_ptr __x = __rgNodes[__i];
+    if(_S_edge(__x) == _S_b_trie_edge) {
+      _M_destroy_value(_value_link_type(__x));
+      _M_deallocate_value_node(_value_link_type(__x));
+    }
+    else {
+      _M_destroy_key(_key_link_type(__x));
+      _M_deallocate_key_node(_key_link_type(__x));
+    }
+  }
+  _M_deallocate_blocks(0, __cOldKeyBlocks, 0, __cOldValueBlocks);
+
+  _M_set_root(__rgNew[0]);
+  _M_leftmost() = _S_minimum(_M_get_root());
+  _M_rightmost() = _S_maximum(_M_get_root());
+}
+
 TRIE_TEMPLATE 
 void 
 B_TRIE::_M_erase(bool __fIsEdge, _base_ptr __x) 
@@ -1559,114 +2098,516 @@ B_TRIE::_M_erase(bool __fIsEdge, _base_ptr __x)
   }
 }
 
+// counts the new value __x in the keys above it and raises their weight to 
+// at least that of the value, __w
 TRIE_TEMPLATE 
 void 
-B_TRIE::erase(iterator __first, iterator __last) 
+B_TRIE::_M_annotate_insert(_base_ptr __x, unsigned int __w) 
 {
-  if (__first == begin() && __last == end()) {
-    clear();
-  }
-  else {
-    while (__first != __last) {
-      erase(__first++);
+  for(_key_link_type __y = _S_trie_parent(__x); __y != 0; __y = _S_trie_parent(__y)) {
+    ++__y->_M_count;
+    if(__y->_M_weight < __w) {
+      __y->_M_weight = __w;
     }
   }
 }
 
+// recalculates the weight of __x and of the keys above it from their children
 TRIE_TEMPLATE 
 void 
-B_TRIE::erase(const key_type* __first, const key_type* __last) 
+B_TRIE::_M_reweight(_key_link_type __x) 
 {
-  while (__first != __last) {
-    erase(*__first++);
+  while(__x != 0) {
+    unsigned int __w = 0;
+    for(_base_ptr __y = _S_left(__x); __y != 0; __y = _S_right(__y)) {
+      unsigned int __wT = (_S_edge(__y) == _S_b_trie_edge) ? 
+                          __value_weight<_Value>()(_S_value(__y)) : 
+                          _key_link_type(__y)->_M_weight;
+      __w = std::max<unsigned int>(__w, __wT);
+    }
+    if(__w == __x->_M_weight) {
+      break; // nothing above can change either
+    }
+    __x->_M_weight = __w;
+    __x = _S_trie_parent(__x);
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Operations between tries
+//
+
 TRIE_TEMPLATE 
-typename B_TRIE::iterator 
-B_TRIE::find(const key_type& __k) 
+void 
+B_TRIE::intersect(const _self& __x) 
 {
-  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
-  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
-
-  return find(__itKeyBegin, __itKeyEnd);
+  if(&__x != this) {
+    _M_intersect_children(_M_header, __x._M_get_root());
+    _M_reset_ends();
+  }
 }
 
 TRIE_TEMPLATE 
-typename B_TRIE::const_iterator 
-B_TRIE::find(const key_type& __k) const 
+void 
+B_TRIE::subtract(const _self& __x) 
 {
-  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
-  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
-
-  return find(__itKeyBegin, __itKeyEnd);
+  if(&__x == this) {
+    clear();
+  }
+  else {
+    _M_subtract_children(_M_header, __x._M_get_root());
+    _M_reset_ends();
+  }
 }
 
 TRIE_TEMPLATE 
-#ifdef __STL_MEMBER_TEMPLATES
-  template<class _InputIterator>
-  typename B_TRIE::iterator 
-  B_TRIE::find(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) 
-#else
-  typename B_TRIE::iterator 
-  B_TRIE::find(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) 
-#endif
+void 
+B_TRIE::_M_merge(_self& __x, bool __fUnique) 
 {
-  return _M_partial_find(__itKeyBegin, __itKeyEnd, __find);
-}
+  if(&__x == this || __x._M_get_root() == 0) {
+    return;
+  }
+  _base_ptr __xRoot = __x._M_get_root();
+  __x._empty_initialize();
+  __x._M_node_count = 0;
+  // the nodes moved in may be in blocks of __x, which go with them
+  _M_key_blocks.insert(_M_key_blocks.end(), __x._M_key_blocks.begin(), __x._M_key_blocks.end());
+  _M_value_blocks.insert(_M_value_blocks.end(), __x._M_value_blocks.begin(), __x._M_value_blocks.end());
+  __x._M_key_blocks.clear();
+  __x._M_value_blocks.clear();
+  while(__x._M_free_keys != 0) {
+    _key_link_type __k = __x._M_free_keys;
+    __x._M_free_keys = (_key_link_type) __k->_M_right;
+    __k->_M_right = _M_free_keys;
+    _M_free_keys = __k;
+  }
+  while(__x._M_free_values != 0) {
+    _value_link_type __v = __x._M_free_values;
+    __x._M_free_values = (_value_link_type) __v->_M_right;
+    __v->_M_right = _M_free_values;
+    _M_free_values = __v;
+  }
+  _M_free_key_count += __x._M_free_key_count;
+  _M_free_value_count += __x._M_free_value_count;
+  __x._M_free_key_count = 0;
+  __x._M_free_value_count = 0;
 
+  _M_merge_children(_M_header, __xRoot, __fUnique);
+  _M_reset_ends();
+}
 
+// Merges the child list of __x (from another trie) into the children of __p.
+// Both lists hold their values first and then their keys in order, so one 
+// pass over each decides where every node goes. Only keys in both lists are
+// visited below; every other subtrie is moved or kept whole.
 TRIE_TEMPLATE 
-#ifdef __STL_MEMBER_TEMPLATES
-  template<class _InputIterator>
-  typename B_TRIE::const_iterator 
-  B_TRIE::find(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd)  const 
-#else
-  typename B_TRIE::const_iterator 
-  B_TRIE::find(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd)  const 
-#endif
+void 
+B_TRIE::_M_merge_children(_base_ptr __p, _base_ptr __x, bool __fUnique) 
 {
-  return const_iterator(_M_partial_find(__itKeyBegin, __itKeyEnd, __find));
+  std::vector<_base_ptr> __rgChildren;
+  _base_ptr __a = _S_left(__p);
+  _base_ptr __b = __x;
+
+  // insert_equal puts a new value before those already there
+  const bool __fHasValue = (__a != 0 && _S_edge(__a) == _S_b_trie_edge);
+  while(__b != 0 && _S_edge(__b) == _S_b_trie_edge) {
+    _base_ptr __bNext = _S_right(__b);
+    if(__fUnique && (__fHasValue || !__rgChildren.empty())) {
+      destroy_node(true, __b);
+    }
+    else {
+      __rgChildren.push_back(__b);
+    }
+    __b = __bNext;
+  }
+  for(; __a != 0 && _S_edge(__a) == _S_b_trie_edge; __a = _S_right(__a)) {
+    __rgChildren.push_back(__a);
+  }
+
+  while(__a != 0 || __b != 0) {
+    if(__b == 0 || (__a != 0 && _M_key_compare(_S_key(__a), _S_key(__b)))) {
+      __rgChildren.push_back(__a);
+      __a = _S_right(__a);
+    }
+    else if(__a == 0 || _M_key_compare(_S_key(__b), _S_key(__a))) {
+      __rgChildren.push_back(__b);
+      __b = _S_right(__b);
+    }
+    else {
+      _base_ptr __aNext = _S_right(__a);
+      _base_ptr __bNext = _S_right(__b);
+      _M_merge_children(__a, _S_left(__b), __fUnique);
+      destroy_node(false, __b);
+      __rgChildren.push_back(__a);
+      __a = __aNext;
+      __b = __bNext;
+    }
+  }
+  _M_relink_children(__p, __rgChildren);
 }
 
 TRIE_TEMPLATE 
-typename B_TRIE::iterator 
-B_TRIE::find_if_prefix(const key_type& __k) 
+void 
+B_TRIE::_M_merge_copy(const _self& __x, bool __fUnique) 
 {
-  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
-  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
-
-  return find_if_prefix(__itKeyBegin, __itKeyEnd);
+  if(__x._M_get_root() == 0 || (&__x == this && __fUnique)) {
+    return;
+  }
+  if(&__x == this) {
+    _self __t(__x);
+    _M_merge(__t, false);
+    return;
+  }
+  try {
+    _M_merge_copy_children(_M_header, __x._M_get_root(), __fUnique);
+  }
+  catch(...) {
+    // what was copied in before the throw stays
+    _M_reset_ends();
+    throw;
+  }
+  _M_reset_ends();
 }
 
+// _M_merge_children for a child list __x that stays where it is: the nodes 
+// of __x that would be moved are cloned instead. If a clone throws, the 
+// children of __p are relinked with what has been copied so far.
 TRIE_TEMPLATE 
-typename B_TRIE::const_iterator 
-B_TRIE::find_if_prefix(const key_type& __k) const 
+void 
+B_TRIE::_M_merge_copy_children(_base_ptr __p, _base_ptr __x, bool __fUnique) 
 {
-  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
-  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+  std::vector<_base_ptr> __rgChildren;
+  _base_ptr __a = _S_left(__p);
+  _base_ptr __b = __x;
+
+  // reserved up front so that only the clones can throw below
+  size_t __n = 0;
+  for(_base_ptr __c = __a; __c != 0; __c = _S_right(__c)) {
+    ++__n;
+  }
+  for(_base_ptr __c = __b; __c != 0; __c = _S_right(__c)) {
+    ++__n;
+  }
+  __rgChildren.reserve(__n);
 
-  return find_if_prefix(__itKeyBegin, __itKeyEnd);
+  try {
+    const bool __fHasValue = (__a != 0 && _S_edge(__a) == _S_b_trie_edge);
+    for(; __b != 0 && _S_edge(__b) == _S_b_trie_edge; __b = _S_right(__b)) {
+      if(!__fUnique || (!__fHasValue && __rgChildren.empty())) {
+        __rgChildren.push_back(_M_clone_node(__b));
+      }
+    }
+    for(; __a != 0 && _S_edge(__a) == _S_b_trie_edge; __a = _S_right(__a)) {
+      __rgChildren.push_back(__a);
+    }
+
+    while(__a != 0 || __b != 0) {
+      if(__b == 0 || (__a != 0 && _M_key_compare(_S_key(__a), _S_key(__b)))) {
+        __rgChildren.push_back(__a);
+        __a = _S_right(__a);
+      }
+      else if(__a == 0 || _M_key_compare(_S_key(__b), _S_key(__a))) {
+        __rgChildren.push_back(_M_copy_subtrie(__b));
+        __b = _S_right(__b);
+      }
+      else {
+        _M_merge_copy_children(__a, _S_left(__b), __fUnique);
+        __rgChildren.push_back(__a);
+        __a = _S_right(__a);
+        __b = _S_right(__b);
+      }
+    }
+  }
+  catch(...) {
+    for(; __a != 0; __a = _S_right(__a)) {
+      __rgChildren.push_back(__a);
+    }
+    _M_relink_children(__p, __rgChildren);
+    throw;
+  }
+  _M_relink_children(__p, __rgChildren);
 }
 
+// clones the key or value __x and, for a key, everything below it
 TRIE_TEMPLATE 
-#ifdef __STL_MEMBER_TEMPLATES
-  template<class _InputIterator>
-  typename B_TRIE::iterator 
-  B_TRIE::find_if_prefix(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) 
-#else
-  typename B_TRIE::iterator 
-  B_TRIE::find_if_prefix(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) 
-#endif
+typename B_TRIE::_base_ptr 
+B_TRIE::_M_copy_subtrie(_base_ptr __x) 
 {
-  return _M_partial_find(__itKeyBegin, __itKeyEnd, __find_if_prefix);
+  _base_ptr __y = _M_clone_node(__x);
+  if(_S_left(__x) != 0) {
+    try {
+      _S_left(__y) = _M_copy(_S_left(__x), __y);
+    }
+    catch(...) {
+      destroy_node(false, __y);
+      throw;
+    }
+  }
+  return __y;
 }
 
+// Keeps the children of __p that have a match in the child list __x (from
+// another trie). A key left without children is erased.
 TRIE_TEMPLATE 
-#ifdef __STL_MEMBER_TEMPLATES
-  template<class _InputIterator>
-  typename B_TRIE::const_iterator 
-  B_TRIE::find_if_prefix(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd)  const 
+void 
+B_TRIE::_M_intersect_children(_base_ptr __p, _base_ptr __x) 
+{
+  std::vector<_base_ptr> __rgChildren;
+  _base_ptr __a = _S_left(__p);
+  _base_ptr __b = __x;
+
+  while(__a != 0 && _S_edge(__a) == _S_b_trie_edge) {
+    _base_ptr __aNext = _S_right(__a);
+    if(__b != 0 && _S_edge(__b) == _S_b_trie_edge) {
+      __rgChildren.push_back(__a);
+      __b = _S_right(__b);
+    }
+    else {
+      destroy_node(true, __a);
+    }
+    __a = __aNext;
+  }
+
+  while(__a != 0) {
+    _base_ptr __aNext = _S_right(__a);
+    while(__b != 0 && (_S_edge(__b) == _S_b_trie_edge || _M_key_compare(_S_key(__b), _S_key(__a)))) {
+      __b = _S_right(__b);
+    }
+    if(__b != 0 && !_M_key_compare(_S_key(__a), _S_key(__b))) {
+      _M_intersect_children(__a, _S_left(__b));
+      if(_S_left(__a) != 0) {
+        __rgChildren.push_back(__a);
+      }
+      else {
+        destroy_node(false, __a);
+      }
+    }
+    else {
+      _S_right(__a) = 0;
+      _M_erase(false, __a);
+    }
+    __a = __aNext;
+  }
+  _M_relink_children(__p, __rgChildren);
+}
+
+// Erases the children of __p that have a match in the child list __x (from
+// another trie). A key left without children is erased.
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_subtract_children(_base_ptr __p, _base_ptr __x) 
+{
+  std::vector<_base_ptr> __rgChildren;
+  _base_ptr __a = _S_left(__p);
+  _base_ptr __b = __x;
+
+  while(__a != 0 && _S_edge(__a) == _S_b_trie_edge) {
+    _base_ptr __aNext = _S_right(__a);
+    if(__b != 0 && _S_edge(__b) == _S_b_trie_edge) {
+      destroy_node(true, __a);
+      __b = _S_right(__b);
+    }
+    else {
+      __rgChildren.push_back(__a);
+    }
+    __a = __aNext;
+  }
+
+  while(__a != 0) {
+    _base_ptr __aNext = _S_right(__a);
+    while(__b != 0 && (_S_edge(__b) == _S_b_trie_edge || _M_key_compare(_S_key(__b), _S_key(__a)))) {
+      __b = _S_right(__b);
+    }
+    if(__b != 0 && !_M_key_compare(_S_key(__a), _S_key(__b))) {
+      _M_subtract_children(__a, _S_left(__b));
+      if(_S_left(__a) != 0) {
+        __rgChildren.push_back(__a);
+      }
+      else {
+        destroy_node(false, __a);
+      }
+    }
+    else {
+      __rgChildren.push_back(__a);
+    }
+    __a = __aNext;
+  }
+  _M_relink_children(__p, __rgChildren);
+}
+
+// makes __rgChildren the child list of __p (a key or the header) and 
+// recounts and reweighs __p from them
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_relink_children(_base_ptr __p, const std::vector<_base_ptr>& __rgChildren) 
+{
+  _base_ptr __first = __rgChildren.empty() ? 0 : __rgChildren.front();
+  if(__p == _M_header) {
+    _M_set_root(__first);
+  }
+  else {
+    _S_left(__p) = __first;
+  }
+
+  unsigned int __w = 0;
+  size_t __n = 0;
+  _base_ptr __prev = __p;
+  for(typename std::vector<_base_ptr>::const_iterator __it = __rgChildren.begin(); 
+      __it != __rgChildren.end(); 
+      ++__it) {
+    if(__prev != __p) {
+      _S_right(__prev) = *__it;
+    }
+    _S_parent(*__it) = __prev;
+    __prev = *__it;
+
+    if(_S_edge(*__it) == _S_b_trie_edge) {
+      __w = std::max<unsigned int>(__w, __value_weight<_Value>()(_S_value(*__it)));
+      ++__n;
+    }
+    else {
+      __w = std::max<unsigned int>(__w, _key_link_type(*__it)->_M_weight);
+      __n += _key_link_type(*__it)->_M_count;
+    }
+  }
+  if(__prev != __p) {
+    _S_right(__prev) = 0;
+  }
+
+  if(__p != _M_header) {
+    _key_link_type(__p)->_M_weight = __w;
+    _key_link_type(__p)->_M_count = __n;
+  }
+}
+
+// recounts the values and finds the leftmost and rightmost after the root 
+// list has been rebuilt
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_reset_ends() 
+{
+  if(_M_get_root() == 0) {
+    _empty_initialize();
+    _M_node_count = 0;
+    return;
+  }
+  _M_node_count = 0;
+  for(_base_ptr __x = _M_get_root(); __x != 0; __x = _S_right(__x)) {
+    _M_node_count += (_S_edge(__x) == _S_b_trie_edge) ? 1 : _key_link_type(__x)->_M_count;
+  }
+  _M_leftmost() = _S_minimum(_M_get_root());
+  _M_rightmost() = _S_maximum(_M_get_root());
+}
+
+TRIE_TEMPLATE 
+void 
+B_TRIE::erase(iterator __first, iterator __last) 
+{
+  if (__first == begin() && __last == end()) {
+    clear();
+  }
+  else {
+    while (__first != __last) {
+      erase(__first++);
+    }
+  }
+}
+
+TRIE_TEMPLATE 
+void 
+B_TRIE::erase(const key_type* __first, const key_type* __last) 
+{
+  while (__first != __last) {
+    erase(*__first++);
+  }
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::iterator 
+B_TRIE::find(const key_type& __k) 
+{
+  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
+  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+
+  return find(__itKeyBegin, __itKeyEnd);
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::const_iterator 
+B_TRIE::find(const key_type& __k) const 
+{
+  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
+  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+
+  return find(__itKeyBegin, __itKeyEnd);
+}
+
+TRIE_TEMPLATE 
+#ifdef __STL_MEMBER_TEMPLATES
+  template<class _InputIterator>
+  typename B_TRIE::iterator 
+  B_TRIE::find(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) 
+#else
+  typename B_TRIE::iterator 
+  B_TRIE::find(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) 
+#endif
+{
+  return _M_partial_find(__itKeyBegin, __itKeyEnd, __find);
+}
+
+
+TRIE_TEMPLATE 
+#ifdef __STL_MEMBER_TEMPLATES
+  template<class _InputIterator>
+  typename B_TRIE::const_iterator 
+  B_TRIE::find(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd)  const 
+#else
+  typename B_TRIE::const_iterator 
+  B_TRIE::find(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd)  const 
+#endif
+{
+  return const_iterator(_M_partial_find(__itKeyBegin, __itKeyEnd, __find));
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::iterator 
+B_TRIE::find_if_prefix(const key_type& __k) 
+{
+  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
+  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+
+  return find_if_prefix(__itKeyBegin, __itKeyEnd);
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::const_iterator 
+B_TRIE::find_if_prefix(const key_type& __k) const 
+{
+  typename _KeyIterator __itKeyBegin = _KeyBegin()(__k);
+  typename _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+
+  return find_if_prefix(__itKeyBegin, __itKeyEnd);
+}
+
+TRIE_TEMPLATE 
+#ifdef __STL_MEMBER_TEMPLATES
+  template<class _InputIterator>
+  typename B_TRIE::iterator 
+  B_TRIE::find_if_prefix(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) 
+#else
+  typename B_TRIE::iterator 
+  B_TRIE::find_if_prefix(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) 
+#endif
+{
+  return _M_partial_find(__itKeyBegin, __itKeyEnd, __find_if_prefix);
+}
+
+TRIE_TEMPLATE 
+#ifdef __STL_MEMBER_TEMPLATES
+  template<class _InputIterator>
+  typename B_TRIE::const_iterator 
+  B_TRIE::find_if_prefix(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd)  const 
 #else
   typename B_TRIE::const_iterator 
   B_TRIE::find_if_prefix(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd)  const 
@@ -1675,16 +2616,178 @@ TRIE_TEMPLATE
   return const_iterator(_M_partial_find(__itKeyBegin, __itKeyEnd, __find_if_prefix));
 }
 
+TRIE_TEMPLATE 
+#ifdef __STL_MEMBER_TEMPLATES
+  template<class _InputIterator>
+  std::vector<typename B_TRIE::const_iterator> 
+  B_TRIE::find_prefixes(const _InputIterator __itKeyBegin, const _InputIterator __itKeyEnd) const 
+#else
+  std::vector<typename B_TRIE::const_iterator> 
+  B_TRIE::find_prefixes(const _KeyIterator& __itKeyBegin, const _KeyIterator& __itKeyEnd) const 
+#endif
+{
+  std::vector<const_iterator> __rgValues;
+#ifdef __STL_MEMBER_TEMPLATES
+  _InputIterator __itKey = __itKeyBegin;
+#else
+  _KeyIterator __itKey = __itKeyBegin;
+#endif
+  _base_ptr __y = _M_get_root();
+
+  while (__y != 0) {
+    // the values are first among the children
+    if (_S_edge(__y) == _S_b_trie_edge) {
+      __rgValues.push_back(const_iterator(__y));
+    }
+    if (__itKey == __itKeyEnd) {
+      break;
+    }
+    while (__y != 0 && ((_S_edge(__y) == _S_b_trie_edge) || (_M_key_compare(_S_key(__y), *__itKey)))) {
+      __y = _S_right(__y);
+    }
+    if (__y == 0 || _M_key_compare(*__itKey, _S_key(__y))) {
+      break;
+    }
+    __y = _S_left(__y); // descend
+    ++__itKey;
+  }
+  return __rgValues;
+}
+
 TRIE_TEMPLATE 
 typename B_TRIE::size_type 
 B_TRIE::count(const key_type& __k) const 
 {
-  std::pair<const_iterator, const_iterator> __p = equal_range(__k);
-  size_type __n = std::distance(__p.first, __p.second);
+  // the values of a key are first among the children of its last sub key
+  size_type __n = 0;
+  for(_base_ptr __y = _M_subtrie(__k); __y != 0 && _S_edge(__y) == _S_b_trie_edge; __y = _S_right(__y)) {
+    ++__n;
+  }
+  return __n;
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::size_type 
+B_TRIE::count_prefix(const key_type& __k) const 
+{
+  _key_link_type __y = _M_prefix_key(__k);
+  if(__y == 0) {
+    return 0;
+  }
+  return (__y == _M_header) ? _M_node_count : __y->_M_count;
+}
 
+TRIE_TEMPLATE 
+typename B_TRIE::size_type 
+B_TRIE::rank(const key_type& __k) const 
+{
+  // everything to the left of the path to __k is less than __k
+  size_type __n = 0;
+  _base_ptr __y = _M_get_root();
+  _KeyIterator __itKey = _KeyBegin()(__k);
+  _KeyIterator __itKeyEnd = _KeyEnd()(__k);
+
+  for(; __y != 0 && __itKey != __itKeyEnd; ++__itKey) {
+    while (__y != 0 && ((_S_edge(__y) == _S_b_trie_edge) || (_M_key_compare(_S_key(__y), *__itKey)))) {
+      __n += (_S_edge(__y) == _S_b_trie_edge) ? 1 : _key_link_type(__y)->_M_count;
+      __y = _S_right(__y);
+    }
+    if (__y == 0 || _M_key_compare(*__itKey, _S_key(__y))) {
+      break;
+    }
+    __y = _S_left(__y); // descend
+  }
   return __n;
 }
 
+TRIE_TEMPLATE 
+typename B_TRIE::iterator 
+B_TRIE::select(size_type __n) 
+{
+  return iterator(_M_select(__n));
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::const_iterator 
+B_TRIE::select(size_type __n) const 
+{
+  return const_iterator(_M_select(__n));
+}
+
+TRIE_TEMPLATE 
+std::vector< std::pair<typename B_TRIE::iterator, typename B_TRIE::iterator> > 
+B_TRIE::partition(size_type __n) 
+{
+  std::vector<_base_ptr> __rgBounds = _M_partition(__n);
+  std::vector< std::pair<iterator, iterator> > __rgRanges;
+
+  for(size_t __i = 1; __i < __rgBounds.size(); ++__i) {
+    __rgRanges.push_back(std::make_pair(iterator(__rgBounds[__i-1]), iterator(__rgBounds[__i])));
+  }
+  return __rgRanges;
+}
+
+TRIE_TEMPLATE 
+std::vector< std::pair<typename B_TRIE::const_iterator, typename B_TRIE::const_iterator> > 
+B_TRIE::partition(size_type __n) const 
+{
+  std::vector<_base_ptr> __rgBounds = _M_partition(__n);
+  std::vector< std::pair<const_iterator, const_iterator> > __rgRanges;
+
+  for(size_t __i = 1; __i < __rgBounds.size(); ++__i) {
+    __rgRanges.push_back(std::make_pair(const_iterator(__rgBounds[__i-1]), const_iterator(__rgBounds[__i])));
+  }
+  return __rgRanges;
+}
+
+// The bounds of the ranges: the values of rank i*size()/__n, found from the 
+// value counts in the keys without visiting the values between them, and 
+// then the header.
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::_base_ptr > 
+B_TRIE::_M_partition(size_type __n) const 
+{
+  std::vector<_base_ptr> __rgBounds;
+  if(__n == 0 || _M_node_count == 0) {
+    return __rgBounds;
+  }
+  __n = std::min<size_type>(__n, _M_node_count);
+
+  for(size_type __i = 0; __i != __n; ++__i) {
+    // in two parts so that __i * _M_node_count cannot overflow
+    size_type __rank = (__i * (_M_node_count / __n)) + (__i * (_M_node_count % __n)) / __n;
+    __rgBounds.push_back(_M_select(__rank));
+  }
+  __rgBounds.push_back(_M_header);
+  return __rgBounds;
+}
+
+TRIE_TEMPLATE 
+typename B_TRIE::_base_ptr 
+B_TRIE::_M_select(size_type __n) const 
+{
+  if(__n >= _M_node_count) {
+    return _M_header;
+  }
+
+  _base_ptr __y = _M_get_root();
+  while(__y != 0) {
+    size_type __c = (_S_edge(__y) == _S_b_trie_edge) ? 1 : _key_link_type(__y)->_M_count;
+    if(__n >= __c) {
+      __n -= __c;
+      __y = _S_right(__y); // skip the whole subtrie
+    }
+    else if(_S_edge(__y) == _S_b_trie_edge) {
+      return __y;
+    }
+    else {
+      __y = _S_left(__y); // descend
+    }
+  }
+  assert(false); // the counts are wrong
+  return _M_header;
+}
+
 TRIE_TEMPLATE 
 #ifdef __STL_MEMBER_TEMPLATES
   template<class _InputIterator>
@@ -1877,8 +2980,14 @@ TRIE_TEMPLATE
     for(; __itKey != __itKeyEnd; ++__itKey) {
       __fFound = false;                          // default to not found ESA 12/22/97
       if(__x != 0) {
-        while (__x!= 0 && 
-          ((_S_edge(__x) == _S_b_trie_edge) || (_M_key_compare(_S_key(__x),*__itKey)))) { // less than subkey
+        while (__x!= 0) {
+          // the next sibling and the first child are fetched while this one
+          // is compared, so the next node is on its way whichever it is
+          __TRIE_PREFETCH(_S_right(__x));
+          __TRIE_PREFETCH(_S_left(__x));
+          if(!((_S_edge(__x) == _S_b_trie_edge) || (_M_key_compare(_S_key(__x),*__itKey)))) {
+            break; // not less than subkey
+          }
           __y = __x;
           __x = _S_right(__x);
         }
@@ -1953,6 +3062,391 @@ TRIE_TEMPLATE
   }
   return __j;
 }
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Completion
+//
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::iterator > 
+B_TRIE::complete(const key_type& __x, size_type __n)
+{
+  std::vector<_base_ptr>                      __rgNodes = _M_complete(__x, __n);
+  typename std::vector<_base_ptr>::iterator   __itrgNodes;
+  std::vector<iterator>                      __rgIt;
+
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::const_iterator > 
+B_TRIE::complete(const key_type& __x, size_type __n) const
+{
+  std::vector<_base_ptr>                      __rgNodes = _M_complete(__x, __n);
+  typename std::vector<_base_ptr>::iterator   __itrgNodes;
+  std::vector<const_iterator>                __rgIt;
+
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(const_iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
+
+// the node of the last sub key of __x, the header if __x is empty or 0 if 
+// __x isn't in the trie
+TRIE_TEMPLATE 
+typename B_TRIE::_key_link_type 
+B_TRIE::_M_prefix_key(const key_type& __x) const
+{
+  _key_link_type __z = _M_header;
+  _base_ptr __y = _M_get_root();
+  _KeyIterator __itKey = _KeyBegin()(__x);
+  _KeyIterator __itKeyEnd = _KeyEnd()(__x);
+
+  for(; __itKey != __itKeyEnd; ++__itKey) {
+    while (__y != 0 && ((_S_edge(__y) == _S_b_trie_edge) || (_M_key_compare(_S_key(__y), *__itKey)))) {
+      __y = _S_right(__y);
+    }
+    if (__y == 0 || _M_key_compare(*__itKey, _S_key(__y))) {
+      return 0;
+    }
+    __z = _key_link_type(__y);
+    __y = _S_left(__y); // descend
+  }
+  return __z;
+}
+
+// the first child of the last sub key of __x (0 if __x isn't in the trie)
+TRIE_TEMPLATE 
+typename B_TRIE::_base_ptr 
+B_TRIE::_M_subtrie(const key_type& __x) const
+{
+  _key_link_type __z = _M_prefix_key(__x);
+  return (__z == 0) ? 0 : _S_left(__z);
+}
+
+// Best first search on the weights of the keys: the heaviest node found so far
+// is expanded next, so a value leaves the queue only when nothing left can be
+// heavier. Only the subtries on the way to the __n results are opened. Nodes
+// of equal weight are taken in key order: a node's order is the number of
+// values of the subtrie before it, which its first child shares.
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::_base_ptr > 
+B_TRIE::_M_complete(const key_type& __x, size_type __n) const
+{
+  typedef __weighted_candidate<_base_ptr> _candidate;
+
+  std::vector<_base_ptr> __rgNodes;
+  std::priority_queue<_candidate, std::vector<_candidate>, std::greater<_candidate> > __queue;
+  _candidate __c;
+  __c._M_distance = 0;
+  __c._M_order = 0;
+
+  for(_base_ptr __y = _M_subtrie(__x); __y != 0; __y = _S_right(__y)) {
+    __c._M_weight = (_S_edge(__y) == _S_b_trie_edge) ? 
+                    __value_weight<_Value>()(_S_value(__y)) : 
+                    _key_link_type(__y)->_M_weight;
+    __c._M_node = __y;
+    __queue.push(__c);
+    __c._M_order += (_S_edge(__y) == _S_b_trie_edge) ? 1 : _key_link_type(__y)->_M_count;
+  }
+
+  while (!__queue.empty() && __rgNodes.size() < __n) {
+    _base_ptr __y = __queue.top()._M_node;
+    __c._M_order = __queue.top()._M_order;
+    __queue.pop();
+    if(_S_edge(__y) == _S_b_trie_edge) {
+      __rgNodes.push_back(__y);
+    }
+    else {
+      for(__y = _S_left(__y); __y != 0; __y = _S_right(__y)) {
+        __c._M_weight = (_S_edge(__y) == _S_b_trie_edge) ? 
+                        __value_weight<_Value>()(_S_value(__y)) : 
+                        _key_link_type(__y)->_M_weight;
+        __c._M_node = __y;
+        __queue.push(__c);
+        __c._M_order += (_S_edge(__y) == _S_b_trie_edge) ? 1 : _key_link_type(__y)->_M_count;
+      }
+    }
+  }
+  return __rgNodes;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Traversal
+//
+
+TRIE_TEMPLATE 
+template <class _Visitor, class _Ref>
+void 
+B_TRIE::_M_for_each(_Visitor& __f) const
+{
+  std::vector<sub_key_type> __path;   // the sub keys of the current key
+  std::vector<_base_ptr> __stack;     // the next sibling at each level
+
+  __stack.push_back(_M_get_root());
+  while(!__stack.empty()) {
+    _base_ptr __x = __stack.back();
+    if(__x == 0) {
+      __stack.pop_back();
+      if(!__stack.empty()) {
+        __path.pop_back();
+      }
+      continue;
+    }
+    __stack.back() = _S_right(__x);
+
+    if(_S_edge(__x) == _S_b_trie_edge) {
+      const sub_key_type* __first = __path.empty() ? 0 : &__path[0];
+      __f(__first, __first + __path.size(), static_cast<_Ref>(_S_value(__x)));
+    }
+    else {
+      __path.push_back(_S_key(__x));
+      __stack.push_back(_S_left(__x));
+    }
+  }
+}
+
+// Equal values mean equal keys, and a trie's shape follows from its keys, so
+// the two tries are walked in step and must match node for node.
+TRIE_TEMPLATE 
+bool 
+B_TRIE::equal_values(const _self& __x) const
+{
+  std::vector< std::pair<_base_ptr, _base_ptr> > __stack;
+
+  __stack.push_back(std::make_pair(_base_ptr(_M_get_root()), _base_ptr(__x._M_get_root())));
+  while(!__stack.empty()) {
+    _base_ptr __a = __stack.back().first;
+    _base_ptr __b = __stack.back().second;
+    if(__a == 0 || __b == 0) {
+      if(__a != __b) {
+        return false;
+      }
+      __stack.pop_back();
+      continue;
+    }
+    __stack.back() = std::make_pair(_S_right(__a), _S_right(__b));
+
+    if(_S_edge(__a) != _S_edge(__b)) {
+      return false;
+    }
+    if(_S_edge(__a) == _S_b_trie_edge) {
+      if(!(_S_value(__a) == _S_value(__b))) {
+        return false;
+      }
+    }
+    else {
+      if(_M_key_compare(_S_key(__a), _S_key(__b)) || _M_key_compare(_S_key(__b), _S_key(__a))) {
+        return false;
+      }
+      __stack.push_back(std::make_pair(_S_left(__a), _S_left(__b)));
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Pattern matching
+//
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::iterator > 
+B_TRIE::pattern_find(const key_type& __pattern)
+{
+  std::vector<_base_ptr>                      __rgNodes = _M_pattern_find(__pattern);
+  typename std::vector<_base_ptr>::iterator   __itrgNodes;
+  std::vector<iterator>                      __rgIt;
+
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::const_iterator > 
+B_TRIE::pattern_find(const key_type& __pattern) const
+{
+  std::vector<_base_ptr>                      __rgNodes = _M_pattern_find(__pattern);
+  typename std::vector<_base_ptr>::iterator   __itrgNodes;
+  std::vector<const_iterator>                __rgIt;
+
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(const_iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::_pattern_element > 
+B_TRIE::_M_compile_pattern(const key_type& __pattern) const
+{
+  const sub_key_type __star = sub_key_type('*');
+  const sub_key_type __any = sub_key_type('?');
+  const sub_key_type __escape = sub_key_type('\\');
+  const sub_key_type __open = sub_key_type('[');
+  const sub_key_type __negate = sub_key_type('^');
+  const sub_key_type __range = sub_key_type('-');
+
+  std::vector<sub_key_type> __rgSubKeys(_KeyBegin()(__pattern), _KeyEnd()(__pattern));
+  std::vector<_pattern_element> __rgElements;
+  _pattern_element __e;
+  size_t __j;
+
+  for(size_t __i = 0; __i != __rgSubKeys.size(); ++__i) {
+    __e._M_negate = false;
+    __e._M_ranges.clear();
+
+    if(__rgSubKeys[__i] == __star) {
+      if(!__rgElements.empty() && __rgElements.back()._M_type == _pattern_element::__star) {
+        continue; // ** is *
+      }
+      __e._M_type = _pattern_element::__star;
+    }
+    else if(__rgSubKeys[__i] == __any) {
+      __e._M_type = _pattern_element::__any;
+    }
+    else if(__rgSubKeys[__i] == __open && (__j = _M_class_end(__rgSubKeys, __i)) != __rgSubKeys.size()) {
+      __e._M_type = _pattern_element::__class;
+      __e._M_negate = (__rgSubKeys[__i+1] == __negate);
+      for(__i += __e._M_negate ? 2 : 1; __i != __j; ++__i) {
+        if(__i + 2 < __j && __rgSubKeys[__i+1] == __range) {
+          __e._M_ranges.push_back(std::make_pair(__rgSubKeys[__i], __rgSubKeys[__i+2]));
+          __i += 2;
+        }
+        else {
+          __e._M_ranges.push_back(std::make_pair(__rgSubKeys[__i], __rgSubKeys[__i]));
+        }
+      }
+    }
+    else {
+      if(__rgSubKeys[__i] == __escape && __i + 1 != __rgSubKeys.size()) {
+        ++__i;
+      }
+      __e._M_type = _pattern_element::__literal;
+      __e._M_ranges.push_back(std::make_pair(__rgSubKeys[__i], __rgSubKeys[__i]));
+    }
+    __rgElements.push_back(__e);
+  }
+  return __rgElements;
+}
+
+// index of the ] closing the class opened at __i, or the pattern length if 
+// the [ opens no class. A ] straight after the [ or [^ is a member.
+TRIE_TEMPLATE 
+size_t 
+B_TRIE::_M_class_end(const std::vector<sub_key_type>& __rgSubKeys, size_t __i) const
+{
+  ++__i;
+  if(__i != __rgSubKeys.size() && __rgSubKeys[__i] == sub_key_type('^')) {
+    ++__i;
+  }
+  if(__i != __rgSubKeys.size()) {
+    ++__i;
+  }
+  return std::find(__rgSubKeys.begin() + __i, __rgSubKeys.end(), sub_key_type(']')) - __rgSubKeys.begin();
+}
+
+TRIE_TEMPLATE 
+inline bool 
+B_TRIE::_M_pattern_match(const _pattern_element& __e, const sub_key_type& __k) const
+{
+  switch(__e._M_type) {
+    case _pattern_element::__any:
+    case _pattern_element::__star:
+      return true;
+    case _pattern_element::__literal:
+      return !_M_key_compare(__e._M_ranges[0].first, __k) && !_M_key_compare(__k, __e._M_ranges[0].first);
+    default:
+      break;
+  }
+  for(typename std::vector< std::pair<sub_key_type, sub_key_type> >::const_iterator __it = __e._M_ranges.begin(); 
+      __it != __e._M_ranges.end(); 
+      ++__it) {
+    if(!_M_key_compare(__k, __it->first) && !_M_key_compare(__it->second, __k)) {
+      return !__e._M_negate;
+    }
+  }
+  return __e._M_negate;
+}
+
+// adds the states reachable without consuming a sub key (past stars) and 
+// sorts the states. State i is waiting on element i; the last state accepts.
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_pattern_closure(const std::vector<_pattern_element>& __rgElements,
+                           std::vector<unsigned int>& __rgStates) const
+{
+  for(size_t __i = 0; __i != __rgStates.size(); ++__i) {
+    unsigned int __s = __rgStates[__i];
+    if(__s < __rgElements.size() && __rgElements[__s]._M_type == _pattern_element::__star &&
+       std::find(__rgStates.begin(), __rgStates.end(), __s + 1) == __rgStates.end()) {
+      __rgStates.push_back(__s + 1);
+    }
+  }
+  std::sort(__rgStates.begin(), __rgStates.end());
+}
+
+// The pattern is run as an NFA alongside a preorder walk of the trie. Each 
+// key moves every state of its parent's state set; a subtrie whose state 
+// set is empty cannot match and is not visited.
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::_base_ptr > 
+B_TRIE::_M_pattern_find(const key_type& __pattern) const
+{
+  typedef std::pair< _base_ptr, std::vector<unsigned int> > _frame; // next sibling to visit and the states of the list
+
+  std::vector<_base_ptr> __rgNodes;
+  std::vector<_pattern_element> __rgElements = _M_compile_pattern(__pattern);
+  const unsigned int __accept = static_cast<unsigned int>(__rgElements.size());
+  std::vector<_frame> __stack;
+  std::vector<unsigned int> __rgStates;
+
+  __rgStates.push_back(0);
+  _M_pattern_closure(__rgElements, __rgStates);
+  __stack.push_back(_frame(_M_get_root(), __rgStates));
+
+  while(!__stack.empty()) {
+    _base_ptr __x = __stack.back().first;
+    if(__x == 0) {
+      __stack.pop_back();
+      continue;
+    }
+    __stack.back().first = _S_right(__x);
+
+    if(_S_edge(__x) == _S_b_trie_edge) {
+      if(std::binary_search(__stack.back().second.begin(), __stack.back().second.end(), __accept)) {
+        __rgNodes.push_back(__x);
+      }
+      continue;
+    }
+
+    __rgStates.clear();
+    for(std::vector<unsigned int>::const_iterator __it = __stack.back().second.begin(); 
+        __it != __stack.back().second.end(); 
+        ++__it) {
+      if(*__it == __accept || !_M_pattern_match(__rgElements[*__it], _S_key(__x))) {
+        continue;
+      }
+      unsigned int __s = (__rgElements[*__it]._M_type == _pattern_element::__star) ? *__it : *__it + 1;
+      if(std::find(__rgStates.begin(), __rgStates.end(), __s) == __rgStates.end()) {
+        __rgStates.push_back(__s);
+      }
+    }
+    if(!__rgStates.empty()) {
+      _M_pattern_closure(__rgElements, __rgStates);
+      __stack.push_back(_frame(_S_left(__x), __rgStates));
+    }
+  }
+  return __rgNodes;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Approximate string matching
@@ -2028,12 +3522,235 @@ B_TRIE::best_find(const key_type& __x, unsigned int __k) const
   return __rgIt;
 }
 
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::iterator >
+B_TRIE::weighted_find(const key_type& __x, unsigned int __k, size_type __n)
+{
+  std::vector<_key_link_type>                      __rgNodes;
+  typename std::vector<_key_link_type>::iterator   __itrgNodes;
+  std::vector<iterator>                           __rgIt;
+
+  __rgNodes = __approximate_match(__x, false, __k, (__n == 0) ? size_type(-1) : __n); 
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
+
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::const_iterator >
+B_TRIE::weighted_find(const key_type& __x, unsigned int __k, size_type __n) const
+{
+  std::vector<_key_link_type>                        __rgNodes;
+  typename std::vector<_key_link_type>::iterator     __itrgNodes;
+  std::vector<const_iterator>                       __rgIt;
+
+  __rgNodes = __approximate_match(__x, false, __k, (__n == 0) ? size_type(-1) : __n); 
+  for(__itrgNodes = __rgNodes.begin(); __itrgNodes != __rgNodes.end(); ++__itrgNodes) {
+    __rgIt.push_back(const_iterator(*__itrgNodes));
+  }
+  return __rgIt;
+}
 
+TRIE_TEMPLATE 
+inline void 
+B_TRIE::_S_join_update(_active_set& __S, _base_ptr __x, unsigned int __d)
+{
+  typename _active_set::iterator __it = __S.find(__x);
+  if(__it == __S.end()) {
+    __S.insert(std::make_pair(__x, __d));
+  }
+  else if(__d < __it->second) {
+    __it->second = __d;
+  }
+}
+
+// adds the keys reachable by inserting sub keys, nearest first so each key
+// is expanded once at its final distance
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_join_closure(_active_set& __S, unsigned int __k) const
+{
+  std::vector< std::vector<_base_ptr> > __rgBuckets(__k + 1);
+  typename _active_set::iterator __it;
+
+  for(__it = __S.begin(); __it != __S.end(); ++__it) {
+    __rgBuckets[__it->second].push_back(__it->first);
+  }
+  for(unsigned int __d = 0; __d < __k; ++__d) {
+    for(size_t __i = 0; __i != __rgBuckets[__d].size(); ++__i) {
+      _base_ptr __x = __rgBuckets[__d][__i];
+      if(__S[__x] != __d) {
+        continue;
+      }
+      for(_base_ptr __y = _S_left(__x); __y != 0; __y = _S_right(__y)) {
+        if(_S_edge(__y) == _S_b_trie_edge) {
+          continue;
+        }
+        __it = __S.find(__y);
+        if(__it == __S.end() || __it->second > __d + 1) {
+          __S[__y] = __d + 1;
+          __rgBuckets[__d + 1].push_back(__y);
+        }
+      }
+    }
+  }
+}
+
+// The active set of the current key extended by __k, from the active sets
+// of the current key and of its parent (for transpositions, with __kParent
+// the current key's last sub key).
+TRIE_TEMPLATE 
+void 
+B_TRIE::_M_join_step(const _active_set& __S, const _active_set* __pSParent, 
+                     const sub_key_type* __pkParent, const sub_key_type& __k, 
+                     unsigned int __kCutoff, _active_set& __SNext) const
+{
+  typename _active_set::const_iterator __it;
+
+  for(__it = __S.begin(); __it != __S.end(); ++__it) {
+    unsigned int __d = __it->second;
+    if(__d + 1 <= __kCutoff) {
+      _S_join_update(__SNext, __it->first, __d + 1);    // delete __k
+    }
+    for(_base_ptr __y = _S_left(__it->first); __y != 0; __y = _S_right(__y)) {
+      if(_S_edge(__y) == _S_b_trie_edge) {
+        continue;
+      }
+      unsigned int __s = (!_M_key_compare(_S_key(__y), __k) && !_M_key_compare(__k, _S_key(__y))) ? 0 : 1;
+      if(__d + __s <= __kCutoff) {
+        _S_join_update(__SNext, __y, __d + __s);        // match or replace
+      }
+    }
+  }
+
+  if(__pSParent != 0) {
+    for(__it = __pSParent->begin(); __it != __pSParent->end(); ++__it) {
+      if(__it->second + 1 > __kCutoff) {
+        continue;
+      }
+      for(_base_ptr __y = _S_left(__it->first); __y != 0; __y = _S_right(__y)) {
+        if(_S_edge(__y) == _S_b_trie_edge || 
+           _M_key_compare(_S_key(__y), __k) || _M_key_compare(__k, _S_key(__y))) {
+          continue;
+        }
+        for(_base_ptr __z = _S_left(__y); __z != 0; __z = _S_right(__z)) {
+          if(_S_edge(__z) != _S_b_trie_edge && 
+             !_M_key_compare(_S_key(__z), *__pkParent) && !_M_key_compare(*__pkParent, _S_key(__z))) {
+            _S_join_update(__SNext, __z, __it->second + 1);  // transpose
+          }
+        }
+      }
+    }
+  }
+
+  _M_join_closure(__SNext, __kCutoff);                  // insert
+}
+
+// Both tries are walked together: this trie in preorder and, for each of 
+// its keys, the set of keys in __x within __k edits (see _active_set), built 
+// from the sets of its parent and grandparent. A common prefix is matched 
+// once for all the words sharing it, and a key whose set is empty has no 
+// matches below it.
+TRIE_TEMPLATE 
+std::vector< typename B_TRIE::approximate_pair > 
+B_TRIE::approximate_join(const _b_trie& __x, unsigned int __k) const
+{
+  std::vector<approximate_pair> __rgPairs;
+  const bool __fSelf = (&__x == this);
+  std::set<_base_ptr> __visited; // values already joined, for a self join
+
+  // a stack of the siblings left to visit at each level, the active set of 
+  // that level and the sub key leading to it
+  std::vector<_base_ptr> __stackNext;
+  std::vector<_active_set> __stackActive;
+  std::vector<sub_key_type> __stackKey;
+
+  __stackNext.push_back(_M_get_root());
+  __stackActive.push_back(_active_set());
+  __stackActive.back().insert(std::make_pair(_base_ptr(__x._M_header), 0u));
+  _M_join_closure(__stackActive.back(), __k);
+  __stackKey.push_back(sub_key_type());
+
+  while(!__stackNext.empty()) {
+    _base_ptr __y = __stackNext.back();
+    if(__y == 0) {
+      __stackNext.pop_back();
+      __stackActive.pop_back();
+      __stackKey.pop_back();
+      continue;
+    }
+    __stackNext.back() = _S_right(__y);
+    const size_t __i = __stackNext.size() - 1;
+
+    if(_S_edge(__y) == _S_b_trie_edge) {
+      const size_t __iFirst = __rgPairs.size();
+      for(typename _active_set::const_iterator __it = __stackActive[__i].begin(); 
+          __it != __stackActive[__i].end(); 
+          ++__it) {
+        for(_base_ptr __z = _S_left(__it->first); __z != 0 && _S_edge(__z) == _S_b_trie_edge; __z = _S_right(__z)) {
+          if(!__fSelf || __visited.find(__z) != __visited.end()) {
+            approximate_pair __pair;
+            __pair.first = const_iterator(__y);
+            __pair.second = const_iterator(__z);
+            __pair.distance = __it->second;
+            __rgPairs.push_back(__pair);
+          }
+        }
+      }
+      std::sort(__rgPairs.begin() + __iFirst, __rgPairs.end(), _approximate_pair_less(_M_key_compare));
+      if(__fSelf) {
+        __visited.insert(__y);
+      }
+      continue;
+    }
+
+    _active_set __SNext;
+    _M_join_step(__stackActive[__i], 
+                 (__i > 0) ? &__stackActive[__i - 1] : 0, 
+                 (__i > 0) ? &__stackKey[__i] : 0,
+                 _S_key(__y), __k, __SNext);
+    if(!__SNext.empty()) {
+      __stackNext.push_back(_S_left(__y));
+      __stackActive.push_back(_active_set());
+      __stackActive.back().swap(__SNext);
+      __stackKey.push_back(_S_key(__y));
+    }
+  }
+  return __rgPairs;
+}
+
+// The smallest distance any word below the current node can have. Every
+// alignment of a longer word passes through row i, or jumps over it with a
+// transposition from row i-1.
+TRIE_TEMPLATE 
+inline unsigned int
+B_TRIE::__subtrie_distance(const std::vector< std::vector<unsigned int> >& __DT, unsigned int __i) const
+{
+  assert(__DT.size() > __i);
+  unsigned int __d = *std::min_element(__DT[__i].begin(), __DT[__i].end());
+  if(__i > 0) {
+    unsigned int __dT = *std::min_element(__DT[__i-1].begin(), __DT[__i-1].end());
+    if(__dT != TRIE_INFINITY) {
+      __d = std::min<unsigned int>(__d, __dT + 1);
+    }
+  }
+  return __d;
+}
+
+// __n != 0 keeps only the __n best matches (see __weighted_candidate). Once 
+// there are __n of them the cutoff drops to the distance of the worst, and a 
+// subtrie is skipped when it cannot hold a closer word or an equally close 
+// but heavier one.
 TRIE_TEMPLATE 
 std::vector< typename B_TRIE::_key_link_type > 
-B_TRIE::__approximate_match(const key_type& __P, bool __fBestCase, unsigned int __k /*cutoff*/) const
+B_TRIE::__approximate_match(const key_type& __P, bool __fBestCase, unsigned int __k /*cutoff*/, size_type __n) const
 {
+  typedef __weighted_candidate<_key_link_type> _candidate;
+
   std::vector<_key_link_type>                __rgNodes;
+  std::vector<_candidate>                   __rgBest; // heap, worst candidate on top
+  size_t                                    __cVisited = 0;
   std::vector< _STD vector<unsigned int> >  __DT;
   std::vector<unsigned int>                 __rgCe, __rgCb;
   unsigned int __level = 0;
@@ -2067,6 +3784,11 @@ B_TRIE::__approximate_match(const key_type& __P, bool __fBestCase, unsigned int
     }
   
     while (__node != _M_header) {
+      // whichever way the walk goes next, its node is on its way while the
+      // edit distance of this one is worked out
+      __TRIE_PREFETCH(__node->_M_left);
+      __TRIE_PREFETCH(__node->_M_right);
+
       // we can only perform an edit_distance operation on keys
       if (_S_edge(__node) == _S_b_trie_non_edge) {
         assert(__node->_debugfIsEdge == false);
@@ -2193,18 +3915,44 @@ B_TRIE::__approximate_match(const key_type& __P, bool __fBestCase, unsigned int
         assert(__d==TRIE_INFINITY || __d > __k);
         __fFollowTrie = false;
       }
+      else if(__n != 0 && __rgBest.size() == __n && _S_edge(__node) == _S_b_trie_non_edge &&
+              __node->_M_weight <= __rgBest.front()._M_weight &&
+              __subtrie_distance(__DT, __level) >= __rgBest.front()._M_distance) {
+        // nothing below can displace the worst of the best
+        __fFollowTrie = false;
+      }
       else {
         // if we have a word (signaled by word end) whose edit distance is within cut off
         if(_S_edge(__node) == _S_b_trie_edge && __d <= __k) {
           assert(__node != NULL);
           assert(__node->_debugfIsEdge == true);
 
-          // has our cutoff changed?
-          if (__fBestCase && __d < __k) {
-            __k = __d;
-            __rgNodes.clear();
+          if(__n != 0) {
+            _candidate __c;
+            __c._M_distance = __d;
+            __c._M_weight = __value_weight<_Value>()(_S_value(__node));
+            __c._M_order = __cVisited++;
+            __c._M_node = __node;
+            if(__rgBest.size() < __n || __c < __rgBest.front()) {
+              __rgBest.push_back(__c);
+              std::push_heap(__rgBest.begin(), __rgBest.end());
+              if(__rgBest.size() > __n) {
+                std::pop_heap(__rgBest.begin(), __rgBest.end());
+                __rgBest.pop_back();
+              }
+              if(__rgBest.size() == __n) {
+                __k = __rgBest.front()._M_distance;
+              }
+            }
+          }
+          else {
+            // has our cutoff changed?
+            if (__fBestCase && __d < __k) {
+              __k = __d;
+              __rgNodes.clear();
+            }
+            __rgNodes.push_back(__node);
           }
-          __rgNodes.push_back(__node);
         }
         __fFollowTrie = true;
       }
@@ -2243,6 +3991,12 @@ B_TRIE::__approximate_match(const key_type& __P, bool __fBestCase, unsigned int
       }
     }  
   }
+  if(__n != 0) {
+    std::sort_heap(__rgBest.begin(), __rgBest.end());
+    for(typename std::vector<_candidate>::iterator __it = __rgBest.begin(); __it != __rgBest.end(); ++__it) {
+      __rgNodes.push_back(__it->_M_node);
+    }
+  }
   return __rgNodes;
 }
 
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * The characters used by a set of keys, numbered densely.
+ *
+ * A dictionary in one language uses a couple of hundred characters at most,
+ * so once they are known each can be given a small code (unsigned char or
+ * unsigned short) in place of a 32 bit gunichar. Codes are given in the
+ * order of _Compare, so keys of codes sort the same way as the keys they came
+ * from. A character that is not in the alphabet has the code unknown(), which
+ * is never given to a character, so _Code must hold one more value than
+ * there are characters: assign throws std::length_error when it cannot, and
+ * leaves the alphabet empty. Characters below 256 are looked up in a table,
+ * the rest by binary search.
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_TRIE_ALPHABET_H
+#define __INTERNAL_TRIE_ALPHABET_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cassert>
+
+namespace trie {
+
+template <class _SubKeyType, class _Code, class _Compare>
+class alphabet {
+public:
+  typedef _SubKeyType   sub_key_type;
+  typedef _Code         code_type;
+  typedef _Compare      key_compare;
+  typedef typename std::vector<_SubKeyType>::size_type size_type;
+
+  enum { _S_direct_size = 256 };
+
+private:
+  std::vector<_SubKeyType> _M_characters; // character of each code
+  std::vector<_Code>       _M_direct;     // code of each character below _S_direct_size
+  _Compare                 _M_key_compare;
+
+public:
+  alphabet() {}
+
+  explicit alphabet(const _Compare& __comp) : _M_key_compare(__comp) {}
+
+  // makes the alphabet of the characters in [__first, __last)
+  template <class _InputIterator>
+  void assign(_InputIterator __first, _InputIterator __last) {
+    _M_characters.assign(__first, __last);
+    std::sort(_M_characters.begin(), _M_characters.end(), _M_key_compare);
+    _M_characters.erase(std::unique(_M_characters.begin(), _M_characters.end(), _Equal(_M_key_compare)),
+                        _M_characters.end());
+    // the characters and unknown() must all have a code
+    if(_M_characters.size() > size_type(std::numeric_limits<_Code>::max())) {
+      clear();
+      throw std::length_error("trie::alphabet: too many characters for the code type");
+    }
+
+    _M_direct.assign(std::numeric_limits<_SubKeyType>::is_integer ? _S_direct_size : 0, unknown());
+    for(size_type __i = 0; __i != _M_characters.size(); ++__i) {
+      if(_S_is_direct(_M_characters[__i])) {
+        _M_direct[size_type(_M_characters[__i])] = _Code(__i);
+      }
+    }
+  }
+
+  void clear() { 
+    _M_characters.clear();
+    _M_direct.clear();
+  }
+
+  size_type size() const { return _M_characters.size(); }
+
+  // the code of characters not in the alphabet
+  _Code unknown() const { return _Code(_M_characters.size()); }
+
+  _Code encode(const _SubKeyType& __c) const {
+    if(_S_is_direct(__c) && !_M_direct.empty()) {
+      return _M_direct[size_type(__c)];
+    }
+    typename std::vector<_SubKeyType>::const_iterator __it =
+      std::lower_bound(_M_characters.begin(), _M_characters.end(), __c, _M_key_compare);
+    if(__it == _M_characters.end() || _M_key_compare(__c, *__it)) {
+      return unknown();
+    }
+    return _Code(__it - _M_characters.begin());
+  }
+
+  template <class _InputIterator, class _OutputIterator>
+  _OutputIterator encode(_InputIterator __first, _InputIterator __last, _OutputIterator __result) const {
+    for(; __first != __last; ++__first, ++__result) {
+      *__result = encode(*__first);
+    }
+    return __result;
+  }
+
+  const _SubKeyType& decode(_Code __code) const {
+    assert(__code < unknown());
+    return _M_characters[__code];
+  }
+
+private:
+  static bool _S_is_direct(const _SubKeyType& __c) {
+    return std::numeric_limits<_SubKeyType>::is_integer &&
+           !(__c < _SubKeyType(0)) && static_cast<unsigned long>(__c) < _S_direct_size;
+  }
+
+  struct _Equal {
+    _Compare _M_key_compare;
+    _Equal(const _Compare& __comp) : _M_key_compare(__comp) {}
+    bool operator()(const _SubKeyType& __a, const _SubKeyType& __b) const {
+      return !_M_key_compare(__a, __b) && !_M_key_compare(__b, __a);
+    }
+  };
+};
+
+} // namespace trie
+
+#endif /* __INTERNAL_TRIE_ALPHABET_H */
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 1998-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A multiset which keeps each key once, with the number of times it
+ * occurs.
+ *
+ * In a trie_multiset every occurrence of a key is a value node of its own
+ * among the children of the key's last sub key, so count and equal_range
+ * walk all of them, and a key which occurs a million times takes a million
+ * nodes; the keys below it are found only past them. Here a key is one
+ * value node holding its count: count is a lookup, inserting a key again
+ * adds one to its count, and erasing an occurrence takes one away.
+ *
+ * The iterators still visit a key as many times as it occurs, so the
+ * container reads as a multiset; count() on an iterator gives the number
+ * of occurrences of its key. The count is the weight of the key (see
+ * __value_weight), so weighted_find puts the most frequent keys first.
+ * for_each visits each key once, with its count.
+ */
+
+/* NOTE: This is an internal header file, included by other STL headers.
+ *   You should not attempt to use it directly.
+ */
+
+#pragma once
+
+#ifndef __TRIE_INTERNAL_COUNTED_MULTISET_H
+#define __TRIE_INTERNAL_COUNTED_MULTISET_H
+
+namespace trie {
+
+// Visits each occurrence of a key in turn: _M_node is the key and its count,
+// _M_i which of its occurrences.
+template <class _Key, class _NodeIterator>
+struct _counted_iterator {
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef _Key                            value_type;
+  typedef ptrdiff_t                       difference_type;
+  typedef const _Key*                     pointer;
+  typedef const _Key&                     reference;
+  typedef size_t                          size_type;
+
+  typedef _counted_iterator<_Key, _NodeIterator> _Self;
+
+  _NodeIterator _M_node;
+  size_type     _M_i;
+
+  _counted_iterator() : _M_i(0) {}
+  _counted_iterator(const _NodeIterator& __x, size_type __i = 0) : _M_node(__x), _M_i(__i) {}
+
+  reference operator*() const { return _M_node->first; }
+  pointer operator->() const { return &(operator*()); }
+
+  // the number of times the key occurs
+  size_type count() const { return _M_node->second; }
+
+  _Self& operator++() {
+    if(++_M_i == _M_node->second) {
+      ++_M_node;
+      _M_i = 0;
+    }
+    return *this;
+  }
+  _Self operator++(int) {
+    _Self __tmp = *this;
+    ++*this;
+    return __tmp;
+  }
+
+  _Self& operator--() {
+    if(_M_i == 0) {
+      --_M_node;
+      _M_i = _M_node->second - 1;
+    }
+    else {
+      --_M_i;
+    }
+    return *this;
+  }
+  _Self operator--(int) {
+    _Self __tmp = *this;
+    --*this;
+    return __tmp;
+  }
+
+  bool operator==(const _Self& __x) const { return _M_node == __x._M_node && _M_i == __x._M_i; }
+  bool operator!=(const _Self& __x) const { return !(*this == __x); }
+};
+
+
+#define TRIE_COUNTED_MULTISET trie_counted_multiset<_Key, _SubKeyType, _KeyIterator, _KeySizeType, _KeyBegin, _KeyEnd, _KeySize, _Compare, _Alloc>
+#define TRIE_COUNTED_MULTISET_TEMPLATE template <class _Key, class _SubKeyType, class _KeyIterator, class _KeySizeType, class _KeyBegin, class _KeyEnd, class _KeySize, class _Compare, class _Alloc>
+
+template <class _Key,
+          class _SubKeyType = _Key::value_type,
+          class _KeyIterator = _Key::const_iterator,
+          class _KeySizeType = _Key::size_type,
+          class _KeyBegin = __container_begin<typename _Key, typename _KeyIterator>,
+          class _KeyEnd = __container_end<typename _Key, typename _KeyIterator>,
+          class _KeySize = __container_size<typename _Key, typename _KeySizeType>,
+          class _Compare =std::less<typename _SubKeyType>,
+          class _Alloc = std::allocator<_Key> >
+class trie_counted_multiset {
+public:
+  // typedefs:
+
+  typedef _Key           key_type;
+  typedef _Key           value_type;
+  typedef _Compare       key_compare;
+  typedef _Compare       value_compare;
+
+  typedef _KeyIterator  key_iterator;
+  typedef _KeySizeType  key_size_type;
+  typedef _KeyBegin     key_begin;
+  typedef _KeyEnd       key_end;
+  typedef _KeySize      key_size;
+
+  typedef _SubKeyType    sub_key_type;
+
+  // a key and the number of times it occurs
+  typedef std::pair<const _Key, unsigned int> counted_type;
+
+private:
+  typedef _b_trie<key_type, counted_type, sub_key_type, _Select1st<counted_type>,
+        key_iterator, key_size_type, key_begin, key_end, key_size,
+        key_compare,
+        _Alloc> rep_type;
+
+  rep_type _M_t;     // each key once, with its count
+  size_t   _M_size;  // the sum of the counts
+public:
+  typedef const _Key*                                     pointer;
+  typedef const _Key*                                     const_pointer;
+  typedef const _Key&                                     reference;
+  typedef const _Key&                                     const_reference;
+  typedef _counted_iterator<_Key, typename rep_type::const_iterator> iterator;
+  typedef iterator                                        const_iterator;
+  typedef std::reverse_iterator<iterator>                 reverse_iterator;
+  typedef std::reverse_iterator<iterator>                 const_reverse_iterator;
+  typedef typename rep_type::size_type                    size_type;
+  typedef typename rep_type::difference_type              difference_type;
+  typedef typename rep_type::allocator_type	              allocator_type;
+
+  // allocation/deallocation
+
+  trie_counted_multiset()
+    : _M_t(key_compare(), allocator_type()), _M_size(0)
+  {}
+
+  explicit trie_counted_multiset(const key_compare& __comp,
+    const allocator_type& __a = allocator_type())
+    : _M_t(__comp, __a), _M_size(0)
+  {}
+
+  template <class _InputIterator>
+  trie_counted_multiset(_InputIterator __first, _InputIterator __last)
+    : _M_t(key_compare(), allocator_type()), _M_size(0)
+  { insert(__first, __last); }
+
+  trie_counted_multiset(const TRIE_COUNTED_MULTISET& __x) : _M_t(__x._M_t), _M_size(__x._M_size) {}
+  TRIE_COUNTED_MULTISET& operator=(const TRIE_COUNTED_MULTISET& __x) {
+    _M_t = __x._M_t;
+    _M_size = __x._M_size;
+    return *this;
+  }
+
+  // accessors:
+
+  key_compare key_comp() const { return _M_t.key_comp(); }
+  value_compare value_comp() const { return _M_t.key_comp(); }
+  allocator_type get_allocator() const { return _M_t.get_allocator(); }
+
+  iterator begin() const { return iterator(_M_t.begin()); }
+  iterator end() const { return iterator(_M_t.end()); }
+  reverse_iterator rbegin() const { return reverse_iterator(end()); }
+  reverse_iterator rend() const { return reverse_iterator(begin()); }
+  bool empty() const { return _M_size == 0; }
+  size_type size() const { return _M_size; }
+  size_type max_size() const { return _M_t.max_size(); }
+  // the number of different keys
+  size_type distinct_size() const { return _M_t.size(); }
+  void swap(TRIE_COUNTED_MULTISET& __x) {
+    _M_t.swap(__x._M_t);
+    std::swap(_M_size, __x._M_size);
+  }
+  // lays the nodes out next to each other for faster lookups; invalidates
+  // all iterators
+  void compact() { _M_t.compact(); }
+
+  // insert/erase
+  iterator insert(const value_type& __x) {
+    return insert(__x, 1);
+  }
+  // adds __n occurrences of __x; the iterator is to the first of them all,
+  // or is find(__x) when __n is 0, as a key is never kept with no count
+  iterator insert(const value_type& __x, size_type __n) {
+    if(__n == 0) {
+      return find(__x);
+    }
+    std::pair<typename rep_type::iterator, bool> __p = _M_t.insert_unique(counted_type(__x, 0));
+    __p.first->second += (unsigned int) __n;
+    _M_t.reweight(__p.first);
+    _M_size += __n;
+    return iterator(__p.first);
+  }
+  iterator insert(iterator, const value_type& __x) {
+    return insert(__x);
+  }
+  template <class _InputIterator>
+  void insert(_InputIterator __first, _InputIterator __last) {
+    for(; __first != __last; ++__first) {
+      insert(*__first);
+    }
+  }
+
+  // erases one occurrence
+  void erase(iterator __position) {
+    _M_erase(__position);
+  }
+  // erases every occurrence of __x
+  size_type erase(const key_type& __x) {
+    typename rep_type::iterator __it = _M_t.find(__x);
+    if(__it == _M_t.end()) {
+      return 0;
+    }
+    const size_type __n = __it->second;
+    _M_t.erase(__it);
+    _M_size -= __n;
+    return __n;
+  }
+  void erase(iterator __first, iterator __last) {
+    // erasing an occurrence moves the later ones of its key down by one,
+    // so count first and then erase at __first
+    for(size_type __n = std::distance(__first, __last); __n != 0; --__n) {
+      __first = _M_erase(__first);
+    }
+  }
+  void clear() {
+    _M_t.clear();
+    _M_size = 0;
+  }
+
+  // multiset operations:
+
+  iterator find(const key_type& __x) const {
+    return iterator(_M_t.find(__x));
+  }
+  size_type count(const key_type& __x) const {
+    typename rep_type::const_iterator __it = _M_t.find(__x);
+    return (__it == _M_t.end()) ? 0 : __it->second;
+  }
+  iterator lower_bound(const key_type& __x) const {
+    return iterator(_M_t.lower_bound(__x));
+  }
+  iterator upper_bound(const key_type& __x) const {
+    return iterator(_M_t.upper_bound(__x));
+  }
+  std::pair<iterator,iterator> equal_range(const key_type& __x) const {
+    typename rep_type::const_iterator __it = _M_t.find(__x);
+    if(__it == _M_t.end()) {
+      const iterator __j = lower_bound(__x);
+      return std::pair<iterator, iterator>(__j, __j);
+    }
+    typename rep_type::const_iterator __next = __it;
+    return std::pair<iterator, iterator>(iterator(__it), iterator(++__next));
+  }
+
+  // trie operations, each giving the first occurrence of the keys found:
+  std::vector<iterator> approximate_find(const key_type& __x, unsigned int __k=1) const
+  { return _S_iterators(_M_t.approximate_find(__x, __k)); }
+
+  std::vector<iterator> best_find(const key_type& __x, unsigned int __k=TRIE_INFINITY) const
+  { return _S_iterators(_M_t.best_find(__x, __k)); }
+
+  std::vector<iterator> weighted_find(const key_type& __x, unsigned int __k=1, size_type __n=0) const
+  { return _S_iterators(_M_t.weighted_find(__x, __k, __n)); }
+
+  std::vector<iterator> complete(const key_type& __x, size_type __n) const
+  { return _S_iterators(_M_t.complete(__x, __n)); }
+
+  // __f(first, last, counted) for every key, once, see _b_trie::for_each
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const { return _M_t.for_each(__f); }
+
+private:
+  // erases the occurrence at __position, giving the one after it
+  iterator _M_erase(iterator __position) {
+    typename rep_type::iterator __it(__position._M_node._M_node);
+    --_M_size;
+    if(--__it->second == 0) {
+      typename rep_type::const_iterator __next = __it;
+      ++__next;
+      _M_t.erase(__it);
+      return iterator(__next);
+    }
+    _M_t.reweight(__it);
+    if(__position._M_i == __it->second) {
+      return iterator(++__it);
+    }
+    return __position;
+  }
+
+  static std::vector<iterator> _S_iterators(const std::vector<typename rep_type::const_iterator>& __rgNodes) {
+    return std::vector<iterator>(__rgNodes.begin(), __rgNodes.end());
+  }
+};
+
+TRIE_COUNTED_MULTISET_TEMPLATE
+inline bool operator==(const TRIE_COUNTED_MULTISET& __x,
+                       const TRIE_COUNTED_MULTISET& __y) {
+  return __x.size() == __y.size() && std::equal(__x.begin(), __x.end(), __y.begin());
+}
+
+TRIE_COUNTED_MULTISET_TEMPLATE
+inline bool operator<(const TRIE_COUNTED_MULTISET& __x,
+                      const TRIE_COUNTED_MULTISET& __y) {
+  return std::lexicographical_compare(__x.begin(), __x.end(), __y.begin(), __y.end());
+}
+
+TRIE_COUNTED_MULTISET_TEMPLATE
+inline bool operator!=(const TRIE_COUNTED_MULTISET& __x,
+                       const TRIE_COUNTED_MULTISET& __y) {
+  return !(__x == __y);
+}
+
+TRIE_COUNTED_MULTISET_TEMPLATE
+inline void swap(TRIE_COUNTED_MULTISET& __x,
+                 TRIE_COUNTED_MULTISET& __y) {
+  __x.swap(__y);
+}
+
+} // namespace trie
+
+#endif /* __TRIE_INTERNAL_COUNTED_MULTISET_H */
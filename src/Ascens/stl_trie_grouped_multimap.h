@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 1998-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * A multimap which keeps each key once, with the values mapped to it
+ * together in one vector.
+ *
+ * In a trie_multimap every value is a node of its own among the children
+ * of its key's last sub key, so count and equal_range walk all of them and
+ * the keys below are found only past them. Here a key is one value node
+ * holding a std::vector of its values, in the order they were inserted:
+ * count is a lookup, equal_range gives the vector's range, and inserting
+ * another value for a key is a push_back.
+ *
+ * The iterators visit each key once, as a pair of the key and its vector
+ * (a group); equal_range and the value_iterators reach the values
+ * themselves.
+ */
+
+/* NOTE: This is an internal header file, included by other STL headers.
+ *   You should not attempt to use it directly.
+ */
+
+#pragma once
+
+#ifndef __TRIE_INTERNAL_GROUPED_MULTIMAP_H
+#define __TRIE_INTERNAL_GROUPED_MULTIMAP_H
+
+#include <vector>
+
+namespace trie {
+
+#define TRIE_GROUPED_MULTIMAP trie_grouped_multimap<_Key, _Type, _SubKeyType, _KeyIterator, _KeySizeType, _KeyBegin, _KeyEnd, _KeySize, _Compare, _Alloc>
+#define TRIE_GROUPED_MULTIMAP_TEMPLATE template <class _Key, class _Type, class _SubKeyType, class _KeyIterator, class _KeySizeType, class _KeyBegin, class _KeyEnd, class _KeySize, class _Compare, class _Alloc>
+
+template<class _Key,
+          class _Type,
+          class _SubKeyType = _Key::value_type,
+          class _KeyIterator = _Key::const_iterator,
+          class _KeySizeType = _Key::size_type,
+          class _KeyBegin = __container_begin<typename _Key, typename _KeyIterator>,
+          class _KeyEnd = __container_end<typename _Key, typename _KeyIterator>,
+          class _KeySize = __container_size<typename _Key, typename _KeySizeType>,
+          class _Compare = std::less<typename _SubKeyType>,
+          class _Alloc = std::allocator<_Type> >
+class trie_grouped_multimap {
+public:
+  // typedefs:
+
+  typedef _Key                    key_type;
+  typedef _Type                   data_type;
+  typedef _Type                   mapped_type;
+  typedef std::pair<const _Key, _Type> value_type;
+  typedef _Compare                key_compare;
+
+  typedef _KeyIterator  key_iterator;
+  typedef _KeySizeType  key_size_type;
+  typedef _KeyBegin     key_begin;
+  typedef _KeyEnd       key_end;
+  typedef _KeySize      key_size;
+
+  typedef _SubKeyType          sub_key_type;
+
+  // the values of a key, and a key with them
+  typedef std::vector<_Type>                      mapped_vector;
+  typedef std::pair<const _Key, mapped_vector>    group_type;
+  typedef typename mapped_vector::iterator        value_iterator;
+  typedef typename mapped_vector::const_iterator  const_value_iterator;
+
+private:
+  typedef _b_trie<key_type, group_type, sub_key_type, _Select1st<group_type>,
+        key_iterator, key_size_type, key_begin, key_end, key_size,
+        key_compare, _Alloc> rep_type;
+
+  rep_type      _M_t;      // each key once, with its values
+  size_t        _M_size;   // the number of values
+  mapped_vector _M_none;   // the (no) values of a key which is not there
+public:
+  typedef typename rep_type::pointer                  pointer;
+  typedef typename rep_type::const_pointer            const_pointer;
+  typedef typename rep_type::reference                reference;
+  typedef typename rep_type::const_reference          const_reference;
+  typedef typename rep_type::iterator                 iterator;
+  typedef typename rep_type::const_iterator           const_iterator;
+  typedef typename rep_type::reverse_iterator         reverse_iterator;
+  typedef typename rep_type::const_reverse_iterator   const_reverse_iterator;
+  typedef typename rep_type::size_type                size_type;
+  typedef typename rep_type::difference_type          difference_type;
+  typedef typename rep_type::allocator_type           allocator_type;
+
+  // allocation/deallocation
+
+  trie_grouped_multimap()
+    : _M_t(key_compare(), allocator_type()), _M_size(0)
+  {}
+
+  explicit trie_grouped_multimap(const key_compare& __comp,
+    const allocator_type& __a = allocator_type())
+    : _M_t(__comp, __a), _M_size(0)
+  {}
+
+  template <class _InputIterator>
+  trie_grouped_multimap(_InputIterator __first, _InputIterator __last)
+    : _M_t(key_compare(), allocator_type()), _M_size(0)
+  { insert(__first, __last); }
+
+  trie_grouped_multimap(const TRIE_GROUPED_MULTIMAP& __x) : _M_t(__x._M_t), _M_size(__x._M_size) {}
+  TRIE_GROUPED_MULTIMAP& operator=(const TRIE_GROUPED_MULTIMAP& __x) {
+    _M_t = __x._M_t;
+    _M_size = __x._M_size;
+    return *this;
+  }
+
+  // accessors:
+
+  key_compare key_comp() const { return _M_t.key_comp(); }
+  allocator_type get_allocator() const { return _M_t.get_allocator(); }
+
+  iterator begin() { return _M_t.begin(); }
+  const_iterator begin() const { return _M_t.begin(); }
+  iterator end() { return _M_t.end(); }
+  const_iterator end() const { return _M_t.end(); }
+  reverse_iterator rbegin() { return _M_t.rbegin(); }
+  const_reverse_iterator rbegin() const { return _M_t.rbegin(); }
+  reverse_iterator rend() { return _M_t.rend(); }
+  const_reverse_iterator rend() const { return _M_t.rend(); }
+  bool empty() const { return _M_size == 0; }
+  // the number of values
+  size_type size() const { return _M_size; }
+  size_type max_size() const { return _M_t.max_size(); }
+  // the number of keys, and so of groups
+  size_type distinct_size() const { return _M_t.size(); }
+  void swap(TRIE_GROUPED_MULTIMAP& __x) {
+    _M_t.swap(__x._M_t);
+    std::swap(_M_size, __x._M_size);
+  }
+  // lays the nodes out next to each other for faster lookups; invalidates
+  // all iterators
+  void compact() { _M_t.compact(); }
+
+  // insert/erase
+
+  // adds __x after the values already mapped to its key; the iterator is to
+  // the key's group
+  iterator insert(const value_type& __x) {
+    iterator __it = _M_t.insert_unique(group_type(__x.first, mapped_vector())).first;
+    __it->second.push_back(__x.second);
+    ++_M_size;
+    return __it;
+  }
+  iterator insert(iterator, const value_type& __x) {
+    return insert(__x);
+  }
+  template <class _InputIterator>
+  void insert(_InputIterator __first, _InputIterator __last) {
+    for(; __first != __last; ++__first) {
+      insert(*__first);
+    }
+  }
+
+  // erases a key with all its values
+  void erase(iterator __position) {
+    _M_size -= __position->second.size();
+    _M_t.erase(__position);
+  }
+  size_type erase(const key_type& __x) {
+    iterator __it = _M_t.find(__x);
+    if(__it == _M_t.end()) {
+      return 0;
+    }
+    const size_type __n = __it->second.size();
+    erase(__it);
+    return __n;
+  }
+  void erase(iterator __first, iterator __last) {
+    while(__first != __last) {
+      erase(__first++);
+    }
+  }
+  // erases one value of the group __position; the group goes with its last
+  // value
+  void erase(iterator __position, value_iterator __value) {
+    __position->second.erase(__value);
+    --_M_size;
+    if(__position->second.empty()) {
+      _M_t.erase(__position);
+    }
+  }
+  void clear() {
+    _M_t.clear();
+    _M_size = 0;
+  }
+
+  // multimap operations:
+
+  iterator find(const key_type& __x) { return _M_t.find(__x); }
+  const_iterator find(const key_type& __x) const { return _M_t.find(__x); }
+  size_type count(const key_type& __x) const {
+    const_iterator __it = _M_t.find(__x);
+    return (__it == _M_t.end()) ? 0 : __it->second.size();
+  }
+  iterator lower_bound(const key_type& __x) { return _M_t.lower_bound(__x); }
+  const_iterator lower_bound(const key_type& __x) const { return _M_t.lower_bound(__x); }
+  iterator upper_bound(const key_type& __x) { return _M_t.upper_bound(__x); }
+  const_iterator upper_bound(const key_type& __x) const { return _M_t.upper_bound(__x); }
+
+  // the values mapped to __x
+  std::pair<value_iterator, value_iterator> equal_range(const key_type& __x) {
+    iterator __it = _M_t.find(__x);
+    mapped_vector& __v = (__it == _M_t.end()) ? _M_none : __it->second;
+    return std::pair<value_iterator, value_iterator>(__v.begin(), __v.end());
+  }
+  std::pair<const_value_iterator, const_value_iterator> equal_range(const key_type& __x) const {
+    const_iterator __it = _M_t.find(__x);
+    const mapped_vector& __v = (__it == _M_t.end()) ? _M_none : __it->second;
+    return std::pair<const_value_iterator, const_value_iterator>(__v.begin(), __v.end());
+  }
+
+  // trie operations, each giving the groups of the keys found:
+  std::vector<iterator> approximate_find(const key_type& __x, unsigned int __k = 1)
+  { return _M_t.approximate_find(__x, __k); }
+  std::vector<const_iterator> approximate_find(const key_type& __x, unsigned int __k = 1) const
+  { return _M_t.approximate_find(__x, __k); }
+
+  std::vector<iterator> best_find(const key_type& __x, unsigned int __k = TRIE_INFINITY)
+  { return _M_t.best_find(__x, __k); }
+  std::vector<const_iterator> best_find(const key_type& __x, unsigned int __k = TRIE_INFINITY) const
+  { return _M_t.best_find(__x, __k); }
+
+  std::vector<iterator> complete(const key_type& __x, size_type __n)
+  { return _M_t.complete(__x, __n); }
+  std::vector<const_iterator> complete(const key_type& __x, size_type __n) const
+  { return _M_t.complete(__x, __n); }
+
+  // __f(first, last, group) for every key, see _b_trie::for_each
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) { return _M_t.for_each(__f); }
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const { return _M_t.for_each(__f); }
+};
+
+TRIE_GROUPED_MULTIMAP_TEMPLATE
+inline bool operator==(const TRIE_GROUPED_MULTIMAP& __x,
+                       const TRIE_GROUPED_MULTIMAP& __y) {
+  return __x.size() == __y.size() && __x.distinct_size() == __y.distinct_size()
+    && std::equal(__x.begin(), __x.end(), __y.begin());
+}
+
+TRIE_GROUPED_MULTIMAP_TEMPLATE
+inline bool operator<(const TRIE_GROUPED_MULTIMAP& __x,
+                      const TRIE_GROUPED_MULTIMAP& __y) {
+  return std::lexicographical_compare(__x.begin(), __x.end(), __y.begin(), __y.end());
+}
+
+TRIE_GROUPED_MULTIMAP_TEMPLATE
+inline bool operator!=(const TRIE_GROUPED_MULTIMAP& __x,
+                       const TRIE_GROUPED_MULTIMAP& __y) {
+  return !(__x == __y);
+}
+
+TRIE_GROUPED_MULTIMAP_TEMPLATE
+inline void swap(TRIE_GROUPED_MULTIMAP& __x,
+                 TRIE_GROUPED_MULTIMAP& __y) {
+  __x.swap(__y);
+}
+
+} // namespace trie
+
+#endif /* __TRIE_INTERNAL_GROUPED_MULTIMAP_H */
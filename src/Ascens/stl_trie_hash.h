@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 1997-2002
+ * Eric S. Albright
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Eric S. Albright makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * 64 bit hashes of keys, for the structures which hash the keys of a trie
+ * (stl_perfect_hash.h, stl_bloom_filter.h).
+ */
+
+#pragma once
+
+#ifndef __INTERNAL_TRIE_HASH_H
+#define __INTERNAL_TRIE_HASH_H
+
+namespace trie {
+
+// the finalizer of splitmix64, so every bit of the hash depends on every
+// bit of __x
+inline unsigned long long __hash_mix(unsigned long long __x) {
+  __x = (__x ^ (__x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  __x = (__x ^ (__x >> 27)) * 0x94D049BB133111EBULL;
+  return __x ^ (__x >> 31);
+}
+
+// FNV-1a over the characters of a key, mixed
+template <class _InputIterator>
+unsigned long long __hash_key(_InputIterator __itKey, const _InputIterator& __itKeyEnd) {
+  unsigned long long __h = 0xCBF29CE484222325ULL;
+  for(; __itKey != __itKeyEnd; ++__itKey) {
+    __h ^= (unsigned long long) *__itKey;
+    __h *= 0x100000001B3ULL;
+  }
+  return __hash_mix(__h);
+}
+
+} // namespace trie
+
+#endif /* __INTERNAL_TRIE_HASH_H */
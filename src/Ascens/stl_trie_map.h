@@ -194,6 +194,23 @@ public:
     return (*((insert(value_type(__k, data_type()))).first)).second;
   }
   void swap(TRIE_MAP& __x) { _M_t.swap(__x._M_t); }
+  // lays the nodes out next to each other for faster lookups; invalidates
+  // all iterators
+  void compact() { _M_t.compact(); }
+  size_type free_node_count() const { return _M_t.free_node_count(); }
+  size_type block_node_count() const { return _M_t.block_node_count(); }
+  // erasing by key compacts once this share of the nodes laid out by
+  // compact() are free; 0, the default, never does
+  double compact_threshold() const { return _M_t.compact_threshold(); }
+  void set_compact_threshold(double __r) { _M_t.set_compact_threshold(__r); }
+
+  // in place set operations, each one walk of both tries: merge moves the
+  // nodes of __x in and leaves it empty (values whose keys are already present are dropped)
+  void merge(TRIE_MAP& __x) { _M_t.merge_unique(__x._M_t); }
+  void intersect(const TRIE_MAP& __x) { _M_t.intersect(__x._M_t); }
+  void subtract(const TRIE_MAP& __x) { _M_t.subtract(__x._M_t); }
+  // one walk of both tries too, copying the values of __x in as merge would move them
+  void insert(const TRIE_MAP& __x) { _M_t.insert_unique(__x._M_t); }
 
   // insert/erase
   std::pair<iterator, bool> insert(const value_type& __x) { 
@@ -288,6 +305,9 @@ public:
   const_iterator find_if_prefix(const _InputIterator __begin, const _InputIterator __end) const { 
     return _M_t.find_if_prefix(__begin, __end); 
   }
+  std::vector<const_iterator> find_prefixes(const key_iterator& __begin, const key_iterator& __end) const { 
+    return _M_t.find_prefixes(__begin, __end); 
+  }
   template <class _InputIterator>
   size_type count(const _InputIterator __begin, const _InputIterator __end) const {
     return (_M_t.find(__begin, __end) == _M_t.end()) ? 0 : 1; 
@@ -336,6 +356,44 @@ public:
   std::vector<const_iterator> best_find(const key_type& __x, unsigned int __k = TRIE_INFINITY) const 
   { return _M_t.best_find(__x, __k); }
 
+  std::vector<iterator> weighted_find(const key_type& __x, unsigned int __k = 1, size_type __n = 0) 
+  { return _M_t.weighted_find(__x, __k, __n); }
+
+  std::vector<const_iterator> weighted_find(const key_type& __x, unsigned int __k = 1, size_type __n = 0) const 
+  { return _M_t.weighted_find(__x, __k, __n); }
+
+  std::vector<iterator> complete(const key_type& __x, size_type __n) 
+  { return _M_t.complete(__x, __n); }
+
+  std::vector<const_iterator> complete(const key_type& __x, size_type __n) const 
+  { return _M_t.complete(__x, __n); }
+
+  std::vector<iterator> pattern_find(const key_type& __pattern) 
+  { return _M_t.pattern_find(__pattern); }
+
+  std::vector<const_iterator> pattern_find(const key_type& __pattern) const 
+  { return _M_t.pattern_find(__pattern); }
+
+  // __f(first, last, value) for every value, see _b_trie::for_each
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) { return _M_t.for_each(__f); }
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const { return _M_t.for_each(__f); }
+
+  typedef typename rep_type::approximate_pair approximate_pair;
+  std::vector<approximate_pair> approximate_join(const trie_map& __x, unsigned int __k=1) const 
+  { return _M_t.approximate_join(__x._M_t, __k); }
+
+  size_type count_prefix(const key_type& __x) const { return _M_t.count_prefix(__x); }
+  size_type rank(const key_type& __x) const { return _M_t.rank(__x); }
+  iterator select(size_type __n) { return _M_t.select(__n); }
+  const_iterator select(size_type __n) const { return _M_t.select(__n); }
+  std::vector< std::pair<iterator, iterator> > partition(size_type __n) { return _M_t.partition(__n); }
+  std::vector< std::pair<const_iterator, const_iterator> > partition(size_type __n) const { return _M_t.partition(__n); }
+
+  // call after changing a mapped weight in place
+  void reweight(iterator __position) { _M_t.reweight(__position); }
+
 
 };
 
@@ -386,6 +444,28 @@ inline void swap(TRIE_MAP& x, TRIE_MAP& y) {
 
 #endif //__STL_FUNCTION_TMPL_PARTIAL_ORDER
 
+// set operations giving a new trie
+TRIE_MAP_TEMPLATE
+inline TRIE_MAP set_union(const TRIE_MAP& __x, const TRIE_MAP& __y) {
+  TRIE_MAP __r(__x);
+  __r.insert(__y);
+  return __r;
+}
+
+TRIE_MAP_TEMPLATE
+inline TRIE_MAP set_intersection(const TRIE_MAP& __x, const TRIE_MAP& __y) {
+  TRIE_MAP __r(__x);
+  __r.intersect(__y);
+  return __r;
+}
+
+TRIE_MAP_TEMPLATE
+inline TRIE_MAP set_difference(const TRIE_MAP& __x, const TRIE_MAP& __y) {
+  TRIE_MAP __r(__x);
+  __r.subtract(__y);
+  return __r;
+}
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1174
 #pragma reset woff 1375
@@ -185,6 +185,23 @@ public:
   size_type size() const { return t.size(); }
   size_type max_size() const { return t.max_size(); }
   void swap(TRIE_MULTISET& x) { t.swap(x.t); }
+  // lays the nodes out next to each other for faster lookups; invalidates
+  // all iterators
+  void compact() { t.compact(); }
+  size_type free_node_count() const { return t.free_node_count(); }
+  size_type block_node_count() const { return t.block_node_count(); }
+  // erasing by key compacts once this share of the nodes laid out by
+  // compact() are free; 0, the default, never does
+  double compact_threshold() const { return t.compact_threshold(); }
+  void set_compact_threshold(double r) { t.set_compact_threshold(r); }
+
+  // in place set operations, each one walk of both tries: merge moves the
+  // nodes of x in and leaves it empty (every value is kept)
+  void merge(TRIE_MULTISET& x) { t.merge_equal(x.t); }
+  void intersect(const TRIE_MULTISET& x) { t.intersect(x.t); }
+  void subtract(const TRIE_MULTISET& x) { t.subtract(x.t); }
+  // one walk of both tries too, copying the values of x in as merge would move them
+  void insert(const TRIE_MULTISET& x) { t.insert_equal(x.t); }
 
   // insert/erase
   iterator insert(const value_type& x) { 
@@ -256,6 +273,9 @@ public:
   iterator find_if_prefix(const key_iterator& __begin, const key_iterator& __end) const { 
     return t.find_if_prefix(__begin, __end); 
   }
+  std::vector<const_iterator> find_prefixes(const key_iterator& __begin, const key_iterator& __end) const { 
+    return t.find_prefixes(__begin, __end); 
+  }
   size_type count(const key_iterator& __begin, const key_iterator& __end) const { 
     return t.count(__begin, __end); 
   }
@@ -285,6 +305,28 @@ public:
 
   std::vector<iterator> best_find(const key_type& x, unsigned int __k=TRIE_INFINITY) const 
   { return t.best_find(x, __k); }
+
+  std::vector<iterator> weighted_find(const key_type& x, unsigned int __k=1, size_type __n=0) const 
+  { return t.weighted_find(x, __k, __n); }
+
+  std::vector<iterator> complete(const key_type& x, size_type __n) const 
+  { return t.complete(x, __n); }
+
+  std::vector<iterator> pattern_find(const key_type& __pattern) const 
+  { return t.pattern_find(__pattern); }
+
+  // __f(first, last, value) for every value, see _b_trie::for_each
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const { return t.for_each(__f); }
+
+  typedef typename rep_type::approximate_pair approximate_pair;
+  std::vector<approximate_pair> approximate_join(const trie_multiset& x, unsigned int __k=1) const 
+  { return t.approximate_join(x.t, __k); }
+
+  size_type count_prefix(const key_type& x) const { return t.count_prefix(x); }
+  size_type rank(const key_type& x) const { return t.rank(x); }
+  iterator select(size_type __n) const { return t.select(__n); }
+  std::vector< std::pair<iterator, iterator> > partition(size_type __n) const { return t.partition(__n); }
   
 };
 
@@ -338,6 +380,28 @@ inline void swap(TRIE_MULTISET& x,
 
 #endif // __STL_FUNCTION_TMPL_PARTIAL_ORDER
 
+// set operations giving a new trie
+TRIE_MULTISET_TEMPLATE
+inline TRIE_MULTISET set_union(const TRIE_MULTISET& __x, const TRIE_MULTISET& __y) {
+  TRIE_MULTISET __r(__x);
+  __r.insert(__y);
+  return __r;
+}
+
+TRIE_MULTISET_TEMPLATE
+inline TRIE_MULTISET set_intersection(const TRIE_MULTISET& __x, const TRIE_MULTISET& __y) {
+  TRIE_MULTISET __r(__x);
+  __r.intersect(__y);
+  return __r;
+}
+
+TRIE_MULTISET_TEMPLATE
+inline TRIE_MULTISET set_difference(const TRIE_MULTISET& __x, const TRIE_MULTISET& __y) {
+  TRIE_MULTISET __r(__x);
+  __r.subtract(__y);
+  return __r;
+}
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1174
 #pragma reset woff 1375
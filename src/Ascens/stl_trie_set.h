@@ -186,6 +186,23 @@ public:
   size_type size() const { return _M_t.size(); }
   size_type max_size() const { return _M_t.max_size(); }
   void swap(TRIE_SET& __x) { _M_t.swap(__x._M_t); }
+  // lays the nodes out next to each other for faster lookups; invalidates
+  // all iterators
+  void compact() { _M_t.compact(); }
+  size_type free_node_count() const { return _M_t.free_node_count(); }
+  size_type block_node_count() const { return _M_t.block_node_count(); }
+  // erasing by key compacts once this share of the nodes laid out by
+  // compact() are free; 0, the default, never does
+  double compact_threshold() const { return _M_t.compact_threshold(); }
+  void set_compact_threshold(double __r) { _M_t.set_compact_threshold(__r); }
+
+  // in place set operations, each one walk of both tries: merge moves the
+  // nodes of __x in and leaves it empty (values whose keys are already present are dropped)
+  void merge(TRIE_SET& __x) { _M_t.merge_unique(__x._M_t); }
+  void intersect(const TRIE_SET& __x) { _M_t.intersect(__x._M_t); }
+  void subtract(const TRIE_SET& __x) { _M_t.subtract(__x._M_t); }
+  // one walk of both tries too, copying the values of __x in as merge would move them
+  void insert(const TRIE_SET& __x) { _M_t.insert_unique(__x._M_t); }
 
   // insert/erase
   std::pair<iterator, bool> insert(const value_type& __x) { 
@@ -255,6 +272,9 @@ public:
   iterator find_if_prefix(const key_iterator& __begin, const key_iterator& __end) const { 
     return _M_t.find_if_prefix(__begin, __end); 
   }
+  std::vector<const_iterator> find_prefixes(const key_iterator& __begin, const key_iterator& __end) const { 
+    return _M_t.find_prefixes(__begin, __end); 
+  }
   size_type count(const key_iterator& __begin, const key_iterator& __end) const {
     return (_M_t.find(__begin, __end) == _M_t.end()) ? 0 : 1; 
   }
@@ -284,6 +304,28 @@ public:
 
   std::vector<iterator> best_find(const key_type& __x, unsigned int k=TRIE_INFINITY) const 
   { return _M_t.best_find(__x, k); }
+
+  std::vector<iterator> weighted_find(const key_type& __x, unsigned int k=1, size_type n=0) const 
+  { return _M_t.weighted_find(__x, k, n); }
+
+  std::vector<iterator> complete(const key_type& __x, size_type n) const 
+  { return _M_t.complete(__x, n); }
+
+  std::vector<iterator> pattern_find(const key_type& __pattern) const 
+  { return _M_t.pattern_find(__pattern); }
+
+  // __f(first, last, value) for every value, see _b_trie::for_each
+  template <class _Visitor>
+  _Visitor for_each(_Visitor __f) const { return _M_t.for_each(__f); }
+
+  typedef typename rep_type::approximate_pair approximate_pair;
+  std::vector<approximate_pair> approximate_join(const trie_set& __x, unsigned int __k=1) const 
+  { return _M_t.approximate_join(__x._M_t, __k); }
+
+  size_type count_prefix(const key_type& __x) const { return _M_t.count_prefix(__x); }
+  size_type rank(const key_type& __x) const { return _M_t.rank(__x); }
+  iterator select(size_type n) const { return _M_t.select(n); }
+  std::vector< std::pair<iterator, iterator> > partition(size_type n) const { return _M_t.partition(n); }
  
 };
 
@@ -332,6 +374,28 @@ inline void swap(TRIE_SET& __x, TRIE_SET& __y) {
 
 #endif //__STL_FUNCTION_TMPL_PARTIAL_ORDER
 
+// set operations giving a new trie
+TRIE_SET_TEMPLATE
+inline TRIE_SET set_union(const TRIE_SET& __x, const TRIE_SET& __y) {
+  TRIE_SET __r(__x);
+  __r.insert(__y);
+  return __r;
+}
+
+TRIE_SET_TEMPLATE
+inline TRIE_SET set_intersection(const TRIE_SET& __x, const TRIE_SET& __y) {
+  TRIE_SET __r(__x);
+  __r.intersect(__y);
+  return __r;
+}
+
+TRIE_SET_TEMPLATE
+inline TRIE_SET set_difference(const TRIE_SET& __x, const TRIE_SET& __y) {
+  TRIE_SET __r(__x);
+  __r.subtract(__y);
+  return __r;
+}
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1174
 #pragma reset woff 1375